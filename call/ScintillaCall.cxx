@@ -3270,6 +3270,82 @@ void ScintillaCall::SetDragDropEnabled(bool dragDropEnabled) {
 	Call(Message::SetDragDropEnabled, dragDropEnabled);
 }
 
+void ScintillaCall::SetFrameTraceCapacity(int capacity) {
+	Call(Message::SetFrameTraceCapacity, capacity);
+}
+
+int ScintillaCall::FrameTraceCapacity() {
+	return static_cast<int>(Call(Message::GetFrameTraceCapacity));
+}
+
+int ScintillaCall::FrameTraceCount(Scintilla::FrameTraceSpan span) {
+	return static_cast<int>(Call(Message::GetFrameTraceCount, static_cast<uintptr_t>(span)));
+}
+
+Position ScintillaCall::FrameTraceDuration(Scintilla::FrameTraceSpan span) {
+	return Call(Message::GetFrameTraceDuration, static_cast<uintptr_t>(span));
+}
+
+int ScintillaCall::PositionCacheHitRate() {
+	return static_cast<int>(Call(Message::GetPositionCacheHitRate));
+}
+
+Position ScintillaCall::FrameTrace(char *json) {
+	return CallPointer(Message::GetFrameTrace, 0, json);
+}
+
+std::string ScintillaCall::FrameTrace() {
+	return CallReturnString(Message::GetFrameTrace, 0);
+}
+
+void ScintillaCall::SetLineBitmapCache(int kiloBytes) {
+	Call(Message::SetLineBitmapCache, kiloBytes);
+}
+
+int ScintillaCall::LineBitmapCache() {
+	return static_cast<int>(Call(Message::GetLineBitmapCache));
+}
+
+void ScintillaCall::SetUndoSpillThreshold(Position bytes) {
+	Call(Message::SetUndoSpillThreshold, bytes);
+}
+
+Position ScintillaCall::UndoSpillThreshold() {
+	return Call(Message::GetUndoSpillThreshold);
+}
+
+Position ScintillaCall::UndoHistoryData(char *data) {
+	return CallPointer(Message::GetUndoHistoryData, 0, data);
+}
+
+std::string ScintillaCall::UndoHistoryData() {
+	return CallReturnString(Message::GetUndoHistoryData, 0);
+}
+
+void ScintillaCall::SetUndoHistoryData(Position length, const char *data) {
+	CallString(Message::SetUndoHistoryData, length, data);
+}
+
+void ScintillaCall::SetUndoMemoryLimit(Position bytes) {
+	Call(Message::SetUndoMemoryLimit, bytes);
+}
+
+Position ScintillaCall::UndoMemoryLimit() {
+	return Call(Message::GetUndoMemoryLimit);
+}
+
+void ScintillaCall::SetUndoActionLimit(int actions) {
+	Call(Message::SetUndoActionLimit, actions);
+}
+
+int ScintillaCall::UndoActionLimit() {
+	return static_cast<int>(Call(Message::GetUndoActionLimit));
+}
+
+Position ScintillaCall::UndoMemoryUsage() {
+	return Call(Message::GetUndoMemoryUsage);
+}
+
 void ScintillaCall::StartRecord() {
 	Call(Message::StartRecord);
 }
@@ -12,6 +12,8 @@ namespace Scintilla {
 
 enum {
 	dvRelease4 = 2,
+	dvSegments = 3,
+	dvStyleRuns = 4,
 };
 
 // moved from CharClassify.h
@@ -46,8 +48,32 @@ public:
 	virtual CharacterClass SCI_METHOD GetCharacterClass(unsigned int character) const noexcept = 0;
 };
 
+// Available when Version() >= dvSegments.
+// Text is returned as the two parts either side of the gap, segment2 is offset so both are
+// indexed by document position, followed by a zero sentinel. Pointers stay valid until
+// the text is modified or the gap is moved, which does not happen while lexing or folding.
+class IDocumentSegments : public IDocument {
+public:
+	virtual void SCI_METHOD GetSegments(const char **segment1, Sci_Position *length1, const char **segment2) const noexcept = 0;
+};
+
+struct StyleRun {
+	Sci_Position length;
+	unsigned char style;
+};
+
+// Available when Version() >= dvStyleRuns.
+// Same as calling SetStyleFor() for each run, with at most one modification notification.
+class IDocumentStyleRuns : public IDocumentSegments {
+public:
+	virtual bool SCI_METHOD SetStyleRuns(Sci_Position count, const StyleRun *runs) = 0;
+};
+
 enum {
 	lvRelease5 = 3,
+	// Lex restarts at any line start from the line state and style before it without reading
+	// earlier text, so styling after an edit may stop once both match their old values.
+	lvLineResume = 4,
 };
 
 class ILexer5 {
@@ -1177,6 +1177,30 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_INDEXPOSITIONFROMLINE 2714
 #define SCI_GETDRAGDROPENABLED 2818
 #define SCI_SETDRAGDROPENABLED 2819
+#define SC_FRAMETRACE_PAINT 0
+#define SC_FRAMETRACE_PAINTTEXT 1
+#define SC_FRAMETRACE_LAYOUTLINE 2
+#define SC_FRAMETRACE_WRAPLINES 3
+#define SC_FRAMETRACE_COLOURISE 4
+#define SC_FRAMETRACE_POSITIONCACHE 5
+#define SC_FRAMETRACE_FOLD 6
+#define SCI_SETFRAMETRACECAPACITY 2820
+#define SCI_GETFRAMETRACECAPACITY 2821
+#define SCI_GETFRAMETRACECOUNT 2822
+#define SCI_GETFRAMETRACEDURATION 2823
+#define SCI_GETPOSITIONCACHEHITRATE 2824
+#define SCI_GETFRAMETRACE 2825
+#define SCI_SETLINEBITMAPCACHE 2826
+#define SCI_GETLINEBITMAPCACHE 2827
+#define SCI_SETUNDOSPILLTHRESHOLD 2828
+#define SCI_GETUNDOSPILLTHRESHOLD 2829
+#define SCI_GETUNDOHISTORYDATA 2830
+#define SCI_SETUNDOHISTORYDATA 2831
+#define SCI_SETUNDOMEMORYLIMIT 2832
+#define SCI_GETUNDOMEMORYLIMIT 2833
+#define SCI_SETUNDOACTIONLIMIT 2834
+#define SCI_GETUNDOACTIONLIMIT 2835
+#define SCI_GETUNDOMEMORYUSAGE 2836
 #define SCI_STARTRECORD 3001
 #define SCI_STOPRECORD 3002
 #define SCI_SETLEXER 4001
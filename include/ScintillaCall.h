@@ -864,6 +864,25 @@ public:
 	Position IndexPositionFromLine(Line line, Scintilla::LineCharacterIndexType lineCharacterIndex);
 	bool DragDropEnabled();
 	void SetDragDropEnabled(bool dragDropEnabled);
+	void SetFrameTraceCapacity(int capacity);
+	int FrameTraceCapacity();
+	int FrameTraceCount(Scintilla::FrameTraceSpan span);
+	Position FrameTraceDuration(Scintilla::FrameTraceSpan span);
+	int PositionCacheHitRate();
+	Position FrameTrace(char *json);
+	std::string FrameTrace();
+	void SetLineBitmapCache(int kiloBytes);
+	int LineBitmapCache();
+	void SetUndoSpillThreshold(Position bytes);
+	Position UndoSpillThreshold();
+	Position UndoHistoryData(char *data);
+	std::string UndoHistoryData();
+	void SetUndoHistoryData(Position length, const char *data);
+	void SetUndoMemoryLimit(Position bytes);
+	Position UndoMemoryLimit();
+	void SetUndoActionLimit(int actions);
+	int UndoActionLimit();
+	Position UndoMemoryUsage();
 	void StartRecord();
 	void StopRecord();
 	void SetLexer(int lexer);
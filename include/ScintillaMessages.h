@@ -771,6 +771,23 @@ enum class Message {
 	IndexPositionFromLine = 2714,
 	GetDragDropEnabled = 2818,
 	SetDragDropEnabled = 2819,
+	SetFrameTraceCapacity = 2820,
+	GetFrameTraceCapacity = 2821,
+	GetFrameTraceCount = 2822,
+	GetFrameTraceDuration = 2823,
+	GetPositionCacheHitRate = 2824,
+	GetFrameTrace = 2825,
+	SetLineBitmapCache = 2826,
+	GetLineBitmapCache = 2827,
+	SetUndoSpillThreshold = 2828,
+	GetUndoSpillThreshold = 2829,
+	GetUndoHistoryData = 2830,
+	SetUndoHistoryData = 2831,
+	SetUndoMemoryLimit = 2832,
+	GetUndoMemoryLimit = 2833,
+	SetUndoActionLimit = 2834,
+	GetUndoActionLimit = 2835,
+	GetUndoMemoryUsage = 2836,
 	StartRecord = 3001,
 	StopRecord = 3002,
 	SetLexer = 4001,
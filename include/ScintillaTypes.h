@@ -580,6 +580,16 @@ enum class LineCharacterIndexType {
 	Utf16 = 2,
 };
 
+enum class FrameTraceSpan {
+	Paint = 0,
+	PaintText = 1,
+	LayoutLine = 2,
+	WrapLines = 3,
+	Colourise = 4,
+	PositionCache = 5,
+	Fold = 6,
+};
+
 enum class TypeProperty {
 	Boolean = 0,
 	Integer = 1,
@@ -243,32 +243,36 @@ inline bool ScanHotKey(const StyleContext &sc, LexAccessor &styler, Sci_Position
 	int count = 1;
 	int modifier = 1;
 	// TODO: improve this code
+	bool result = false;
 	Sci_PositionU pos = sc.currentPos;
-	while (pos < sc.lineStartNext) {
+	const Sci_PositionU endPos = sci::min<Sci_PositionU>(sc.lineStartNext, styler.LookAheadLimit(pos));
+	while (pos < endPos) {
 		const char ch = styler[pos++];
 		if (ch < ' ' || ch >= '\x7f') {
-			return false;
+			break;
 		}
 		if (ch == ' ') {
 			if (!(chPrev == ' ' || chPrev == '&')) {
 				++modifier;
 				if (modifier == 3) {
-					return false;
+					break;
 				}
 			}
 		} else if (ch == '&') {
 			modifier = 1;
 			++count;
 			if (count == 3) {
-				return false;
+				break;
 			}
 		} else if (ch == ':' && chPrev == ':') {
 			length = pos - sc.currentPos;
-			return true;
+			result = true;
+			break;
 		}
 		chPrev = ch;
 	}
-	return false;
+	styler.ChargeLook(pos - sc.currentPos);
+	return result;
 }
 
 void ColouriseAHKDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, LexerWordList keywordLists, Accessor &styler) {
@@ -11,6 +11,8 @@
 
 #include <string>
 #include <string_view>
+#include <vector>
+#include <algorithm>
 
 #include "ILexer.h"
 #include "Scintilla.h"
@@ -23,6 +25,7 @@
 #include "CharacterSet.h"
 #include "StringUtils.h"
 #include "LexerModule.h"
+#include "LexerCheckpoints.h"
 
 using namespace Lexilla;
 
@@ -112,16 +115,18 @@ int GlobScan(const StyleContext &sc) noexcept {
 	int sLen = 0;
 	int pCount = 0;
 	int hash = 0;
+	int result = 0;
 	Sci_Position pos = sc.currentPos;
-	while (true) {
+	const Sci_Position limit = sc.styler.LookAheadLimit(pos);
+	while (pos < limit) {
 		++sLen;
 		const uint8_t c = sc.styler[++pos];
 		if (c <= ' ') {
-			return 0;
+			break;
 		}
 		if (c == '\'' || c == '\"') {
 			if (hash != 2) {
-				return 0;
+				break;
 			}
 		} else if (c == '#' && hash == 0) {
 			hash = (sLen == 1) ? 2 : 1;
@@ -130,14 +135,15 @@ int GlobScan(const StyleContext &sc) noexcept {
 		} else if (c == ')') {
 			if (pCount == 0) {
 				if (hash) {
-					return sLen;
+					result = sLen;
 				}
-				return 0;
+				break;
 			}
 			pCount--;
 		}
 	}
-	return 0;
+	sc.styler.ChargeLook(sLen);
+	return result;
 }
 
 constexpr bool IsBashWordChar(int ch) noexcept {
@@ -420,7 +426,8 @@ void ColouriseBashDoc(Sci_PositionU startPos, Sci_Position length, int initStyle
 	QuoteStack.dialect = static_cast<ShellDialect>(styler.GetPropertyInt("lexer.lang"));
 	// Always backtracks to the start of a line that is not a continuation
 	// of the previous line (i.e. start of a bash command segment)
-	Sci_Line ln = styler.GetLine(startPos);
+	const Sci_Line lineCurrent = styler.GetLine(startPos);
+	Sci_Line ln = lineCurrent;
 	while (ln != 0) {
 		ln--;
 		if (ln == 0 || styler.GetLineState(ln) == static_cast<int>(CmdState::Start)) {
@@ -429,11 +436,33 @@ void ColouriseBashDoc(Sci_PositionU startPos, Sci_Position length, int initStyle
 	}
 	initStyle = SCE_SH_DEFAULT;
 	startPos = styler.LineStart(ln);
+	// or resume from nearest checkpoint inside here-doc or nested quotes.
+	LexerCheckpoints * const checkpoints = styler.Checkpoints();
+	if (checkpoints && ln != lineCurrent) {
+		const LexerCheckpoints::Checkpoint *checkpoint = checkpoints->Find(startPos + 1, styler.LineStart(lineCurrent) - 1);
+		if (checkpoint) {
+			startPos = checkpoint->position;
+			const int *values = checkpoint->values.data();
+			initStyle = values[0];
+			cmdState = static_cast<CmdState>(values[1]);
+			numBase = values[2];
+			values = LexerCheckpoints::Restore(values + 3, HereDoc);
+			LexerCheckpoints::Restore(values, QuoteStack);
+		}
+	}
+	std::vector<int> checkpointValues;
 	StyleContext sc(startPos, endPos - startPos, initStyle, styler);
 
 	while (sc.More()) {
 		// handle line continuation, updates per-line stored state
 		if (sc.atLineStart) {
+			if (checkpoints && (StyleForceBacktrack(sc.state) || !QuoteStack.Empty())
+				&& sc.currentLine % LexerCheckpoints::Interval == 0) {
+				checkpointValues.assign({sc.state, static_cast<int>(cmdState), numBase});
+				LexerCheckpoints::Append(checkpointValues, HereDoc);
+				LexerCheckpoints::Append(checkpointValues, QuoteStack);
+				checkpoints->Save(sc.currentPos, checkpointValues);
+			}
 			CmdState state = CmdState::Body;	// force backtrack while retaining cmdState
 			if (!StyleForceBacktrack(sc.state)) {
 				// retain last line's state
@@ -67,6 +67,11 @@ constexpr bool IsSpaceEquiv(int state) noexcept {
 	return (state < SCE_C_IDENTIFIER);
 }
 
+constexpr unsigned CppCharClass_Word = 1;
+constexpr ByteClassTable kCppCharClass = MakeByteClassTable([](int ch) constexpr noexcept {
+	return iswordstart(ch) ? CppCharClass_Word : 0;
+});
+
 /*const char* const cppWordLists[] = {
 	"Primary keywords",		// SCE_C_WORD
 	"Type keywords",		// SCE_C_WORD2
@@ -702,6 +707,40 @@ void ColouriseCppDoc(Sci_PositionU startPos, Sci_Position length, int initStyle,
 		}
 		continuationLine = false;
 		sc.Forward();
+
+		// Skip bytes that can not change state in bulk.
+		if (!sc.atLineStart) {
+			const Sci_PositionU startPos = sc.currentPos;
+			switch (sc.state) {
+			case SCE_C_COMMENT:
+				sc.ForwardUntil('*', '\\');
+				break;
+			case SCE_C_COMMENTLINE:
+				sc.ForwardUntil('\\', '\\');
+				break;
+			case SCE_C_CHARACTER:
+			case SCE_C_STRING:
+				if (!isIncludePreprocessor) {
+					sc.ForwardUntil((sc.state == SCE_C_CHARACTER) ? '\'' : '\"', '\\');
+					if (sc.currentPos != startPos) {
+						// visibleChars is only compared with zero or identifier length
+						const int chPrev = LexGetPrevChar(styler, startPos, sc.currentPos);
+						if (chPrev != '\0') {
+							visibleChars += static_cast<int>(sc.currentPos - startPos);
+							chPrevNonWhite = chPrev;
+						}
+					}
+				}
+				break;
+			case SCE_C_IDENTIFIER:
+				sc.ForwardWhile(kCppCharClass, CppCharClass_Word);
+				if (sc.currentPos != startPos) {
+					visibleChars += static_cast<int>(sc.currentPos - startPos);
+					chPrevNonWhite = sc.chPrev;
+				}
+				break;
+			}
+		}
 	}
 
 	sc.Complete();
@@ -732,9 +771,11 @@ bool Lexilla::IsCppInDefine(LexAccessor &styler, Sci_Position currentPos) noexce
 		if (pos < currentPos)
 			return true;
 	}
+	const Sci_Line lineLimit = styler.GetLine(styler.LookBehindLimit(currentPos));
 	line--;
-	while (line > 0 && IsBackslashLine(styler, line) && !IsCppDefineLine(styler, line, pos))
+	while (line > lineLimit && IsBackslashLine(styler, line) && !IsCppDefineLine(styler, line, pos))
 		line--;
+	styler.ChargeLook(currentPos - styler.LineStart(line + 1));
 	if (line >= 0 && IsCppDefineLine(styler, line, pos) && IsBackslashLine(styler, line)) {
 		return true;
 	}
@@ -370,4 +370,4 @@ void ColouriseErlangDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int init
 
 }
 
-extern const LexerModule lmErlang(SCLEX_ERLANG, ColouriseErlangDoc, "erlang", FoldPyDoc);
+extern const LexerModule lmErlang(SCLEX_ERLANG, ColouriseErlangDoc, "erlang", FoldPyDoc, true);
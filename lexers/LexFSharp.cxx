@@ -446,7 +446,9 @@ void ColouriseFSharpDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int init
 					}
 				} else if (sc.chNext == '$') {
 					const int interpolatorCount = GetMatchedDelimiterCount(styler, sc.currentPos + 1, '$') + 1;
-					sc.Advance(interpolatorCount);
+					// the run may end at document end
+					sc.Advance(interpolatorCount - 1);
+					sc.Forward();
 					if (sc.Match('\"', '\"', '\"')) {
 						stringInterpolatorCount = interpolatorCount;
 						sc.ChangeState(SCE_FSHARP_INTERPOLATED_TRIPLE_STRING);
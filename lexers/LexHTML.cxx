@@ -10,6 +10,8 @@
 
 #include <string>
 #include <string_view>
+#include <vector>
+#include <algorithm>
 
 #include "ILexer.h"
 #include "Scintilla.h"
@@ -22,6 +24,7 @@
 #include "CharacterSet.h"
 #include "StringUtils.h"
 #include "LexerModule.h"
+#include "LexerCheckpoints.h"
 #include "DocUtils.h"
 
 using namespace Lexilla;
@@ -328,6 +331,7 @@ void ColouriseHyperTextDoc(Sci_PositionU startPos, Sci_Position length, int init
 	int state = stateForPrintState(StateToPrint);
 
 	// If inside a tag, it may be a script tag, so reread from the start of line starting tag to ensure any language tags are seen
+	const Sci_PositionU lineStartPos = startPos;
 	if (InTagState(state)) {
 		while (startPos != 0) {
 			state = styler.StyleIndexAt(startPos - 1);
@@ -424,10 +428,47 @@ void ColouriseHyperTextDoc(Sci_PositionU startPos, Sci_Position length, int init
 		}
 	}
 
+	// or resume from nearest checkpoint inside the tag.
+	LexerCheckpoints * const checkpoints = styler.Checkpoints();
+	if (checkpoints && startPos < lineStartPos) {
+		const LexerCheckpoints::Checkpoint *checkpoint = checkpoints->Find(startPos + 1, lineStartPos - 1);
+		if (checkpoint) {
+			length -= checkpoint->position - startPos;
+			startPos = checkpoint->position;
+			lineCurrent = styler.GetLine(startPos);
+			const int *values = checkpoint->values.data();
+			state = values[0];
+			chPrev = values[1];
+			ch = values[2];
+			chPrevNonWhite = values[3];
+			inScriptType = static_cast<script_mode>(values[4]);
+			tagOpened = values[5];
+			tagClosing = values[6];
+			tagDontFold = values[7];
+			aspScript = static_cast<script_type>(values[8]);
+			clientScript = static_cast<script_type>(values[9]);
+			beforePreProc = values[10];
+			isLanguageType = values[11];
+			sgmlBlockLevel = values[12];
+			scriptLanguage = static_cast<script_type>(values[13]);
+			beforeLanguage = static_cast<script_type>(values[14]);
+			levelPrev = values[15];
+			levelCurrent = values[16];
+		}
+	}
+	std::vector<int> checkpointValues;
+
 	styler.StartAt(startPos);
 	styler.StartSegment(startPos);
 	const Sci_Position lengthDoc = startPos + length;
 	for (Sci_Position i = startPos; i < lengthDoc; i++) {
+		if (checkpoints && InTagState(state) && (ch == '\n' || (ch == '\r' && styler[i] != '\n'))
+			&& lineCurrent % LexerCheckpoints::Interval == 0) {
+			checkpointValues.assign({state, chPrev, ch, chPrevNonWhite, inScriptType, tagOpened, tagClosing, tagDontFold,
+				aspScript, clientScript, beforePreProc, isLanguageType, sgmlBlockLevel, scriptLanguage, beforeLanguage,
+				levelPrev, levelCurrent});
+			checkpoints->Save(i, checkpointValues);
+		}
 		const int chPrev2 = chPrev;
 		chPrev = ch;
 		if (!IsASpace(ch) && state != SCE_HJ_COMMENT &&
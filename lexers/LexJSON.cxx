@@ -87,6 +87,8 @@ void ColouriseJSONDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initSt
 	assert(startPos == static_cast<Sci_PositionU>(styler.LineStart(lineCurrent)));
 	Sci_PositionU lineStartNext = styler.LineStart(lineCurrent + 1);
 	const Sci_PositionU endPos = startPos + lengthDoc;
+	// trail byte in DBCS character may be backslash or other ASCII punctuation
+	const bool dbcs = styler.Encoding() == EncodingType::dbcs;
 
 	// see GenerateJsonCharClass() in scripts/GenerateCharTable.py
 	static constexpr uint8_t kJsonCharClass[256] = {
@@ -152,7 +154,7 @@ void ColouriseJSONDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initSt
 					styler.ColorTo(currentPos, state);
 					state = SCE_JSON_DEFAULT;
 				}
-			} else if (ch == '\\') {
+			} else if (ch == '\\' && startPos < endPos) {
 				if (IsEOLChar(chNext)) {
 					lineContinuation = true;
 				} else {
@@ -248,6 +250,23 @@ void ColouriseJSONDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initSt
 			chNext = styler[startPos];
 		}
 
+		// skip bytes that can not change state in bulk
+		if (startPos < lineStartNext && state != SCE_JSON_DEFAULT) {
+			const Sci_PositionU lineLimit = sci::min(lineStartNext, endPos);
+			if (state == SCE_JSON_LINECOMMENT) {
+				startPos = lineLimit;
+				chNext = styler[startPos];
+			} else if (startPos < lineLimit) {
+				if (state == SCE_JSON_BLOCKCOMMENT) {
+					startPos = styler.FindAnyOf(startPos, lineLimit, '*', '*', '\r', '\n', dbcs);
+					chNext = styler[startPos];
+				} else if (state == SCE_JSON_STRING_DQ || state == SCE_JSON_STRING_SQ) {
+					startPos = styler.FindAnyOf(startPos, lineLimit, static_cast<char>(GetStringQuote(state)), '\\', '\r', '\n', dbcs);
+					chNext = styler[startPos];
+				}
+			}
+		}
+
 		atLineStart = startPos == lineStartNext;
 		if (atLineStart) {
 			if (fold) {
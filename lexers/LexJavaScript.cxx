@@ -8,6 +8,7 @@
 #include <string>
 #include <string_view>
 #include <vector>
+#include <algorithm>
 
 #include "ILexer.h"
 #include "Scintilla.h"
@@ -20,6 +21,7 @@
 #include "CharacterSet.h"
 #include "StringUtils.h"
 #include "LexerModule.h"
+#include "LexerCheckpoints.h"
 #include "DocUtils.h"
 
 using namespace Lexilla;
@@ -155,9 +157,21 @@ void ColouriseJsDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyl
 	DocTagState docTagState = DocTagState::None;
 	EscapeSequence escSeq;
 
+	LexerCheckpoints * const checkpoints = styler.Checkpoints();
+	const LexerCheckpoints::Checkpoint *checkpoint = nullptr;
 	if (startPos != 0) {
 		// backtrack to the line starts JSX or interpolation for better coloring on typing.
+		const Sci_PositionU lineStartPos = startPos;
 		BacktrackToStart(styler, JsLineStateStringInterpolation, startPos, lengthDoc, initStyle);
+		// or resume from nearest checkpoint inside the interpolation.
+		if (checkpoints && startPos != lineStartPos) {
+			checkpoint = checkpoints->Find(startPos + 1, lineStartPos);
+			if (checkpoint) {
+				lengthDoc -= checkpoint->position - startPos;
+				startPos = checkpoint->position;
+				initStyle = styler.StyleIndexAt(startPos - 1);
+			}
+		}
 	}
 
 	StyleContext sc(startPos, lengthDoc, initStyle, styler);
@@ -183,6 +197,19 @@ void ColouriseJsDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyl
 		// look back for better regex colouring
 		LookbackNonWhite(styler, startPos, SCE_JS_TASKMARKER, chPrevNonWhite, stylePrevNonWhite);
 	}
+	if (checkpoint) {
+		const int *values = checkpoint->values.data();
+		lineContinuation = values[0];
+		jsxTagLevel = values[1];
+		chBefore = values[2];
+		chBeforeIdentifier = values[3];
+		chPrevNonWhite = values[4];
+		stylePrevNonWhite = values[5];
+		for (size_t index = 6; index < checkpoint->values.size(); index += 3) {
+			nestedState.push_back({values[index], values[index + 1], values[index + 2]});
+		}
+	}
+	std::vector<int> checkpointValues;
 
 	while (sc.More()) {
 		switch (sc.state) {
@@ -563,6 +590,13 @@ void ColouriseJsDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyl
 			int lineState = lineContinuation | lineStateLineType | (jsxTagLevel << 4);
 			if (!nestedState.empty()) {
 				lineState |= JsLineStateStringInterpolation;
+				if (checkpoints && (sc.currentLine + 1) % LexerCheckpoints::Interval == 0) {
+					checkpointValues.assign({lineContinuation, jsxTagLevel, chBefore, chBeforeIdentifier, chPrevNonWhite, stylePrevNonWhite});
+					for (const InterpolatedStringState &state : nestedState) {
+						checkpointValues.insert(checkpointValues.end(), {state.state, state.braceCount, state.jsxTagLevel});
+					}
+					checkpoints->Save(sc.lineStartNext, checkpointValues);
+				}
 			}
 			styler.SetLineState(sc.currentLine, lineState);
 			lineStateLineType = 0;
@@ -572,6 +606,22 @@ void ColouriseJsDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyl
 			docTagState = DocTagState::None;
 		}
 		sc.Forward();
+
+		// Skip string characters that can not change state in bulk.
+		if (!sc.atLineStart && (sc.state == SCE_JS_STRING_SQ || sc.state == SCE_JS_STRING_DQ
+			|| sc.state == SCE_JSX_STRING_SQ || sc.state == SCE_JSX_STRING_DQ || sc.state == SCE_JS_TEMPLATELITERAL)) {
+			const Sci_PositionU startPos = sc.currentPos;
+			sc.ForwardUntil(static_cast<char>(GetStringQuote(sc.state)), '\\', (sc.state == SCE_JS_TEMPLATELITERAL) ? '$' : '\r');
+			if (sc.currentPos != startPos) {
+				// visibleChars is only compared with zero
+				const int chPrev = LexGetPrevChar(styler, startPos, sc.currentPos);
+				if (chPrev != '\0') {
+					visibleChars += static_cast<int>(sc.currentPos - startPos);
+					chPrevNonWhite = chPrev;
+					stylePrevNonWhite = sc.state;
+				}
+			}
+		}
 	}
 
 	sc.Complete();
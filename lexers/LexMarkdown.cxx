@@ -4,10 +4,12 @@
 
 #include <cassert>
 #include <cstring>
+#include <climits>
 
 #include <string>
 #include <string_view>
 #include <vector>
+#include <algorithm>
 
 #include "ILexer.h"
 #include "Scintilla.h"
@@ -20,6 +22,7 @@
 #include "CharacterSet.h"
 #include "StringUtils.h"
 #include "LexerModule.h"
+#include "LexerCheckpoints.h"
 #include "DocUtils.h"
 
 using namespace Scintilla;
@@ -276,6 +279,29 @@ struct MarkdownLexer {
 		nestedState.pop_back();
 		return state;
 	}
+	// speculative inline spans may rewind to where they start, so state is saved outside them
+	// or inside an inline html tag (its nested state has no start position).
+	bool CanSaveCheckpoint() const noexcept {
+		return nestedState.empty() || (nestedState.size() == 1 && nestedState.front().startPos == 0
+			&& sc.state > SCE_MARKDOWN_DEFAULT && sc.state < SCE_MARKDOWN_HEADER1);
+	}
+	// unfinished span longer than scan limit is styled as outer text
+	bool IsNestedTooLong() const noexcept {
+		return (bracketCount == 0 || sc.state == SCE_MARKDOWN_LINK_TEXT)
+			&& sc.currentPos - nestedState.back().startPos >= static_cast<Sci_PositionU>(sc.styler.LookDistance());
+	}
+	SeekStatus RewindNested() {
+		bracketCount = 0;
+		if (sc.state > SCE_MARKDOWN_LINK_TEXT && sc.state < SCE_MARKDOWN_CODE_SPAN) {
+			tagState = HtmlTagState::None;
+			parenCount = 0;
+		}
+		const auto state = TakeOuterState();
+		sc.ChangeState(state.outerState);
+		const bool multiline = sc.BackTo(state.startPos);
+		sc.Forward();
+		return multiline ? SeekStatus::Multiline : SeekStatus::Continue;
+	}
 
 	bool IsParagraphEnd(Sci_PositionU pos, uint32_t lineState) const noexcept;
 	bool OnHeaderLine() const noexcept {
@@ -1625,10 +1651,22 @@ bool MarkdownLexer::HighlightCriticMarkup() {
 }
 
 void ColouriseMarkdownDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, LexerWordList keywordLists, Accessor &styler) {
+	LexerCheckpoints * const checkpoints = styler.Checkpoints();
+	const LexerCheckpoints::Checkpoint *checkpoint = nullptr;
 	if (startPos != 0) {
 		// backtrack to previous line for better coloring on typing.
+		const Sci_PositionU lineStartPos = startPos;
 		constexpr int mask = INT_MIN | LineStateNestedStateLine | (LineStateEmptyLine << 8);
 		BacktrackToStart(styler, mask, startPos, lengthDoc, initStyle);
+		// or resume from nearest checkpoint inside html tag or setext heading.
+		if (checkpoints && startPos != lineStartPos) {
+			checkpoint = checkpoints->Find(startPos + 1, lineStartPos - 1);
+			if (checkpoint) {
+				lengthDoc -= checkpoint->position - startPos;
+				startPos = checkpoint->position;
+				initStyle = checkpoint->values[0];
+			}
+		}
 	}
 
 	MarkdownLexer lexer(startPos, lengthDoc, initStyle, keywordLists, styler);
@@ -1688,9 +1726,37 @@ void ColouriseMarkdownDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int in
 			sc.Forward();
 		}
 	}
+	if (checkpoint) {
+		const int *values = checkpoint->values.data();
+		lineState = values[1];
+		indentPrevious = values[2];
+		prevLevel = values[3];
+		lexer.tagState = static_cast<HtmlTagState>(values[4]);
+		lexer.indentParent = values[5];
+		lexer.delimiterCount = values[6];
+		lexer.outerState = values[7];
+		lexer.bracketCount = values[8];
+		lexer.parenCount = values[9];
+		values = LexerCheckpoints::Restore(values + 10, lexer.cycleMaxPos);
+		for (; values != checkpoint->values.data() + checkpoint->values.size(); values++) {
+			lexer.nestedState.push_back({*values, 0});
+		}
+	}
+	std::vector<int> checkpointValues;
 
 	while (sc.More()) {
 		if (sc.atLineStart) {
+			if (checkpoints && (lineState & LineStateNestedStateLine) != 0 && lexer.CanSaveCheckpoint()
+				&& sc.currentLine % LexerCheckpoints::Interval == 0) {
+				checkpointValues.assign({sc.state, static_cast<int>(lineState), indentPrevious, prevLevel,
+					static_cast<int>(lexer.tagState), lexer.indentParent, lexer.delimiterCount, lexer.outerState,
+					lexer.bracketCount, lexer.parenCount});
+				LexerCheckpoints::Append(checkpointValues, lexer.cycleMaxPos);
+				for (const MarkupState &state : lexer.nestedState) {
+					checkpointValues.push_back(state.outerState);
+				}
+				checkpoints->Save(sc.currentPos, checkpointValues);
+			}
 			visibleChars = 0;
 			indentCurrent = 0;
 			indentChild = 0;
@@ -1849,7 +1915,9 @@ void ColouriseMarkdownDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int in
 		case SCE_MARKDOWN_INLINE_DISPLAY_MATH:
 		case SCE_MARKDOWN_INLINE_MATH: {
 			SeekStatus status;
-			if (sc.state < SCE_MARKDOWN_LINK_TEXT) {
+			if (lexer.IsNestedTooLong()) {
+				status = lexer.RewindNested();
+			} else if (sc.state < SCE_MARKDOWN_LINK_TEXT) {
 				status = lexer.HighlightEmphasis(lineState, visibleChars);
 			} else if (sc.state == SCE_MARKDOWN_LINK_TEXT) {
 				status = lexer.HighlightLinkText(lineState);
@@ -12,6 +12,8 @@
 
 #include <string>
 #include <string_view>
+#include <vector>
+#include <algorithm>
 
 #include "ILexer.h"
 #include "Scintilla.h"
@@ -24,6 +26,7 @@
 #include "CharacterSet.h"
 #include "StringUtils.h"
 #include "LexerModule.h"
+#include "LexerCheckpoints.h"
 
 using namespace Lexilla;
 
@@ -149,29 +152,36 @@ int disambiguateBareword(LexAccessor &styler, Sci_PositionU bk, Sci_PositionU fw
 	return result;
 }
 
-void skipWhitespaceComment(const LexAccessor &styler, Sci_PositionU &p) noexcept {
+void skipWhitespaceComment(LexAccessor &styler, Sci_PositionU &p) noexcept {
 	// when backtracking, we need to skip whitespace and comments
-	while (p > 0) {
+	const Sci_PositionU limit = styler.LookBehindLimit(p);
+	const Sci_PositionU start = p;
+	while (p > limit) {
 		const int style = styler.StyleAt(p);
 		if (style > SCE_PL_COMMENTLINE)
 			break;
 		p--;
 	}
+	styler.ChargeLook(start - p);
 }
 
-int findPrevLexeme(const LexAccessor &styler, Sci_PositionU &bk, int &style) noexcept {
+int findPrevLexeme(LexAccessor &styler, Sci_PositionU &bk, int &style) noexcept {
 	// scan backward past whitespace and comments to find a lexeme
 	skipWhitespaceComment(styler, bk);
 	if (bk == 0)
 		return 0;
+	const Sci_PositionU limit = styler.LookBehindLimit(bk);
 	int sz = 1;
 	style = styler.StyleAt(bk);
-	while (bk > 0) {	// find extent of lexeme
+	while (bk > limit) {	// find extent of lexeme
 		if (styler.StyleAt(bk - 1) == style) {
 			bk--; sz++;
 		} else
 			break;
 	}
+	styler.ChargeLook(sz);
+	if (bk == limit && bk != 0)		// lexeme longer than scan limit
+		return 0;
 	return sz;
 }
 
@@ -181,7 +191,9 @@ int styleBeforeBracePair(LexAccessor &styler, Sci_PositionU bk) noexcept {
 	int braceCount = 1;
 	if (bk == 0)
 		return SCE_PL_DEFAULT;
-	while (--bk > 0) {
+	const Sci_PositionU limit = styler.LookBehindLimit(bk);
+	const Sci_PositionU start = bk;
+	while (--bk > limit) {
 		if (styler.StyleAt(bk) == SCE_PL_OPERATOR) {
 			const int bkch = styler.SafeGetUCharAt(bk);
 			if (bkch == ';') {	// early out
@@ -193,6 +205,7 @@ int styleBeforeBracePair(LexAccessor &styler, Sci_PositionU bk) noexcept {
 			}
 		}
 	}
+	styler.ChargeLook(start - bk);
 	if (bk > 0 && braceCount == 0) {
 		// balanced { found, bk > 0, skip more whitespace/comments
 		bk--;
@@ -349,18 +362,21 @@ int PodHeadingLevel(LexAccessor &styler, Sci_Position pos) noexcept {
 
 int InputSymbolScan(StyleContext &sc) noexcept {
 	// forward scan for matching > on same line; file handles
+	const Sci_Position limit = sc.styler.LookAheadLimit(sc.currentPos) - sc.currentPos;
 	int c;
 	int sLen = 0;
-	while ((c = sc.GetRelativeCharacter(++sLen)) != 0) {
+	int result = 0;
+	while (sLen < limit && (c = sc.GetRelativeCharacter(++sLen)) != 0) {
 		if (c == '\r' || c == '\n') {
-			return 0;
+			break;
 		} else if (c == '>') {
-			if (sc.Match('<', '=', '>'))	// '<=>' case
-				return 0;
-			return sLen;
+			if (!sc.Match('<', '=', '>'))	// '<=>' case
+				result = sLen;
+			break;
 		}
 	}
-	return 0;
+	sc.styler.ChargeLook(sLen);
+	return result;
 }
 
 constexpr bool IsPerlSpecialVar(int ch) noexcept {
@@ -575,6 +591,7 @@ void ColourisePerlDoc(Sci_PositionU startPos, Sci_Position length, int initStyle
 	int dotCount = 0;
 
 	const Sci_PositionU endPos = startPos + length;
+	const Sci_PositionU lineStartPos = startPos;
 
 	// Backtrack to beginning of style if required...
 	// If in a long distance lexical state, backtrack to find quote characters.
@@ -656,9 +673,34 @@ void ColourisePerlDoc(Sci_PositionU startPos, Sci_Position length, int initStyle
 		backPos++;
 	}
 
+	// or resume from nearest checkpoint inside here-doc, string or POD.
+	LexerCheckpoints * const checkpoints = styler.Checkpoints();
+	if (checkpoints && startPos < lineStartPos) {
+		const LexerCheckpoints::Checkpoint *checkpoint = checkpoints->Find(startPos + 1, lineStartPos - 1);
+		if (checkpoint) {
+			startPos = checkpoint->position;
+			const int *values = checkpoint->values.data();
+			initStyle = values[0];
+			numState = values[1];
+			dotCount = values[2];
+			backFlag = values[3];
+			values = LexerCheckpoints::Restore(values + 4, backPos);
+			values = LexerCheckpoints::Restore(values, HereDoc);
+			LexerCheckpoints::Restore(values, Quote);
+		}
+	}
+	std::vector<int> checkpointValues;
 	StyleContext sc(startPos, endPos - startPos, initStyle, styler);
 
 	for (; sc.More(); sc.Forward()) {
+		if (sc.atLineStart && checkpoints && sc.state != SCE_PL_DEFAULT
+			&& sc.currentLine % LexerCheckpoints::Interval == 0) {
+			checkpointValues.assign({sc.state, numState, dotCount, backFlag});
+			LexerCheckpoints::Append(checkpointValues, backPos);
+			LexerCheckpoints::Append(checkpointValues, HereDoc);
+			LexerCheckpoints::Append(checkpointValues, Quote);
+			checkpoints->Save(sc.currentPos, checkpointValues);
+		}
 
 		// Determine if the current state should terminate.
 		switch (sc.state) {
@@ -10,6 +10,8 @@
 
 #include <string>
 #include <string_view>
+#include <vector>
+#include <algorithm>
 
 #include "ILexer.h"
 #include "Scintilla.h"
@@ -22,6 +24,7 @@
 #include "CharacterSet.h"
 #include "StringUtils.h"
 #include "LexerModule.h"
+#include "LexerCheckpoints.h"
 
 using namespace Lexilla;
 
@@ -486,7 +489,13 @@ bool sureThisIsNotHeredoc(Sci_Position lt2StartPos, LexAccessor &styler) {
 	constexpr bool looks_like_a_here_doc = false;
 
 	// find the expression start rather than the line start
-	const Sci_Position exprStartPosn = findExpressionStart(lt2StartPos, lineStartPosn, styler);
+	const Sci_Position minStartPosn = sci::max(lineStartPosn, styler.LookBehindLimit(lt2StartPos));
+	const Sci_Position exprStartPosn = findExpressionStart(lt2StartPos, minStartPosn, styler);
+	styler.ChargeLook(lt2StartPos - exprStartPosn);
+	if (exprStartPosn == minStartPosn && minStartPosn != lineStartPosn) {
+		// expression longer than scan limit
+		return definitely_not_a_here_doc;
+	}
 
 	// Find the first word after some whitespace
 	Sci_Position firstWordPosn = LexSkipWhiteSpace(styler, exprStartPosn, lt2StartPos);
@@ -716,7 +725,18 @@ void ColouriseRbDoc(Sci_PositionU startPos, Sci_Position length, int initStyle,
 
 	QuoteCls Quote;
 
+	const Sci_PositionU lineStartPos = startPos;
 	synchronizeDocStart(startPos, length, initStyle, styler);
+	// or resume from nearest checkpoint inside here-doc or string.
+	LexerCheckpoints * const checkpoints = styler.Checkpoints();
+	const LexerCheckpoints::Checkpoint *checkpoint = nullptr;
+	if (checkpoints && startPos < lineStartPos) {
+		checkpoint = checkpoints->Find(startPos + 1, lineStartPos - 1);
+		if (checkpoint) {
+			length -= checkpoint->position - startPos;
+			startPos = checkpoint->position;
+		}
+	}
 	const Sci_Position lengthDoc = startPos + length;
 
 	bool preferRE = true;
@@ -795,7 +815,32 @@ void ColouriseRbDoc(Sci_PositionU startPos, Sci_Position length, int initStyle,
 	};
 	InnerExpression innerExpr;
 
+	if (checkpoint) {
+		const int *values = checkpoint->values.data();
+		state = values[0];
+		preferRE = values[1];
+		afterDef = values[2];
+		is_real_number = values[3];
+		modifierDo = values[4];
+		chPrev = static_cast<char>(values[5]);
+		chNext = static_cast<char>(values[6]);
+		values = LexerCheckpoints::Restore(values + 7, prevWord);
+		values = LexerCheckpoints::Restore(values, HereDoc);
+		values = LexerCheckpoints::Restore(values, Quote);
+		LexerCheckpoints::Restore(values, innerExpr);
+	}
+	std::vector<int> checkpointValues;
+
 	for (Sci_Position i = startPos; i < lengthDoc; i++) {
+		if (checkpoints && state != SCE_RB_DEFAULT && (chPrev == '\n' || (chPrev == '\r' && chNext != '\n'))
+			&& styler.GetLine(i) % LexerCheckpoints::Interval == 0) {
+			checkpointValues.assign({state, preferRE, afterDef, is_real_number, modifierDo, chPrev, chNext});
+			LexerCheckpoints::Append(checkpointValues, prevWord);
+			LexerCheckpoints::Append(checkpointValues, HereDoc);
+			LexerCheckpoints::Append(checkpointValues, Quote);
+			LexerCheckpoints::Append(checkpointValues, innerExpr);
+			checkpoints->Save(i, checkpointValues);
+		}
 		char ch = chNext;
 		chNext = styler.SafeGetCharAt(i + 1);
 		char chNext2 = styler.SafeGetCharAt(i + 2);
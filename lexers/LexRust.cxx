@@ -613,4 +613,4 @@ void FoldRustDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle,
 
 }
 
-extern const LexerModule lmRust(SCLEX_RUST, ColouriseRustDoc, "rust", FoldRustDoc);
+extern const LexerModule lmRust(SCLEX_RUST, ColouriseRustDoc, "rust", FoldRustDoc, true);
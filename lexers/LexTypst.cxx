@@ -4,6 +4,7 @@
 
 #include <cassert>
 #include <cstring>
+#include <climits>
 
 #include <string>
 #include <string_view>
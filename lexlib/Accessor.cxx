@@ -5,6 +5,7 @@
 // Copyright 1998-2002 by Neil Hodgson <neilh@scintilla.org>
 // The License.txt file describes the conditions under which this software may be distributed.
 
+#include <cstdint>
 #include <cassert>
 #include <cstring>
 
@@ -22,7 +23,8 @@
 
 using namespace Lexilla;
 
-Accessor::Accessor(Scintilla::IDocument *pAccess_, const PropSetSimple &props_) noexcept : LexAccessor(pAccess_), props(props_) {
+Accessor::Accessor(Scintilla::IDocument *pAccess_, const PropSetSimple &props_, LexerCheckpoints *checkpoints_) noexcept :
+	LexAccessor(pAccess_), props(props_), checkpoints(checkpoints_) {
 }
 
 const char *Accessor::GetProperty(const char *key, size_t keyLen) const {
@@ -14,13 +14,15 @@ enum {
 
 class Accessor;
 class PropSetSimple;
+class LexerCheckpoints;
 
 typedef bool (*PFNIsCommentLeader)(Accessor &styler, Sci_Position pos, Sci_Position len);
 
 class Accessor final : public LexAccessor {
 	const PropSetSimple &props;
+	LexerCheckpoints * const checkpoints;
 public:
-	Accessor(Scintilla::IDocument *pAccess_, const PropSetSimple &props_) noexcept;
+	Accessor(Scintilla::IDocument *pAccess_, const PropSetSimple &props_, LexerCheckpoints *checkpoints_ = nullptr) noexcept;
 	const char *GetProperty(const char *key, size_t keyLen) const;
 	int GetPropertyInt(const char *key, size_t keyLen, int defaultValue = 0) const;
 
@@ -39,6 +41,11 @@ public:
 		return GetPropertyInt(key, N - 1, defaultValue) & true;
 	}
 
+	// checkpoints kept by the lexer instance, nullptr when folding.
+	LexerCheckpoints *Checkpoints() const noexcept {
+		return checkpoints;
+	}
+
 	int IndentAmount(Sci_Line line) noexcept;
 
 	[[deprecated]]
@@ -101,6 +101,25 @@ public:
 	}
 };
 
+// 256 entry byte class table for a lexer, the class bits are defined by each lexer.
+// Built at compile time from a classify function:
+// static constexpr ByteClassTable kCharClass = MakeByteClassTable([](int ch) constexpr noexcept { ... });
+struct ByteClassTable {
+	unsigned char classes[256];
+	constexpr unsigned char operator[](unsigned char ch) const noexcept {
+		return classes[ch];
+	}
+};
+
+template <typename Classify>
+constexpr ByteClassTable MakeByteClassTable(Classify classify) noexcept {
+	ByteClassTable table{};
+	for (int ch = 0; ch < 256; ch++) {
+		table.classes[ch] = static_cast<unsigned char>(classify(ch));
+	}
+	return table;
+}
+
 template <typename T, typename... Args>
 constexpr bool AnyOf(T t, Args... args) noexcept {
 #if defined(__clang__)
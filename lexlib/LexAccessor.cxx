@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "ILexer.h"
+#include "VectorISA.h"
 #include "Scintilla.h"
 
 #include "LexAccessor.h"
@@ -18,8 +19,62 @@
 
 using namespace Lexilla;
 
+namespace {
+
+Sci_Position FindAnyOfSegment(const char *data, Sci_Position pos, Sci_Position end, char ch0, char ch1, char ch2, char ch3, bool nonASCII) noexcept {
+#if NP2_USE_SSE2
+	const uint32_t highMask = nonASCII ? 0xffff : 0;
+	const __m128i vect0 = _mm_set1_epi8(ch0);
+	const __m128i vect1 = _mm_set1_epi8(ch1);
+	const __m128i vect2 = _mm_set1_epi8(ch2);
+	const __m128i vect3 = _mm_set1_epi8(ch3);
+	for (; pos + static_cast<Sci_Position>(sizeof(__m128i)) <= end; pos += sizeof(__m128i)) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+		const __m128i match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, vect0), _mm_cmpeq_epi8(chunk, vect1)),
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, vect2), _mm_cmpeq_epi8(chunk, vect3)));
+		const uint32_t mask = mm_movemask_epi8(match) | (mm_movemask_epi8(chunk) & highMask);
+		if (mask != 0) {
+			return pos + np2_ctz(mask);
+		}
+	}
+#endif
+	for (; pos < end; pos++) {
+		const char ch = data[pos];
+		if (ch == ch0 || ch == ch1 || ch == ch2 || ch == ch3 || (nonASCII && static_cast<unsigned char>(ch) >= 0x80)) {
+			break;
+		}
+	}
+	return pos;
+}
+
+}
+
 namespace Lexilla {
 
+Sci_Position LexAccessor::FindAnyOf(Sci_Position startPos_, Sci_Position endPos_, char ch0, char ch1, char ch2, char ch3, bool nonASCII) noexcept {
+	if (segment1) {
+		const Sci_Position length1_ = length1;
+		if (startPos_ < length1_) {
+			const Sci_Position end1 = sci::min(endPos_, length1_);
+			startPos_ = FindAnyOfSegment(segment1, startPos_, end1, ch0, ch1, ch2, ch3, nonASCII);
+			if (startPos_ < end1) {
+				return startPos_;
+			}
+		}
+		if (startPos_ < endPos_) {
+			startPos_ = FindAnyOfSegment(segment2, startPos_, endPos_, ch0, ch1, ch2, ch3, nonASCII);
+		}
+		return startPos_;
+	}
+	for (; startPos_ < endPos_; startPos_++) {
+		const char ch = (*this)[startPos_];
+		if (ch == ch0 || ch == ch1 || ch == ch2 || ch == ch3 || (nonASCII && static_cast<unsigned char>(ch) >= 0x80)) {
+			break;
+		}
+	}
+	return startPos_;
+}
+
 bool LexAccessor::MatchIgnoreCase(Sci_Position pos, const char *s) noexcept {
 	for (; *s; s++, pos++) {
 		if (*s != MakeLowerCase((*this)[pos])) {
@@ -23,18 +23,39 @@ class LexAccessor {
 	enum {
 		bufferSize = 4096,
 		slopSize = bufferSize / 8,
+		runBufferSize = 512,
+	};
+	/** Scans ahead of or behind the lexing position that may pass any number of bytes
+	 * share a budget of @a lookBudgetFactor times document length per Lex() or Fold() call,
+	 * so hostile text like a long line of '(' can not make lexing quadratic.
+	 * Each scan passes at most @a maxLookDistance bytes, or @a minLookDistance bytes
+	 * once the budget is spent. */
+	enum {
+		lookBudgetFactor = 4,
+		maxLookDistance = 1024*1024,
+		minLookDistance = 64,
 	};
 	char buf[bufferSize + sizeof(int)];
+	// Document text read in place when the document provides its segments,
+	// buf is then only used by foreign IDocument implementations.
+	const char *segment1 = nullptr;
+	const char *segment2 = nullptr;
+	Sci_PositionU length1 = 0;
 	const EncodingType encodingType;
 	Sci_Position startPos = 0;
 	Sci_Position endPos = 0;
 	//const int codePage;
-	//const int documentVersion;
+	const int documentVersion;
 	const Sci_Position lenDoc;
-	unsigned char styleBuf[bufferSize];
+	// Styles are buffered as runs, adjacent runs with same style are merged.
+	Scintilla::StyleRun styleRuns[runBufferSize];
+	// Offset of each run from startPosStyling.
+	Sci_PositionU runStarts[runBufferSize];
+	Sci_PositionU validRuns = 0;
 	Sci_PositionU validLen = 0;
 	Sci_PositionU startSeg = 0;
 	Sci_Position startPosStyling = 0;
+	Sci_Position lookBudget;
 
 	void Fill(Sci_Position position) noexcept {
 		Sci_Position m = lenDoc - bufferSize;
@@ -60,16 +81,31 @@ public:
 	explicit LexAccessor(Scintilla::IDocument *pAccess_) noexcept :
 		pAccess(pAccess_),
 		//codePage(pAccess->CodePage()),
-		//documentVersion(pAccess->Version()),
 		encodingType(EncodingTypeForCodePage(pAccess->CodePage())),
-		lenDoc(pAccess->Length()) {
-		// Prevent warnings by static analyzers about uninitialized buf and styleBuf.
+		documentVersion(pAccess->Version()),
+		lenDoc(pAccess->Length()),
+		lookBudget(lenDoc*lookBudgetFactor + maxLookDistance) {
+		// Prevent warnings by static analyzers about uninitialized buf.
 		// zero unused padding to prevent potential out of bounds bug.
 		memset(buf, 0, sizeof(int));
 		memset(buf + bufferSize, 0, sizeof(int));
-		memset(styleBuf, 0, sizeof(int));
+		if (documentVersion >= Scintilla::dvSegments) {
+			Sci_Position length = 0;
+			static_cast<Scintilla::IDocumentSegments *>(pAccess)->GetSegments(&segment1, &length, &segment2);
+			length1 = length;
+		}
 	}
 	char operator[](Sci_Position position) noexcept {
+		if (segment1) {
+			// zero sentinel after segment2 makes position lenDoc readable
+			if (static_cast<Sci_PositionU>(position) < length1) {
+				return segment1[position];
+			}
+			if (position >= 0) {
+				return segment2[position];
+			}
+			// negative position would read before the document when the gap is empty
+		}
 		if (position < startPos || position >= endPos) {
 			Fill(position);
 		}
@@ -94,6 +130,13 @@ public:
 
 	/** Safe version of operator[], returning a defined value for invalid position. */
 	char SafeGetCharAt(Sci_Position position) noexcept {
+		if (segment1) {
+			const Sci_PositionU index = position;
+			if (index < length1) {
+				return segment1[index];
+			}
+			return (index < static_cast<Sci_PositionU>(lenDoc)) ? segment2[index] : '\0';
+		}
 		if (position < startPos || position >= endPos) {
 			Fill(position);
 			if (position < startPos || position >= endPos) {
@@ -132,6 +175,22 @@ public:
 		return encodingType;
 	}
 
+	// Farthest positions a bounded scan from pos may visit. A scan stopped by the limit
+	// must treat text as not matched, which leaves the text in plain style.
+	Sci_Position LookAheadLimit(Sci_Position pos) const noexcept {
+		return sci::min(pos + LookDistance(), lenDoc);
+	}
+	Sci_Position LookBehindLimit(Sci_Position pos) const noexcept {
+		return sci::max<Sci_Position>(pos - LookDistance(), 0);
+	}
+	// Charge bytes passed by a bounded scan to the budget.
+	void ChargeLook(Sci_Position distance) noexcept {
+		lookBudget -= distance;
+	}
+	constexpr Sci_Position LookDistance() const noexcept {
+		return sci::clamp<Sci_Position>(lookBudget, minLookDistance, maxLookDistance);
+	}
+
 	bool Match(Sci_Position pos, const char *s) noexcept {
 		for (; *s; s++, pos++) {
 			if (*s != (*this)[pos]) {
@@ -142,6 +201,10 @@ public:
 	}
 	bool MatchIgnoreCase(Sci_Position pos, const char *s) noexcept;
 	bool MatchLowerCase(Sci_Position pos, const char *s) noexcept;
+	// Returns first position in [startPos_, endPos_) with byte ch0, ch1, ch2 or ch3, or endPos_.
+	// Also stops at any byte >= 0x80 when nonASCII is set, used to skip only single byte characters in DBCS.
+	// Compares 16 bytes at a time when the document text is read in place.
+	Sci_Position FindAnyOf(Sci_Position startPos_, Sci_Position endPos_, char ch0, char ch1, char ch2 = '\r', char ch3 = '\n', bool nonASCII = false) noexcept;
 
 	// Get first len - 1 characters in range [startPos_, endPos_).
 	void GetRange(Sci_PositionU startPos_, Sci_PositionU endPos_, char *s, Sci_PositionU len) const noexcept;
@@ -163,7 +226,21 @@ public:
 	unsigned char BufferStyleAt(Sci_Position position) const noexcept {
 		const Sci_PositionU index = position - startPosStyling;
 		if (index < validLen) {
-			return styleBuf[index];
+			// recently styled text is most often queried, else binary search run starts
+			Sci_PositionU run = validRuns - 1;
+			if (index < runStarts[run]) {
+				Sci_PositionU lower = 0;
+				while (lower + 1 < run) {
+					const Sci_PositionU middle = (lower + run) / 2;
+					if (index < runStarts[middle]) {
+						run = middle;
+					} else {
+						lower = middle;
+					}
+				}
+				run = lower;
+			}
+			return styleRuns[run].style;
 		}
 		return pAccess->StyleAt(position);
 	}
@@ -192,9 +269,16 @@ public:
 	}
 	void Flush() {
 		if (validLen > 0) {
-			pAccess->SetStyles(validLen, styleBuf);
+			if (documentVersion >= Scintilla::dvStyleRuns) {
+				static_cast<Scintilla::IDocumentStyleRuns *>(pAccess)->SetStyleRuns(validRuns, styleRuns);
+			} else {
+				for (Sci_PositionU index = 0; index < validRuns; index++) {
+					pAccess->SetStyleFor(styleRuns[index].length, styleRuns[index].style);
+				}
+			}
 			startPosStyling += validLen;
 			validLen = 0;
+			validRuns = 0;
 		}
 	}
 	int GetLineState(Sci_Line line) const noexcept {
@@ -225,24 +309,21 @@ public:
 		// Only perform styling for non empty range [startSeg, endPos_)
 		assert(endPos_ >= startSeg && endPos_ <= static_cast<Sci_PositionU>(Length()));
 		if (endPos_ > startSeg) {
-			Sci_PositionU len = endPos_ - startSeg;
-			if (validLen + len >= bufferSize) {
-				Flush();
-			}
+			const Sci_PositionU len = endPos_ - startSeg;
 			assert((startPosStyling + validLen + len) <= static_cast<Sci_PositionU>(Length()));
 			const auto attr = static_cast<unsigned char>(chAttr);
 			startSeg += len;
-			if (validLen + len < bufferSize) {
-				unsigned char *ptr = styleBuf + validLen;
-				validLen += len;
-				do {
-					*ptr++ = attr;
-					--len;
-				} while (len != 0);
+			if (validRuns != 0 && styleRuns[validRuns - 1].style == attr) {
+				styleRuns[validRuns - 1].length += len;
 			} else {
-				// Too big for buffer so send directly
-				pAccess->SetStyleFor(len, attr);
+				if (validRuns == runBufferSize) {
+					Flush();
+				}
+				styleRuns[validRuns] = {static_cast<Sci_Position>(len), attr};
+				runStarts[validRuns] = validLen;
+				++validRuns;
 			}
+			validLen += len;
 		}
 	}
 	void SetLevel(Sci_Line line, int level) {
@@ -355,6 +436,17 @@ inline unsigned char LexGetPrevChar(LexAccessor &styler, Sci_Position endPos) no
 	} while (true);
 }
 
+inline unsigned char LexGetPrevChar(LexAccessor &styler, Sci_Position startPos, Sci_Position endPos) noexcept {
+	while (endPos > startPos) {
+		--endPos;
+		const unsigned char ch = styler[endPos];
+		if (!IsWhiteSpace(ch)) {
+			return ch;
+		}
+	}
+	return '\0';
+}
+
 inline unsigned char LexGetNextChar(LexAccessor &styler, Sci_Position startPos) noexcept {
 	do {
 		const unsigned char ch = styler.SafeGetCharAt(startPos);
@@ -381,25 +473,20 @@ struct MatchedDelimiterCount {
 };
 
 inline MatchedDelimiterCount GetMatchedDelimiterCountEx(LexAccessor &styler, Sci_PositionU pos, int delimiter) noexcept {
+	const Sci_PositionU limit = styler.LookAheadLimit(pos);
 	int count = 0;
 	int chNext;
 	do {
 		++count;
 		++pos;
 		chNext = styler.SafeGetUCharAt(pos);
-	} while (chNext == delimiter);
+	} while (chNext == delimiter && pos < limit);
+	styler.ChargeLook(count);
 	return {count, chNext};
 }
 
 inline int GetMatchedDelimiterCount(LexAccessor &styler, Sci_PositionU pos, int delimiter) noexcept {
-	int count = 0;
-	int chNext;
-	do {
-		++count;
-		++pos;
-		chNext = styler.SafeGetUCharAt(pos);
-	} while (chNext == delimiter);
-	return count;
+	return GetMatchedDelimiterCountEx(styler, pos, delimiter).count;
 }
 
 void BacktrackToStart(const LexAccessor &styler, int stateMask, Sci_PositionU &startPos, Sci_Position &lengthDoc, int &initStyle) noexcept;
@@ -6,6 +6,7 @@
 // The License.txt file describes the conditions under which this software may be distributed.
 
 #include <cstdlib>
+#include <cstdint>
 #include <cassert>
 #include <cstring>
 
@@ -13,6 +14,7 @@
 #include <string_view>
 #include <vector>
 //#include <map>
+#include <algorithm>
 
 #include "ILexer.h"
 #include "Scintilla.h"
@@ -23,6 +25,7 @@
 #include "LexAccessor.h"
 #include "Accessor.h"
 #include "LexerModule.h"
+#include "LexerCheckpoints.h"
 #include "LexerBase.h"
 
 using namespace Lexilla;
@@ -35,7 +38,7 @@ void SCI_METHOD LexerBase::Release() noexcept {
 }
 
 int SCI_METHOD LexerBase::Version() const noexcept {
-	return Scintilla::lvRelease5;
+	return lexer.lineResume ? Scintilla::lvLineResume : Scintilla::lvRelease5;
 }
 
 const char * SCI_METHOD LexerBase::PropertyNames() const noexcept {
@@ -75,7 +78,8 @@ Sci_Position SCI_METHOD LexerBase::WordListSet(int n, int attribute, const char
 }
 
 void SCI_METHOD LexerBase::Lex(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, Scintilla::IDocument *pAccess) {
-	Accessor styler(pAccess, props);
+	checkpoints.InvalidateAfter(startPos);
+	Accessor styler(pAccess, props, &checkpoints);
 	lexer.fnLexer(startPos, lengthDoc, initStyle, keywordLists, styler);
 	styler.Flush();
 }
@@ -0,0 +1,70 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+#pragma once
+
+namespace Lexilla {
+
+// Full lexer state saved at some line starts by lexers whose state can not be recovered from
+// line state alone (e.g. nested string interpolation), so styling can resume from the nearest
+// checkpoint instead of backtracking to the start of the construct.
+class LexerCheckpoints {
+public:
+	struct Checkpoint {
+		Sci_PositionU position;
+		std::vector<int> values;
+	};
+
+	// lines between checkpoints inside a construct
+	static constexpr Sci_Line Interval = 32;
+
+	// text after position may have changed since last styling.
+	void InvalidateAfter(Sci_PositionU position) noexcept {
+		while (!checkpoints.empty() && checkpoints.back().position > position) {
+			checkpoints.pop_back();
+		}
+	}
+
+	// styling goes forward, checkpoints after position are from previous styling.
+	// a position reached again in the same call keeps the state saved first,
+	// resuming with it replays the later visits.
+	void Save(Sci_PositionU position, const std::vector<int> &values) {
+		InvalidateAfter(position);
+		if (checkpoints.empty() || checkpoints.back().position != position) {
+			checkpoints.push_back({position, values});
+		}
+	}
+
+	// append trivially copyable state (e.g. here-doc delimiter, quote stack) to values.
+	template <typename T>
+	static void Append(std::vector<int> &values, const T &object) {
+		const size_t offset = values.size();
+		values.resize(offset + (sizeof(T) + sizeof(int) - 1)/sizeof(int));
+		memcpy(values.data() + offset, &object, sizeof(T));
+	}
+
+	// restore state appended by Append(), returns values after it.
+	template <typename T>
+	static const int *Restore(const int *values, T &object) noexcept {
+		memcpy(static_cast<void *>(&object), values, sizeof(T));
+		return values + (sizeof(T) + sizeof(int) - 1)/sizeof(int);
+	}
+
+	// last checkpoint in [startPos, endPos], or nullptr.
+	const Checkpoint *Find(Sci_PositionU startPos, Sci_PositionU endPos) const noexcept {
+		auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), endPos, [](Sci_PositionU position, const Checkpoint &checkpoint) noexcept {
+			return position < checkpoint.position;
+		});
+		if (it != checkpoints.begin()) {
+			--it;
+			if (it->position >= startPos) {
+				return &*it;
+			}
+		}
+		return nullptr;
+	}
+
+private:
+	std::vector<Checkpoint> checkpoints;
+};
+
+}
@@ -5,6 +5,7 @@
 // Copyright 1998-2010 by Neil Hodgson <neilh@scintilla.org>
 // The License.txt file describes the conditions under which this software may be distributed.
 
+#include <cstdint>
 #include <cassert>
 #include <cstring>
 
@@ -12,6 +13,7 @@
 #include <string_view>
 #include <vector>
 //#include <map>
+#include <algorithm>
 
 #include "ILexer.h"
 #include "Scintilla.h"
@@ -22,6 +24,7 @@
 #include "LexAccessor.h"
 #include "Accessor.h"
 #include "LexerModule.h"
+#include "LexerCheckpoints.h"
 #include "LexerBase.h"
 
 using namespace Lexilla;
@@ -26,17 +26,20 @@ public:
 	LexerFunction const fnFolder;
 	LexerFactoryFunction const fnFactory;
 	const char *const languageName;
+	const bool lineResume;	// see Scintilla::lvLineResume
 
 	constexpr LexerModule(
 		int language_,
 		LexerFunction fnLexer_,
 		const char *languageName_ = nullptr,
-		LexerFunction fnFolder_ = nullptr) noexcept:
+		LexerFunction fnFolder_ = nullptr,
+		bool lineResume_ = false) noexcept:
 		language(language_),
 		fnLexer(fnLexer_),
 		fnFolder(fnFolder_),
 		fnFactory(nullptr),
-		languageName(languageName_) {
+		languageName(languageName_),
+		lineResume(lineResume_) {
 	}
 
 	constexpr LexerModule(
@@ -47,7 +50,8 @@ public:
 		fnLexer(nullptr),
 		fnFolder(nullptr),
 		fnFactory(fnFactory_),
-		languageName(languageName_) {
+		languageName(languageName_),
+		lineResume(false) {
 	}
 
 	constexpr int GetLanguage() const noexcept {
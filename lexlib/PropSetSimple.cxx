@@ -8,73 +8,89 @@
 // Maintain a dictionary of properties
 
 #include <cstdlib>
+#include <cstdint>
 #include <cstring>
 
 #include <string>
 #include <string_view>
 #include <vector>
-//#include <map>
+#include <algorithm>
 
 #include "PropSetSimple.h"
 
 using namespace Lexilla;
 
+namespace {
+
+constexpr uint32_t HashKey(std::string_view key) noexcept {
+	uint32_t hash = 2166136261U;
+	for (const char ch : key) {
+		hash = (hash ^ static_cast<unsigned char>(ch)) * 16777619U;
+	}
+	return hash;
+}
+
+}
+
+const PropSetSimple::Property *PropSetSimple::Find(std::string_view key, uint32_t hash) const noexcept {
+	if (!slots.empty()) {
+		const size_t mask = slots.size() - 1;
+		for (size_t i = hash & mask; slots[i] != 0; i = (i + 1) & mask) {
+			const Property &prop = props[slots[i] - 1];
+			if (prop.hash == hash && prop.key == key) {
+				return &prop;
+			}
+		}
+	}
+	return nullptr;
+}
+
+void PropSetSimple::AddSlot(uint32_t hash, size_t index) noexcept {
+	const size_t mask = slots.size() - 1;
+	size_t i = hash & mask;
+	while (slots[i] != 0) {
+		i = (i + 1) & mask;
+	}
+	slots[i] = static_cast<uint32_t>(index + 1);
+}
+
 bool PropSetSimple::Set(std::string_view key, std::string_view val) {
-#if PropSetSimpleUseMap
-	const auto it = props.find(key);
-	if (it != props.end()) {
-		if (it->second == val) {
+	const uint32_t hash = HashKey(key);
+	if (const Property *found = Find(key, hash)) {
+		Property &prop = props[found - props.data()];
+		if (prop.value == val) {
 			return false;
 		}
-		it->second = val;
-	} else {
-		props.emplace(key, val);
+		prop.value = val;
+		prop.intValue = atoi(prop.value.c_str());
+		return true;
 	}
-#else
-	for (auto &it : props) {
-		if (it.first == key) {
-			if (it.second == val) {
-				return false;
-			}
-			it.second = val;
-			return true;
+
+	Property &prop = props.emplace_back(Property{std::string(key), std::string(val), 0, hash});
+	prop.intValue = atoi(prop.value.c_str());
+	// keep load factor at most 1/2
+	if (props.size()*2 > slots.size()) {
+		slots.assign(std::max<size_t>(slots.size()*2, 16), 0);
+		for (size_t index = 0; index < props.size(); index++) {
+			AddSlot(props[index].hash, index);
 		}
+	} else {
+		AddSlot(hash, props.size() - 1);
 	}
-	props.emplace_back(key, val);
-#endif
 	return true;
 }
 
 const char *PropSetSimple::Get(std::string_view key) const {
-#if PropSetSimpleUseMap
-	const auto it = props.find(key);
-	if (it != props.end()) {
-		return it->second.c_str();
-	}
-#else
-	for (const auto &it : props) {
-		if (it.first == key) {
-			return it.second.c_str();
-		}
+	if (const Property *prop = Find(key, HashKey(key))) {
+		return prop->value.c_str();
 	}
-#endif
 	return "";
 }
 
 int PropSetSimple::GetInt(const char *key, size_t keyLen, int defaultValue) const {
-#if PropSetSimpleUseMap
-	const auto it = props.find(std::string_view(key, keyLen));
-	if (it != props.end()) {
-		defaultValue = atoi(it->second.c_str());
-	}
-#else
 	const std::string_view sv{key, keyLen};
-	for (const auto &it : props) {
-		if (it.first == sv) {
-			defaultValue = atoi(it.second.c_str());
-			break;
-		}
+	if (const Property *prop = Find(sv, HashKey(sv))) {
+		return prop->intValue;
 	}
-#endif
 	return defaultValue;
 }
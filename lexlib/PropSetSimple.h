@@ -8,14 +8,21 @@
 
 namespace Lexilla {
 
-#define PropSetSimpleUseMap		0
-
+// Properties are interned into a hash index when set and their integer value parsed once,
+// so lookup cost does not grow with the number of properties set by the host.
 class PropSetSimple final {
-#if PropSetSimpleUseMap
-	std::map<std::string, std::string, std::less<>> props;
-#else
-	std::vector<std::pair<std::string, std::string>> props;
-#endif
+	struct Property {
+		std::string key;
+		std::string value;
+		int intValue;
+		uint32_t hash;
+	};
+	std::vector<Property> props;
+	// open addressing index into props, each slot holds index + 1 or zero for empty slot.
+	std::vector<uint32_t> slots;
+
+	const Property *Find(std::string_view key, uint32_t hash) const noexcept;
+	void AddSlot(uint32_t hash, size_t index) noexcept;
 public:
 	bool Set(std::string_view key, std::string_view val);
 	const char *Get(std::string_view key) const;
@@ -40,6 +40,14 @@ StyleContext::StyleContext(Sci_PositionU startPos, Sci_PositionU length, int ini
 	SeekTo(startPos);
 }
 
+void StyleContext::ForwardUntil(char ch0, char ch1, char ch2) noexcept {
+	// DBCS trail byte may equal to a delimiter, so only single byte characters are skipped
+	if (More() && !atLineEnd && !(multiByteAccess && ch >= 0x80)
+		&& !AnyOf(ch, static_cast<unsigned char>(ch0), static_cast<unsigned char>(ch1), static_cast<unsigned char>(ch2), '\n')) {
+		MoveTo(styler.FindAnyOf(currentPos + 1, LineLimit(), ch0, ch1, ch2, '\n', multiByteAccess));
+	}
+}
+
 bool StyleContext::MatchIgnoreCase(const char *s) const noexcept {
 	if (MakeLowerCase(ch) != static_cast<unsigned char>(*s)) {
 		return false;
@@ -35,6 +35,26 @@ private:
 		atLineEnd = currentPos >= lineStartNext - (currentLine < lineDocEnd);
 	}
 
+	Sci_PositionU LineLimit() const noexcept {
+		return sci::min(endPos, lineStartNext - (currentLine < lineDocEnd));
+	}
+
+	// Move forward on current line past single byte characters, pos is not at line start.
+	void MoveTo(Sci_PositionU pos) noexcept {
+		chPrev = static_cast<unsigned char>(styler[pos - 1]);
+		currentPos = pos;
+		if (!multiByteAccess) {
+			ch = styler.SafeGetUCharAt(pos);
+			chNext = styler.SafeGetUCharAt(pos + 1);
+		} else {
+			ch = styler.GetCharacterAndWidth(pos, &widthNext);
+			width = widthNext;
+			chNext = styler.GetCharacterAndWidth(pos + width, &widthNext);
+		}
+		atLineStart = false;
+		atLineEnd = pos >= lineStartNext - (currentLine < lineDocEnd);
+	}
+
 public:
 	Sci_PositionU currentPos;
 	Sci_Line currentLine;
@@ -96,6 +116,26 @@ public:
 			Forward();
 		}
 	}
+	// Same as calling Forward() until ch is ch0, ch1, ch2 or LF, at line end or end of range,
+	// or at non-ASCII character in DBCS, but skips the bytes in between in bulk.
+	void ForwardUntil(char ch0, char ch1, char ch2 = '\r') noexcept;
+	// Same as calling Forward() while table[ch] has any bit in mask and not at line end or end of range,
+	// stops at any double byte character.
+	template <typename Table>
+	void ForwardWhile(const Table &table, unsigned mask) noexcept {
+		if (multiByteAccess) {
+			while (More() && !atLineEnd && ch < 256 && (table[static_cast<unsigned char>(ch)] & mask)) {
+				Forward();
+			}
+		} else if (More() && !atLineEnd && (table[static_cast<unsigned char>(ch)] & mask)) {
+			const Sci_PositionU limit = LineLimit();
+			Sci_PositionU pos = currentPos + 1;
+			while (pos < limit && (table[static_cast<unsigned char>(styler[pos])] & mask)) {
+				++pos;
+			}
+			MoveTo(pos);
+		}
+	}
 	void ForwardBytes(Sci_Position nb) noexcept {
 		const Sci_PositionU forwardPos = currentPos + nb;
 		while (forwardPos > currentPos) {
@@ -250,6 +290,8 @@ public:
 
 	[[nodiscard]] bool BackTo(Sci_PositionU startPos) {
 		assert(startPos <= styler.GetStartSegment());
+		// text is lexed again, same as a lookahead scan
+		styler.ChargeLook(currentPos - startPos);
 		if (startPos < styler.GetStartSegment()) {
 			styler.Flush();
 			styler.StartAt(startPos);
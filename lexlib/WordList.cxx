@@ -11,6 +11,7 @@
 
 #include <algorithm>
 #include <iterator>
+#include <vector>
 
 #include "VectorISA.h"
 #include "WordList.h"
@@ -112,6 +113,188 @@ struct Range {
 	}
 };
 
+// Words are hashed on the text before the first WordKeyTerminator, so every word
+// matched by InList(s) or InListPrefixed(s, WordKeyTerminator) has the same key as s.
+constexpr char WordKeyTerminator = '(';
+// Tried displacements per bucket and seeds before falling back to first character search.
+constexpr range_t MaxHashDisplacement = 1 << 16;
+constexpr range_t MaxHashSeed = 4;
+
+struct WordKey {
+	uint64_t hash;
+	// key length with first and last byte, rejects most other keys without touching the word.
+	range_t filter;
+};
+
+constexpr uint64_t Mix64(uint64_t value) noexcept {
+	value = (value ^ (value >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+	value = (value ^ (value >> 27)) * UINT64_C(0x94d049bb133111eb);
+	return value ^ (value >> 31);
+}
+
+constexpr uint32_t Mix32(uint32_t value) noexcept {
+	value = (value ^ (value >> 16)) * 0x85ebca6bU;
+	value = (value ^ (value >> 13)) * 0xc2b2ae35U;
+	return value ^ (value >> 16);
+}
+
+inline WordKey HashWordKey(const char *s, range_t seed) noexcept {
+	uint64_t hash = UINT64_C(0xcbf29ce484222325) ^ (seed * UINT64_C(0x9e3779b97f4a7c15));
+	const char *p = s;
+	while (*p && *p != WordKeyTerminator) {
+		hash = (hash ^ static_cast<unsigned char>(*p)) * UINT64_C(0x100000001b3);
+		++p;
+	}
+	const range_t length = static_cast<range_t>(p - s);
+	range_t filter = std::min<range_t>(length, 0xffff);
+	if (length != 0) {
+		filter |= (static_cast<range_t>(static_cast<unsigned char>(s[0])) << 16)
+			| (static_cast<range_t>(static_cast<unsigned char>(p[-1])) << 24);
+	}
+	return {Mix64(hash), filter};
+}
+
+inline bool SameWordKey(const char *a, const char *b) noexcept {
+	while (*a && *a != WordKeyTerminator && *a == *b) {
+		a++;
+		b++;
+	}
+	return (!*a || *a == WordKeyTerminator) && (!*b || *b == WordKeyTerminator);
+}
+
+constexpr range_t HashBucket(uint64_t hash, range_t buckets) noexcept {
+	return static_cast<range_t>(((hash >> 32) * buckets) >> 32);
+}
+
+constexpr range_t HashSlot(uint64_t hash, range_t displacement, range_t slots) noexcept {
+	const uint32_t value = Mix32(static_cast<uint32_t>(hash) ^ (displacement * 0x9e3779b9U));
+	return static_cast<range_t>((static_cast<uint64_t>(value) * slots) >> 32);
+}
+
+/**
+ * Build a hash and displace perfect hash over the distinct keys of words, returns nullptr
+ * when there is no key or some bucket can't be placed with this seed.
+ * Keys are put into buckets of about four, largest bucket is placed first by finding
+ * the smallest displacement that moves all its keys into free slots.
+ */
+range_t *BuildWordHash(char * const *words, range_t len, range_t seed, range_t &bucketCount, range_t &slotCount) {
+	struct Entry {
+		uint64_t hash;
+		range_t filter;
+		range_t word;
+	};
+	std::vector<Entry> entries;
+	for (range_t i = 0; i < len; i++) {
+		if (*words[i] != '^') {
+			const WordKey key = HashWordKey(words[i], seed);
+			entries.push_back({key.hash, key.filter, i});
+		}
+	}
+	if (entries.empty()) {
+		return nullptr;
+	}
+	std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) noexcept {
+		return a.hash < b.hash || (a.hash == b.hash && a.word < b.word);
+	});
+
+	// words with same key are grouped as [start, end) in order
+	struct Key {
+		uint64_t hash;
+		range_t filter;
+		range_t group;
+	};
+	std::vector<Key> keys;
+	const range_t orderCount = static_cast<range_t>(entries.size());
+	for (range_t i = 0; i < orderCount; i++) {
+		const Entry &entry = entries[i];
+		if (!keys.empty()) {
+			Key &last = keys.back();
+			if (last.hash == entry.hash && SameWordKey(words[entries[last.group & 0xffff].word], words[entry.word])) {
+				last.group += 1 << 16;
+				continue;
+			}
+		}
+		keys.push_back({entry.hash, entry.filter, i | ((i + 1) << 16)});
+	}
+
+	const range_t keyCount = static_cast<range_t>(keys.size());
+	const range_t buckets = keyCount/4 + 1;
+	const range_t slots = keyCount + keyCount/8 + 1;
+	std::vector<range_t> bucketStart(buckets + 1);
+	for (const Key &key : keys) {
+		++bucketStart[HashBucket(key.hash, buckets) + 1];
+	}
+	std::vector<range_t> bucketOrder(buckets);
+	for (range_t bucket = 0; bucket < buckets; bucket++) {
+		bucketStart[bucket + 1] += bucketStart[bucket];
+		bucketOrder[bucket] = bucket;
+	}
+	std::vector<range_t> bucketKeys(keyCount);
+	{
+		std::vector<range_t> fill(bucketStart.begin(), bucketStart.end() - 1);
+		for (range_t i = 0; i < keyCount; i++) {
+			bucketKeys[fill[HashBucket(keys[i].hash, buckets)]++] = i;
+		}
+	}
+	std::sort(bucketOrder.begin(), bucketOrder.end(), [&bucketStart](range_t a, range_t b) noexcept {
+		return bucketStart[a + 1] - bucketStart[a] > bucketStart[b + 1] - bucketStart[b];
+	});
+
+	std::vector<range_t> displacements(buckets);
+	std::vector<range_t> slotKey(slots, UINT32_MAX);
+	std::vector<range_t> placed;
+	for (const range_t bucket : bucketOrder) {
+		const range_t start = bucketStart[bucket];
+		const range_t end = bucketStart[bucket + 1];
+		if (start == end) {
+			break;
+		}
+		range_t displacement = 0;
+		for (; displacement < MaxHashDisplacement; displacement++) {
+			placed.clear();
+			for (range_t i = start; i < end; i++) {
+				const range_t slot = HashSlot(keys[bucketKeys[i]].hash, displacement, slots);
+				if (slotKey[slot] != UINT32_MAX) {
+					break;
+				}
+				slotKey[slot] = bucketKeys[i];
+				placed.push_back(slot);
+			}
+			if (placed.size() == end - start) {
+				break;
+			}
+			for (const range_t slot : placed) {
+				slotKey[slot] = UINT32_MAX;
+			}
+		}
+		if (displacement == MaxHashDisplacement) {
+			return nullptr;
+		}
+		displacements[bucket] = displacement;
+	}
+
+	range_t * const table = new range_t[buckets + 2*slots + orderCount];
+	std::copy(displacements.begin(), displacements.end(), table);
+	range_t *slotData = table + buckets;
+	for (range_t slot = 0; slot < slots; slot++) {
+		const range_t index = slotKey[slot];
+		if (index == UINT32_MAX) {
+			slotData[0] = 0;
+			slotData[1] = 0;
+		} else {
+			slotData[0] = keys[index].filter;
+			slotData[1] = keys[index].group;
+		}
+		slotData += 2;
+	}
+	for (const Entry &entry : entries) {
+		*slotData++ = entry.word;
+	}
+	bucketCount = buckets;
+	slotCount = slots;
+	return table;
+}
+
 }
 
 WordList::~WordList() {
@@ -136,8 +319,10 @@ void WordList::Clear() noexcept {
 	if (words) {
 		delete[]words;
 		delete[]list;
+		delete[]hashTable;
 		words = nullptr;
 		list = nullptr;
+		hashTable = nullptr;
 		//len = 0;
 	}
 }
@@ -186,9 +371,28 @@ bool WordList::Set(const char *s, KeywordAttr attribute) {
 		assert(static_cast<unsigned>(indexChar - MinIndexChar) < std::size(ranges));
 		ranges[indexChar - MinIndexChar] = start | (i << 16);
 	}
+	BuildHash(len);
 	return true;
 }
 
+void WordList::BuildHash(range_t len) {
+	for (range_t seed = 0; seed < MaxHashSeed; seed++) {
+		hashTable = BuildWordHash(words, len, seed, hashBuckets, hashSlots);
+		if (hashTable) {
+			hashSeed = seed;
+			break;
+		}
+	}
+}
+
+// Returns [start, end) of word indices with same key as s in hash order, or zero.
+range_t WordList::FindGroup(const char *s) const noexcept {
+	const WordKey key = HashWordKey(s, hashSeed);
+	const range_t displacement = hashTable[HashBucket(key.hash, hashBuckets)];
+	const range_t * const slot = hashTable + hashBuckets + 2*HashSlot(key.hash, displacement, hashSlots);
+	return (slot[0] == key.filter) ? slot[1] : 0;
+}
+
 /** Check whether a string is in the list.
  * List elements are either exact matches or prefixes.
  * Prefix elements start with '^' and match all strings that start with the rest of the element
@@ -203,7 +407,18 @@ bool WordList::InList(const char *s) const noexcept {
 		return false;
 	}
 	range_t end = ranges[index];
-	if (end) {
+	if (hashTable) {
+		const range_t group = FindGroup(s);
+		if (group) {
+			const range_t * const order = hashTable + hashBuckets + 2*hashSlots;
+			Range range(group);
+			do {
+				if (strcmp(words[order[range.start]], s) == 0) {
+					return true;
+				}
+			} while (range.Next());
+		}
+	} else if (end) {
 		Range range(end);
 		range_t count = range.Length();
 		if (count < WordListLinearSearchThreshold) {
@@ -275,7 +490,24 @@ bool WordList::InListPrefixed(const char *s, const char marker) const noexcept {
 		return false;
 	}
 	range_t end = ranges[index];
-	if (end) {
+	if (hashTable && marker == WordKeyTerminator) {
+		const range_t group = FindGroup(s);
+		if (group) {
+			const range_t * const order = hashTable + hashBuckets + 2*hashSlots;
+			Range range(group);
+			do {
+				const char *a = words[order[range.start]];
+				const char *b = s;
+				while (*a && *a == *b) {
+					a++;
+					b++;
+				}
+				if ((!*a || *a == marker) && !*b) {
+					return true;
+				}
+			} while (range.Next());
+		}
+	} else if (end) {
 		Range range(end);
 		range_t count = range.Length();
 		if (count < WordListLinearSearchThreshold) {
@@ -291,6 +523,7 @@ bool WordList::InListPrefixed(const char *s, const char marker) const noexcept {
 				}
 			} while (range.Next());
 		} else {
+			// words starting with s are sorted right after the lower bound of s.
 			do {
 				const range_t step = count >> 1;
 				const range_t mid = range.start + step;
@@ -300,17 +533,27 @@ bool WordList::InListPrefixed(const char *s, const char marker) const noexcept {
 					a++;
 					b++;
 				}
-				const int diff = static_cast<unsigned char>(*a) - static_cast<unsigned char>(*b);
-				if (diff == 0 || diff == static_cast<unsigned char>(marker)) {
-					return true;
-				}
-				if (diff < 0) {
+				if (static_cast<unsigned char>(*a) < static_cast<unsigned char>(*b)) {
 					range.start = mid + 1;
 					count -= step + 1;
 				} else {
 					count = step;
 				}
 			} while (count != 0);
+			for (; range.start < range.end; range.start++) {
+				const char *a = words[range.start] + 1;
+				const char *b = s + 1;
+				while (*a && *a == *b) {
+					a++;
+					b++;
+				}
+				if (*b) {
+					break;
+				}
+				if (!*a || *a == marker) {
+					return true;
+				}
+			}
 		}
 	}
 
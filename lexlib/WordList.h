@@ -34,6 +34,15 @@ private:
 	static constexpr unsigned char MinIndexChar = '@';
 	range_t ranges[64 - 2*sizeof(char *)/4]; // make sizeof(WordList) == 256
 #endif
+	// Perfect hash over word keys built by Set(), nullptr when the list is empty or building failed.
+	// Layout: bucket displacements, then (filter, group) for each slot, then word indices grouped by key.
+	range_t *hashTable = nullptr;
+	range_t hashBuckets = 0;
+	range_t hashSlots = 0;
+	range_t hashSeed = 0;
+
+	void BuildHash(range_t len);
+	range_t FindGroup(const char *s) const noexcept;
 public:
 	WordList() noexcept {
 		// Prevent warnings by static analyzers about uninitialized ranges.
@@ -33,6 +33,7 @@
 #include "Partitioning.h"
 #include "RunStyles.h"
 #include "SparseVector.h"
+#include "HistoryStream.h"
 #include "ChangeHistory.h"
 #include "CellBuffer.h"
 #include "UndoHistory.h"
@@ -79,6 +80,7 @@ public:
 	virtual void InsertLines(Sci::Line line, const Sci::Position *positions, size_t lines, bool lineStart) = 0;
 	virtual void SetLineStart(Sci::Line line, Sci::Position position) noexcept = 0;
 	virtual void RemoveLine(Sci::Line line) = 0;
+	virtual void RemoveLines(Sci::Line line, Sci::Line lines) = 0;
 	virtual Sci::Line Lines() const noexcept = 0;
 	virtual void AllocateLines(Sci::Line lines) = 0;
 	virtual Sci::Line LineFromPosition(Sci::Position pos) const noexcept = 0;
@@ -255,6 +257,18 @@ public:
 			perLine->RemoveLine(line);
 		}
 	}
+	void RemoveLines(Sci::Line line, Sci::Line lines) override {
+		starts.RemovePartitions(pos_cast(line), pos_cast(lines));
+		if (FlagSet(activeIndices, LineCharacterIndexType::Utf32)) {
+			startsUTF32.starts.RemovePartitions(pos_cast(line), pos_cast(lines));
+		}
+		if (FlagSet(activeIndices, LineCharacterIndexType::Utf16)) {
+			startsUTF16.starts.RemovePartitions(pos_cast(line), pos_cast(lines));
+		}
+		if (perLine) {
+			perLine->RemoveLines(line, lines);
+		}
+	}
 	Sci::Line Lines() const noexcept override {
 		return line_from_pos_cast(starts.Partitions());
 	}
@@ -414,6 +428,23 @@ int CellBuffer::CheckRange(const char *chars, const char *styles, Sci::Position
 	return result;
 }
 
+Sci::Position CellBuffer::CommonPrefix(const char *chars, const char *styles, Sci::Position position, Sci::Position rangeLength) const noexcept {
+	Sci::Position length = substance.CommonPrefix(chars, position, rangeLength);
+	if (hasStyles && length != 0) {
+		length = style.CommonPrefix(styles, position, length);
+	}
+	return length;
+}
+
+Sci::Position CellBuffer::CommonSuffix(const char *chars, const char *styles, Sci::Position position, Sci::Position rangeLength) const noexcept {
+	Sci::Position length = substance.CommonSuffix(chars, position, rangeLength);
+	if (hasStyles && length != 0) {
+		const Sci::Position offset = rangeLength - length;
+		length = style.CommonSuffix(styles + offset, position + offset, length);
+	}
+	return length;
+}
+
 Sci::Position CellBuffer::GapPosition() const noexcept {
 	return substance.GapPosition();
 }
@@ -456,6 +487,9 @@ const char *CellBuffer::InsertString(Sci::Position position, const char *s, Sci:
 		if (changeHistory) {
 			changeHistory->Insert(position, insertLength, collectingUndo, uh->BeforeReachableSavePoint());
 		}
+		if (collectingUndo) {
+			TrimUndoHistory();
+		}
 	}
 	return data;
 }
@@ -482,18 +516,48 @@ void CopyBytes(char *data, const char *styles, Sci::Position length, ChangedRang
 	}
 }
 
-template <bool segment1>
-void SetBytes(char *data, char styleValue, Sci::Position length, ChangedRange &range, Sci::Position offset) noexcept {
+// Index of first byte in [0, length) that differs from styleValue, or length.
+Sci::Position SameBytesPrefix(const char *data, char styleValue, Sci::Position length) noexcept {
 	Sci::Position index = 0;
+#if NP2_USE_SSE2
+	const __m128i vectStyle = _mm_set1_epi8(styleValue);
+	for (; index + static_cast<Sci::Position>(sizeof(__m128i)) <= length; index += sizeof(__m128i)) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + index));
+		const uint32_t mask = mm_movemask_epi8(_mm_cmpeq_epi8(chunk, vectStyle)) ^ 0xffff;
+		if (mask != 0) {
+			return index + np2_ctz(mask);
+		}
+	}
+#endif
 	while (index < length && data[index] == styleValue) {
 		++index;
 	}
-	--length;
-	while (length > index && data[length] == styleValue) {
+	return index;
+}
+
+// End of last byte in [start, length) that differs from styleValue, or start.
+Sci::Position SameBytesSuffix(const char *data, char styleValue, Sci::Position start, Sci::Position length) noexcept {
+#if NP2_USE_SSE2
+	const __m128i vectStyle = _mm_set1_epi8(styleValue);
+	for (; length - start >= static_cast<Sci::Position>(sizeof(__m128i)); length -= sizeof(__m128i)) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + length - sizeof(__m128i)));
+		const uint32_t mask = mm_movemask_epi8(_mm_cmpeq_epi8(chunk, vectStyle)) ^ 0xffff;
+		if (mask != 0) {
+			return length - static_cast<Sci::Position>(sizeof(__m128i)) + np2_bsr(mask) + 1;
+		}
+	}
+#endif
+	while (length > start && data[length - 1] == styleValue) {
 		--length;
 	}
-	if (index <= length) {
-		++length;
+	return length;
+}
+
+template <bool segment1>
+void SetBytes(char *data, char styleValue, Sci::Position length, ChangedRange &range, Sci::Position offset) noexcept {
+	const Sci::Position index = SameBytesPrefix(data, styleValue, length);
+	if (index < length) {
+		length = SameBytesSuffix(data, styleValue, index + 1, length);
 		memset(data + index, static_cast<unsigned char>(styleValue), length - index);
 		if (segment1 || range.Empty()) {
 			range.start = index + offset;
@@ -564,6 +628,9 @@ const char *CellBuffer::DeleteChars(Sci::Position position, Sci::Position delete
 		}
 
 		BasicDeleteChars(position, deleteLength);
+		if (collectingUndo) {
+			TrimUndoHistory();
+		}
 	}
 	return data;
 }
@@ -731,6 +798,14 @@ void CellBuffer::RemoveLine(Sci::Line line) {
 	plv->RemoveLine(line);
 }
 
+void CellBuffer::RemoveLines(Sci::Line line, Sci::Line lines) {
+	if (lines == 1) {
+		plv->RemoveLine(line);
+	} else if (lines > 1) {
+		plv->RemoveLines(line, lines);
+	}
+}
+
 bool CellBuffer::UTF8LineEndOverlaps(Sci::Position position) const noexcept {
 	const unsigned char bytes[] = {
 		static_cast<unsigned char>(substance.ValueAt(position - 2)),
@@ -1381,9 +1456,12 @@ void CellBuffer::BasicDeleteChars(const Sci::Position position, const Sci::Posit
 			lineRemove++;
 			ignoreNL = true; 	// First \n is not real deletion
 		}
+		// Every line end in the range removes the line at lineRemove so count them
+		// and remove all of those lines together.
+		Sci::Line linesRemoved = 0;
 		if (utf8LineEnds != LineEndType::Default && UTF8IsTrailByte(chNext)) {
 			if (UTF8LineEndOverlaps(position)) {
-				RemoveLine(lineRemove);
+				linesRemoved++;
 			}
 		}
 
@@ -1392,26 +1470,27 @@ void CellBuffer::BasicDeleteChars(const Sci::Position position, const Sci::Posit
 			chNext = substance.ValueAt(position + i + 1);
 			if (ch == '\r') {
 				if (chNext != '\n') {
-					RemoveLine(lineRemove);
+					linesRemoved++;
 				}
 			} else if (ch == '\n') {
 				if (ignoreNL) {
 					ignoreNL = false; 	// Further \n are real deletions
 				} else {
-					RemoveLine(lineRemove);
+					linesRemoved++;
 				}
 			} else if (utf8LineEnds != LineEndType::Default) {
 				if (!UTF8IsAscii(ch)) {
 					const unsigned char next3[3] = { ch, chNext,
 						static_cast<unsigned char>(substance.ValueAt(position + i + 2)) };
 					if (UTF8IsSeparator(next3) || UTF8IsNEL(next3)) {
-						RemoveLine(lineRemove);
+						linesRemoved++;
 					}
 				}
 			}
 
 			ch = chNext;
 		}
+		RemoveLines(lineRemove, linesRemoved);
 		// May have to fix up end if last deletion causes CR to be next to LF
 		// or removes one of a CR LF pair
 		const char chAfter = substance.ValueAt(position + deleteLength);
@@ -1436,8 +1515,8 @@ bool CellBuffer::SetUndoCollection(bool collectUndo) noexcept {
 	return collectingUndo;
 }
 
-void CellBuffer::BeginUndoAction(bool mayCoalesce) noexcept {
-	uh->BeginUndoAction(mayCoalesce);
+void CellBuffer::BeginUndoAction(bool mayCoalesce, bool multipleSelection) noexcept {
+	uh->BeginUndoAction(mayCoalesce, multipleSelection);
 }
 
 void CellBuffer::EndUndoAction() noexcept {
@@ -1455,6 +1534,19 @@ bool CellBuffer::AfterUndoSequenceStart() const noexcept {
 void CellBuffer::AddUndoAction(Sci::Position token, bool mayCoalesce) {
 	bool startSequence = false;
 	uh->AppendAction(ActionType::container, token, nullptr, 0, startSequence, mayCoalesce);
+	TrimUndoHistory();
+}
+
+void CellBuffer::TrimUndoHistory() {
+	const bool reachableSavePoint = uh->SavePoint() >= 0;
+	const size_t deletions = uh->TrimOldest();
+	if (changeHistory) {
+		// Dropped deletions can no longer be undone so forget the history saved for them
+		changeHistory->DropOldestSteps(deletions);
+		if (reachableSavePoint && uh->SavePoint() < 0) {
+			changeHistory->EndReversion();
+		}
+	}
 }
 
 void CellBuffer::DeleteUndoHistory() noexcept {
@@ -1469,12 +1561,24 @@ int CellBuffer::StartUndo() noexcept {
 	return uh->StartUndo();
 }
 
-Action CellBuffer::GetUndoStep() const noexcept {
+Action CellBuffer::GetUndoStep() const {
 	return uh->GetUndoStep();
 }
 
-void CellBuffer::PerformUndoStep() {
-	const Action previousStep = uh->GetUndoStep();
+void CellBuffer::StepRanges(const Action &step, bool undo, std::vector<Action> &ranges) const {
+	ranges.clear();
+	if (step.compound) {
+		DecodeCompound(step, ranges);
+		if (undo) {
+			// Undo ranges in the reverse order to how they were performed
+			std::reverse(ranges.begin(), ranges.end());
+		}
+	} else {
+		ranges.push_back(step);
+	}
+}
+
+void CellBuffer::PerformUndoRange(const Action &previousStep) {
 	// PreviousBeforeSavePoint and AfterDetachPoint are called since acting on the previous action,
 	// that is currentAction-1
 	if (changeHistory && uh->PreviousBeforeSavePoint()) {
@@ -1483,7 +1587,7 @@ void CellBuffer::PerformUndoStep() {
 	if (previousStep.at == ActionType::insert) {
 		if (substance.Length() < previousStep.lenData) {
 			throw std::runtime_error(
-				"CellBuffer::PerformUndoStep: deletion must be less than document length.");
+				"CellBuffer::PerformUndoRange: deletion must be less than document length.");
 		}
 		if (changeHistory) {
 			changeHistory->DeleteRange(previousStep.position, previousStep.lenData,
@@ -1496,6 +1600,9 @@ void CellBuffer::PerformUndoStep() {
 			changeHistory->UndoDeleteStep(previousStep.position, previousStep.lenData, uh->AfterDetachPoint());
 		}
 	}
+}
+
+void CellBuffer::CompletedUndoStep() noexcept {
 	uh->CompletedUndoStep();
 }
 
@@ -1507,12 +1614,11 @@ int CellBuffer::StartRedo() noexcept {
 	return uh->StartRedo();
 }
 
-Action CellBuffer::GetRedoStep() const noexcept {
+Action CellBuffer::GetRedoStep() const {
 	return uh->GetRedoStep();
 }
 
-void CellBuffer::PerformRedoStep() {
-	const Action actionStep = uh->GetRedoStep();
+void CellBuffer::PerformRedoRange(const Action &actionStep) {
 	if (actionStep.at == ActionType::insert) {
 		BasicInsertString(actionStep.position, actionStep.data, actionStep.lenData);
 		if (changeHistory) {
@@ -1529,6 +1635,9 @@ void CellBuffer::PerformRedoStep() {
 	if (changeHistory && uh->AfterSavePoint()) {
 		changeHistory->EndReversion();
 	}
+}
+
+void CellBuffer::CompletedRedoStep() noexcept {
 	uh->CompletedRedoStep();
 }
 
@@ -1562,55 +1671,110 @@ int CellBuffer::UndoTentative() const noexcept {
 
 namespace {
 
-void RestoreChangeHistory(const UndoHistory *uh, ChangeHistory *changeHistory) {
+void ActionRanges(UndoHistory *uh, int act, bool undo, std::vector<Action> &ranges) {
+	const int type = uh->Type(act);
+	Action action{ static_cast<ActionType>(type & ~(coalesceFlag | compoundFlag)), false, uh->Position(act), nullptr, uh->Length(act) };
+	ranges.clear();
+	if (type & compoundFlag) {
+		action.data = uh->Text(act).data();
+		DecodeCompound(action, ranges);
+		if (undo) {
+			std::reverse(ranges.begin(), ranges.end());
+		}
+	} else {
+		ranges.push_back(action);
+	}
+}
+
+void RestoreChangeHistory(UndoHistory *uh, ChangeHistory *changeHistory) {
 	// Replay all undo actions into changeHistory
 	const int savePoint = uh->SavePoint();
 	const int detachPoint = uh->DetachPoint();
 	const int currentPoint = uh->Current();
+	std::vector<Action> ranges;
 	for (int act = 0; act < uh->Actions(); act++) {
-		const ActionType type = static_cast<ActionType>(uh->Type(act) & ~coalesceFlag);
-		const Sci::Position position = uh->Position(act);
-		const Sci::Position length = uh->Length(act);
 		const bool beforeSave = act < savePoint || ((detachPoint >= 0) && (detachPoint > act));
 		const bool afterDetach = (detachPoint >= 0) && (detachPoint < act);
-		switch (type) {
-		case ActionType::insert:
-			changeHistory->Insert(position, length, true, beforeSave);
-			break;
-		case ActionType::remove:
-			changeHistory->DeleteRangeSavingHistory(position, length, beforeSave, afterDetach);
-			break;
-		default:
-			// Only insertions and deletions go into change history
-			break;
+		ActionRanges(uh, act, false, ranges);
+		for (const Action &range : ranges) {
+			switch (range.at) {
+			case ActionType::insert:
+				changeHistory->Insert(range.position, range.lenData, true, beforeSave);
+				break;
+			case ActionType::remove:
+				changeHistory->DeleteRangeSavingHistory(range.position, range.lenData, beforeSave, afterDetach);
+				break;
+			default:
+				// Only insertions and deletions go into change history
+				break;
+			}
 		}
 		changeHistory->Check();
 	}
 	// Undo back to currentPoint, updating change history
 	for (int act = uh->Actions() - 1; act >= currentPoint; act--) {
-		const ActionType type = static_cast<ActionType>(uh->Type(act) & ~coalesceFlag);
-		const Sci::Position position = uh->Position(act);
-		const Sci::Position length = uh->Length(act);
 		const bool beforeSave = act < savePoint;
 		const bool afterDetach = (detachPoint >= 0) && (detachPoint < act);
 		if (beforeSave) {
 			changeHistory->StartReversion();
 		}
-		switch (type) {
-		case ActionType::insert:
-			changeHistory->DeleteRange(position, length, beforeSave && !afterDetach);
-			break;
-		case ActionType::remove:
-			changeHistory->UndoDeleteStep(position, length, afterDetach);
-			break;
-		default:
-			// Only insertions and deletions go into change history
-			break;
+		ActionRanges(uh, act, true, ranges);
+		for (const Action &range : ranges) {
+			switch (range.at) {
+			case ActionType::insert:
+				changeHistory->DeleteRange(range.position, range.lenData, beforeSave && !afterDetach);
+				break;
+			case ActionType::remove:
+				changeHistory->UndoDeleteStep(range.position, range.lenData, afterDetach);
+				break;
+			default:
+				// Only insertions and deletions go into change history
+				break;
+			}
 		}
 		changeHistory->Check();
 	}
 }
 
+// Undo all actions then redo them on a copy of loaded change history, the way
+// PerformUndoRange and PerformRedoRange would, so damaged data throws now
+// instead of during a later undo or redo.
+void ReplayChangeHistory(UndoHistory *uh, ChangeHistory *changeHistory) {
+	const int savePoint = uh->SavePoint();
+	const int detachPoint = uh->DetachPoint();
+	std::vector<Action> ranges;
+	for (int act = uh->Current() - 1; act >= 0; act--) {
+		const bool beforeSave = (savePoint < 0) || (savePoint > act);
+		const bool afterDetach = (detachPoint >= 0) && (detachPoint <= act);
+		ActionRanges(uh, act, true, ranges);
+		for (const Action &range : ranges) {
+			if (beforeSave) {
+				changeHistory->StartReversion();
+			}
+			if (range.at == ActionType::insert) {
+				changeHistory->DeleteRange(range.position, range.lenData, beforeSave && !afterDetach);
+			} else if (range.at == ActionType::remove) {
+				changeHistory->UndoDeleteStep(range.position, range.lenData, afterDetach);
+			}
+		}
+	}
+	for (int act = 0; act < uh->Actions(); act++) {
+		const bool beforeSave = (savePoint < 0) || (savePoint > act);
+		const bool afterDetach = (detachPoint >= 0) && (detachPoint <= act);
+		ActionRanges(uh, act, false, ranges);
+		for (const Action &range : ranges) {
+			if (range.at == ActionType::insert) {
+				changeHistory->Insert(range.position, range.lenData, true, beforeSave && !afterDetach);
+			} else if (range.at == ActionType::remove) {
+				changeHistory->DeleteRangeSavingHistory(range.position, range.lenData, (savePoint > 0) && (savePoint > act), afterDetach);
+			}
+			if ((savePoint >= 0) && (savePoint <= act)) {
+				changeHistory->EndReversion();
+			}
+		}
+	}
+}
+
 }
 
 void CellBuffer::SetUndoCurrent(int action) {
@@ -1647,7 +1811,7 @@ Sci::Position CellBuffer::UndoActionPosition(int action) const noexcept {
 	return uh->Position(action);
 }
 
-std::string_view CellBuffer::UndoActionText(int action) const noexcept {
+std::string_view CellBuffer::UndoActionText(int action) const {
 	return uh->Text(action);
 }
 
@@ -1659,6 +1823,93 @@ void CellBuffer::ChangeLastUndoActionText(size_t length, const char *text) {
 	uh->ChangeLastUndoActionText(length, text);
 }
 
+void CellBuffer::SetUndoSpillThreshold(size_t bytes) noexcept {
+	uh->SetSpillThreshold(bytes);
+}
+
+size_t CellBuffer::UndoSpillThreshold() const noexcept {
+	return uh->SpillThreshold();
+}
+
+void CellBuffer::SetUndoMemoryLimit(size_t bytes) {
+	uh->SetMemoryLimit(bytes);
+	TrimUndoHistory();
+}
+
+size_t CellBuffer::UndoMemoryLimit() const noexcept {
+	return uh->MemoryLimit();
+}
+
+void CellBuffer::SetUndoActionLimit(int actions) {
+	uh->SetActionLimit(actions);
+	TrimUndoHistory();
+}
+
+int CellBuffer::UndoActionLimit() const noexcept {
+	return uh->ActionLimit();
+}
+
+size_t CellBuffer::UndoMemoryUsage() const noexcept {
+	return uh->MemoryUsage();
+}
+
+namespace {
+
+// Saved undo history starts with historyMagic followed by the varint historyVersion and document length.
+constexpr std::string_view historyMagic = "SciUndo";
+constexpr size_t historyVersion = 1;
+
+}
+
+std::string CellBuffer::UndoHistoryData() const {
+	std::string data(historyMagic);
+	HistoryWriter writer(data);
+	writer.Unsigned(historyVersion);
+	writer.Unsigned(Length());
+	uh->Save(writer);
+	writer.Unsigned(changeHistory ? 1 : 0);
+	if (changeHistory) {
+		changeHistory->Save(writer);
+	}
+	return data;
+}
+
+void CellBuffer::SetUndoHistoryData(std::string_view data) {
+	HistoryReader reader(data);
+	if (reader.Bytes(historyMagic.length()) != historyMagic || reader.Unsigned() != historyVersion
+		|| reader.Unsigned() != static_cast<size_t>(Length())) {
+		// Leave current history alone when data is for a different version or document
+		HistoryReader::Fail();
+	}
+	// Current history is only replaced once the undo and change history are both valid
+	UndoHistory uhLoaded;
+	uhLoaded.Load(reader, Length());
+	std::unique_ptr<ChangeHistory> changeHistoryLoaded;
+	if (reader.Unsigned(1)) {
+		HistoryReader readerReplay = reader;
+		changeHistoryLoaded = std::make_unique<ChangeHistory>();
+		changeHistoryLoaded->Load(reader);
+		if (changeHistoryLoaded->Length() != Length()) {
+			HistoryReader::Fail();
+		}
+		ChangeHistory changeHistoryReplay;
+		changeHistoryReplay.Load(readerReplay);
+		ReplayChangeHistory(&uhLoaded, &changeHistoryReplay);
+	}
+	if (!reader.AtEnd()) {
+		HistoryReader::Fail();
+	}
+	uh->Swap(uhLoaded);
+	if (changeHistory) {
+		if (changeHistoryLoaded) {
+			changeHistory = std::move(changeHistoryLoaded);
+		} else {
+			// Saved without change history so rebuild it from the undo actions
+			SetUndoCurrent(uh->Current());
+		}
+	}
+}
+
 void CellBuffer::ChangeHistorySet(bool set) {
 	if (set) {
 		if (!changeHistory && !uh->CanUndo()) {
@@ -1696,3 +1947,12 @@ Sci::Position CellBuffer::EditionNextDelete(Sci::Position pos) const noexcept {
 	}
 	return Length() + 1;
 }
+
+void CellBuffer::EditionRanges(Sci::Position start, Sci::Position end, std::vector<EditionRange> &insertions, std::vector<EditionRange> &deletions) const {
+	if (changeHistory) {
+		changeHistory->EditionRanges(start, end, insertions, deletions);
+	} else {
+		insertions.clear();
+		deletions.clear();
+	}
+}
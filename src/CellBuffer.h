@@ -24,6 +24,8 @@ public:
 	virtual void InsertLine(Sci::Line line) = 0;
 	virtual void InsertLines(Sci::Line line, Sci::Line lines) = 0;
 	virtual void RemoveLine(Sci::Line line) = 0;
+	// Same result as calling RemoveLine(line) lines times.
+	virtual void RemoveLines(Sci::Line line, Sci::Line lines) = 0;
 };
 
 class UndoHistory;
@@ -45,6 +47,7 @@ struct Action {
 	Sci::Position position = 0;
 	const char *data = nullptr;
 	Sci::Position lenData = 0;
+	bool compound = false;
 };
 
 struct SplitView {
@@ -82,6 +85,14 @@ struct ChangedRange {
 	}
 };
 
+// Range of text with an insertion edition or position of deletions for drawing change history.
+// For deletions end is start and edition is a set of bits.
+struct EditionRange {
+	Sci::Position start;
+	Sci::Position end;
+	unsigned int edition;
+};
+
 /**
  * Holder for an expandable array of characters that supports undo and line markers.
  * Based on article "Data Structures in a Bit-Mapped Text Editor"
@@ -112,6 +123,7 @@ private:
 	/// Actions without undo
 	void BasicInsertString(Sci::Position position, const char *s, Sci::Position insertLength);
 	void BasicDeleteChars(Sci::Position position, Sci::Position deleteLength);
+	void TrimUndoHistory();
 
 public:
 	CellBuffer(bool hasStyles_, bool largeDocument_);
@@ -133,6 +145,8 @@ public:
 	const char *BufferPointer() noexcept;
 	const char *RangePointer(Sci::Position position, Sci::Position rangeLength) noexcept;
 	int CheckRange(const char *chars, const char *styles, Sci::Position position, Sci::Position rangeLength) const noexcept;
+	Sci::Position CommonPrefix(const char *chars, const char *styles, Sci::Position position, Sci::Position rangeLength) const noexcept;
+	Sci::Position CommonSuffix(const char *chars, const char *styles, Sci::Position position, Sci::Position rangeLength) const noexcept;
 	Sci::Position GapPosition() const noexcept;
 	SplitView AllView() const noexcept;
 
@@ -162,6 +176,7 @@ public:
 	Sci::Line LineFromPositionIndex(Sci::Position pos, Scintilla::LineCharacterIndexType lineCharacterIndex) const noexcept;
 	void InsertLine(Sci::Line line, Sci::Position position, bool lineStart);
 	void RemoveLine(Sci::Line line);
+	void RemoveLines(Sci::Line line, Sci::Line lines);
 	const char *InsertString(Sci::Position position, const char *s, Sci::Position insertLength, bool &startSequence);
 
 	/// Setting styles for positions outside the range of the buffer is safe and has no effect.
@@ -198,7 +213,7 @@ public:
 	bool IsCollectingUndo() const noexcept {
 		return collectingUndo;
 	}
-	void BeginUndoAction(bool mayCoalesce = false) noexcept;
+	void BeginUndoAction(bool mayCoalesce = false, bool multipleSelection = false) noexcept;
 	void EndUndoAction() noexcept;
 	int UndoSequenceDepth() const noexcept;
 	bool AfterUndoSequenceStart() const noexcept;
@@ -209,12 +224,16 @@ public:
 	/// called that many times. Similarly for redo.
 	bool CanUndo() const noexcept;
 	int StartUndo() noexcept;
-	Action GetUndoStep() const noexcept;
-	void PerformUndoStep();
+	Action GetUndoStep() const;
+	// A step may hold several ranges, each is performed then the step is completed.
+	void StepRanges(const Action &step, bool undo, std::vector<Action> &ranges) const;
+	void PerformUndoRange(const Action &range);
+	void CompletedUndoStep() noexcept;
 	bool CanRedo() const noexcept;
 	int StartRedo() noexcept;
-	Action GetRedoStep() const noexcept;
-	void PerformRedoStep();
+	Action GetRedoStep() const;
+	void PerformRedoRange(const Action &range);
+	void CompletedRedoStep() noexcept;
 
 	int UndoActions() const noexcept;
 	void SetUndoSavePoint(int action) noexcept;
@@ -227,15 +246,25 @@ public:
 	int UndoCurrent() const noexcept;
 	int UndoActionType(int action) const noexcept;
 	Sci::Position UndoActionPosition(int action) const noexcept;
-	std::string_view UndoActionText(int action) const noexcept;
+	std::string_view UndoActionText(int action) const;
 	void PushUndoActionType(int type, Sci::Position position);
 	void ChangeLastUndoActionText(size_t length, const char *text);
+	void SetUndoSpillThreshold(size_t bytes) noexcept;
+	size_t UndoSpillThreshold() const noexcept;
+	void SetUndoMemoryLimit(size_t bytes);
+	size_t UndoMemoryLimit() const noexcept;
+	void SetUndoActionLimit(int actions);
+	int UndoActionLimit() const noexcept;
+	size_t UndoMemoryUsage() const noexcept;
+	std::string UndoHistoryData() const;
+	void SetUndoHistoryData(std::string_view data);
 
 	void ChangeHistorySet(bool set);
 	[[nodiscard]] int EditionAt(Sci::Position pos) const noexcept;
 	[[nodiscard]] Sci::Position EditionEndRun(Sci::Position pos) const noexcept;
 	[[nodiscard]] unsigned int EditionDeletesAt(Sci::Position pos) const noexcept;
 	[[nodiscard]] Sci::Position EditionNextDelete(Sci::Position pos) const noexcept;
+	void EditionRanges(Sci::Position start, Sci::Position end, std::vector<EditionRange> &insertions, std::vector<EditionRange> &deletions) const;
 };
 
 }
@@ -9,13 +9,18 @@
 #include <cstdlib>
 #include <cstdint>
 #include <cassert>
+#include <climits>
 
 #include <stdexcept>
 #include <utility>
+#include <string>
+#include <string_view>
 #include <vector>
 #include <algorithm>
 #include <memory>
 
+#include "ScintillaTypes.h"
+
 #include "Debugging.h"
 
 #include "Position.h"
@@ -23,7 +28,9 @@
 #include "Partitioning.h"
 #include "RunStyles.h"
 #include "SparseVector.h"
+#include "HistoryStream.h"
 #include "ChangeHistory.h"
+#include "CellBuffer.h"
 
 namespace Scintilla::Internal {
 
@@ -63,13 +70,22 @@ void ChangeStack::PushInsertion(Sci::Position positionInsertion, Sci::Position l
 	changes.push_back({ positionInsertion, length, edition, 1, ChangeSpan::Direction::insertion });
 }
 
-int ChangeStack::PopStep() noexcept {
+// Popping more than was pushed is only possible with damaged loaded history,
+// throw so that loading rejects it before any undo.
+
+int ChangeStack::PopStep() {
+	if (steps.empty()) {
+		HistoryReader::Fail();
+	}
 	const int spans = steps.back();
 	steps.pop_back();
 	return spans;
 }
 
-ChangeSpan ChangeStack::PopSpan(int maxSteps) noexcept {
+ChangeSpan ChangeStack::PopSpan(int maxSteps) {
+	if (changes.empty()) {
+		HistoryReader::Fail();
+	}
 	ChangeSpan span = changes.back();
 	const int remove = std::min(maxSteps, span.count);
 	if (span.count == remove) {
@@ -90,6 +106,29 @@ void ChangeStack::SetSavePoint() noexcept {
 	}
 }
 
+void ChangeStack::DropOldest(size_t count) noexcept {
+	// Remove steps from the bottom of the stack along with the spans they counted.
+	// A deletion span may be shared with the next step so reduce its count.
+	count = std::min(count, steps.size());
+	size_t spans = 0;
+	for (size_t i = 0; i < count; i++) {
+		spans += steps[i];
+	}
+	steps.erase(steps.begin(), steps.begin() + count);
+	size_t removed = 0;
+	while (spans > 0 && removed < changes.size()) {
+		ChangeSpan &span = changes[removed];
+		if (static_cast<size_t>(span.count) <= spans) {
+			spans -= span.count;
+			removed++;
+		} else {
+			span.count -= static_cast<int>(spans);
+			spans = 0;
+		}
+	}
+	changes.erase(changes.begin(), changes.begin() + removed);
+}
+
 void ChangeStack::Check() const noexcept {
 #ifndef NDEBUG
 	// Ensure count in steps same as insertions;
@@ -105,6 +144,51 @@ void ChangeStack::Check() const noexcept {
 #endif
 }
 
+void ChangeStack::Save(HistoryWriter &writer) const {
+	writer.Unsigned(steps.size());
+	for (const int step : steps) {
+		writer.Unsigned(step);
+	}
+	writer.Unsigned(changes.size());
+	for (const ChangeSpan &span : changes) {
+		writer.Unsigned(span.start);
+		writer.Unsigned(span.length);
+		writer.Signed(span.edition);
+		writer.Unsigned(span.count);
+		writer.Unsigned(static_cast<size_t>(span.direction));
+	}
+}
+
+void ChangeStack::Load(HistoryReader &reader) {
+	Clear();
+	size_t sizeSteps = 0;
+	const size_t countSteps = reader.Unsigned();
+	for (size_t i = 0; i < countSteps; i++) {
+		const int step = static_cast<int>(reader.Unsigned(INT_MAX));
+		steps.push_back(step);
+		sizeSteps += step;
+	}
+	size_t sizeChanges = 0;
+	const size_t countChanges = reader.Unsigned();
+	for (size_t i = 0; i < countChanges; i++) {
+		ChangeSpan &span = changes.emplace_back();
+		span.start = reader.Unsigned(PTRDIFF_MAX);
+		span.length = reader.Unsigned(PTRDIFF_MAX);
+		span.edition = static_cast<int>(reader.Signed(INT_MIN, changeRevertedToChange));
+		span.count = static_cast<int>(reader.Unsigned(INT_MAX));
+		span.direction = static_cast<ChangeSpan::Direction>(reader.Unsigned(1));
+		// Insertions are never compressed and deletions are at a single position
+		const bool insertion = span.direction == ChangeSpan::Direction::insertion;
+		if (span.count == 0 || (insertion ? (span.count != 1 || span.length == 0) : (span.length != 0 || span.edition == 0))) {
+			HistoryReader::Fail();
+		}
+		sizeChanges += span.count;
+	}
+	if (sizeSteps != sizeChanges) {
+		HistoryReader::Fail();
+	}
+}
+
 void ChangeLog::Clear(Sci::Position length) {
 	changeStack.Clear();
 	insertEdition.DeleteAll();
@@ -239,23 +323,36 @@ void ChangeLog::SaveRange(Sci::Position position, Sci::Position length) {
 void ChangeLog::PopDeletion(Sci::Position position, Sci::Position deleteLength) {
 	// Just performed InsertSpace(position, deleteLength) so *this* element in
 	// deleteEdition moved forward by deleteLength
+	const EditionSetOwned empty{};
+	if (!deleteEdition.ValueOr(position + deleteLength, empty)) {
+		HistoryReader::Fail();
+	}
 	EditionSetOwned eso = deleteEdition.Extract(position + deleteLength);
 	deleteEdition.SetValueAt(position, std::move(eso));
-	const EditionSetOwned empty{};
-	const EditionSetOwned &editions = deleteEdition.ValueOr(position, empty);
-	assert(editions);
+	// Keep the set rather than its owner as InsertFrontDeletionAt may move owners
+	EditionSet * const editions = deleteEdition.ValueOr(position, empty).get();
+	if (!editions || editions->empty()) {
+		HistoryReader::Fail();
+	}
 	EditionSetPop(*editions);
 	const int inserts = changeStack.PopStep();
 	for (int i = 0; i < inserts;) {
-		const ChangeSpan span = changeStack.PopSpan(inserts);
+		const ChangeSpan span = changeStack.PopSpan(inserts - i);
+		if (span.start > Length() || span.length > Length() - span.start) {
+			HistoryReader::Fail();
+		}
 		if (span.direction == ChangeSpan::Direction::insertion) {
 			assert(span.count == 1);	// Insertions are never compressed
 			insertEdition.FillRange(span.start, span.edition, span.length);
 			i++;
 		} else {
-			assert(editions);
-			assert(editions->back().edition == span.edition);
+			if (editions->empty() || editions->back().edition != span.edition) {
+				HistoryReader::Fail();
+			}
 			for (int j = 0; j < span.count; j++) {
+				if (editions->empty()) {
+					HistoryReader::Fail();
+				}
 				EditionSetPop(*editions);
 			}
 			// Iterating backwards (pop) through changeStack, reverse order of insertion
@@ -337,6 +434,79 @@ void ChangeLog::Check() const noexcept {
 #endif
 }
 
+void ChangeLog::Save(HistoryWriter &writer) const {
+	const Sci::Position length = Length();
+	writer.Unsigned(length);
+	// Insertion editions as runs
+	for (Sci::Position position = 0; position < length;) {
+		const Sci::Position endRun = insertEdition.EndRun(position);
+		writer.Unsigned(endRun - position);
+		writer.Signed(insertEdition.ValueAt(position));
+		position = endRun;
+	}
+	// Deletions as distance from previous deletion followed by their editions
+	const EditionSetOwned empty{};
+	size_t deletions = 0;
+	for (Sci::Position position = 0; position <= length; position = deleteEdition.PositionNext(position)) {
+		deletions += deleteEdition.ValueOr(position, empty) != nullptr;
+	}
+	writer.Unsigned(deletions);
+	Sci::Position previous = 0;
+	for (Sci::Position position = 0; position <= length; position = deleteEdition.PositionNext(position)) {
+		const EditionSetOwned &editions = deleteEdition.ValueOr(position, empty);
+		if (editions) {
+			writer.Unsigned(position - previous);
+			writer.Unsigned(editions->size());
+			for (const EditionCount &ec : *editions) {
+				writer.Signed(ec.edition);
+				writer.Unsigned(ec.count);
+			}
+			previous = position;
+		}
+	}
+	changeStack.Save(writer);
+}
+
+void ChangeLog::Load(HistoryReader &reader) {
+	const Sci::Position length = reader.Unsigned(PTRDIFF_MAX);
+	Clear(length);
+	for (Sci::Position position = 0; position < length;) {
+		const Sci::Position lengthRun = reader.Unsigned(length - position);
+		const int edition = static_cast<int>(reader.Signed(INT_MIN, changeRevertedToChange));
+		if (lengthRun == 0) {
+			HistoryReader::Fail();
+		}
+		if (edition) {
+			insertEdition.FillRange(position, edition, lengthRun);
+		}
+		position += lengthRun;
+	}
+	const size_t deletions = reader.Unsigned();
+	Sci::Position position = 0;
+	for (size_t i = 0; i < deletions; i++) {
+		const Sci::Position distance = reader.Unsigned(length - position);
+		if (i > 0 && distance == 0) {
+			HistoryReader::Fail();
+		}
+		position += distance;
+		EditionSetOwned editions = std::make_unique<EditionSet>();
+		const size_t count = reader.Unsigned();
+		if (count == 0) {
+			HistoryReader::Fail();
+		}
+		for (size_t j = 0; j < count; j++) {
+			const int edition = static_cast<int>(reader.Signed(INT_MIN, changeRevertedToChange));
+			const int countEdition = static_cast<int>(reader.Unsigned(INT_MAX));
+			if (edition == 0 || countEdition == 0) {
+				HistoryReader::Fail();
+			}
+			editions->push_back({ edition, countEdition });
+		}
+		deleteEdition.SetValueAt(position, std::move(editions));
+	}
+	changeStack.Load(reader);
+}
+
 ChangeHistory::ChangeHistory(Sci::Position length) {
 	changeLog.Clear(length);
 }
@@ -412,6 +582,12 @@ void ChangeHistory::UndoDeleteStep(Sci::Position position, Sci::Position deleteL
 	Check();
 }
 
+void ChangeHistory::DropOldestSteps(size_t count) noexcept {
+	if (count) {
+		changeLog.changeStack.DropOldest(count);
+	}
+}
+
 Sci::Position ChangeHistory::Length() const noexcept {
 	return changeLog.Length();
 }
@@ -420,6 +596,29 @@ void ChangeHistory::SetEpoch(int epoch) noexcept {
 	historicEpoch = epoch;
 }
 
+void ChangeHistory::Save(HistoryWriter &writer) const {
+	writer.Signed(historicEpoch);
+	changeLog.Save(writer);
+	writer.Unsigned(changeLogReversions ? 1 : 0);
+	if (changeLogReversions) {
+		changeLogReversions->Save(writer);
+	}
+}
+
+void ChangeHistory::Load(HistoryReader &reader) {
+	historicEpoch = static_cast<int>(reader.Signed(INT_MIN, INT_MAX));
+	changeLog.Load(reader);
+	changeLogReversions.reset();
+	if (reader.Unsigned(1)) {
+		changeLogReversions = std::make_unique<ChangeLog>();
+		changeLogReversions->Load(reader);
+		if (changeLogReversions->Length() != changeLog.Length()) {
+			HistoryReader::Fail();
+		}
+	}
+	Check();
+}
+
 void ChangeHistory::EditionCreateHistory(Sci::Position start, Sci::Position length) {
 	if (start <= changeLog.Length()) {
 		if (length) {
@@ -437,16 +636,49 @@ void ChangeHistory::EditionCreateHistory(Sci::Position start, Sci::Position leng
 // 2 Saved
 // 3 Unsaved
 // 4 Reverted to change
+namespace {
+
+constexpr int CombineEdition(int edition, int editionReversion) noexcept {
+	if (editionReversion) {
+		if (edition < 0) {	// Historical revision
+			return changeRevertedOriginal;
+		}
+		return edition ? changeRevertedToChange : changeRevertedOriginal;
+	}
+	return edition;
+}
+
+// Produce a 4-bit value from the deletions at a position
+unsigned int CombineDeletions(const EditionSetOwned &editionSetDeletions, const EditionSetOwned &editionSetReversions) noexcept {
+	unsigned int editionSet = 0;
+	if (editionSetDeletions) {
+		for (const EditionCount &ec : *editionSetDeletions) {
+			editionSet = editionSet | (1u << (ec.edition-1));
+		}
+	}
+	if (editionSetReversions) {
+		// If there is no saved or modified -> revertedToOrigin
+		if (!(editionSet & (bitSaved | bitModified))) {
+			editionSet = editionSet | bitRevertedToOriginal;
+		} else {
+			editionSet = editionSet | bitRevertedToModified;
+		}
+	}
+	return editionSet;
+}
+
+// First deletion element at or after position
+Sci::Position DeletionElement(const SparseVector<EditionSetOwned> &deleteEdition, Sci::Position position) noexcept {
+	const Sci::Position element = deleteEdition.ElementFromPosition(position);
+	return (deleteEdition.PositionOfElement(element) < position) ? element + 1 : element;
+}
+
+}
+
 int ChangeHistory::EditionAt(Sci::Position pos) const noexcept {
 	const int edition = changeLog.insertEdition.ValueAt(pos);
 	if (changeLogReversions) {
-		const int editionReversion = changeLogReversions->insertEdition.ValueAt(pos);
-		if (editionReversion) {
-			if (edition < 0) {	// Historical revision
-				return changeRevertedOriginal;
-			}
-			return edition ? changeRevertedToChange : changeRevertedOriginal;
-		}
+		return CombineEdition(edition, changeLogReversions->insertEdition.ValueAt(pos));
 	}
 	return edition;
 }
@@ -461,28 +693,13 @@ Sci::Position ChangeHistory::EditionEndRun(Sci::Position pos) const noexcept {
 	return changeLog.insertEdition.EndRun(pos);
 }
 
-// Produce a 4-bit value from the deletions at a position
 unsigned int ChangeHistory::EditionDeletesAt(Sci::Position pos) const noexcept {
-	unsigned int editionSet = 0;
 	const EditionSetOwned empty{};
 	const EditionSetOwned &editionSetDeletions = changeLog.deleteEdition.ValueOr(pos, empty);
-	if (editionSetDeletions) {
-		for (const EditionCount &ec : *editionSetDeletions) {
-			editionSet = editionSet | (1u << (ec.edition-1));
-		}
-	}
 	if (changeLogReversions) {
-		const EditionSetOwned &editionSetReversions = changeLogReversions->deleteEdition.ValueOr(pos, empty);
-		if (editionSetReversions) {
-			// If there is no saved or modified -> revertedToOrigin
-			if (!(editionSet & (bitSaved | bitModified))) {
-				editionSet = editionSet | bitRevertedToOriginal;
-			} else {
-				editionSet = editionSet | bitRevertedToModified;
-			}
-		}
+		return CombineDeletions(editionSetDeletions, changeLogReversions->deleteEdition.ValueOr(pos, empty));
 	}
-	return editionSet;
+	return CombineDeletions(editionSetDeletions, empty);
 }
 
 Sci::Position ChangeHistory::EditionNextDelete(Sci::Position pos) const noexcept {
@@ -494,6 +711,76 @@ Sci::Position ChangeHistory::EditionNextDelete(Sci::Position pos) const noexcept
 	return next;
 }
 
+void ChangeHistory::EditionRanges(Sci::Position start, Sci::Position end, std::vector<EditionRange> &insertions, std::vector<EditionRange> &deletions) const {
+	insertions.clear();
+	deletions.clear();
+	const Sci::Position length = Length();
+	end = std::min(end, length);
+	start = std::clamp<Sci::Position>(start, 0, end);
+
+	// Step through runs of both logs, splitting at the boundaries of each
+	const RunStyles<Sci::Position, int> &insertEdition = changeLog.insertEdition;
+	const RunStyles<Sci::Position, int> *insertReversion = changeLogReversions ? &changeLogReversions->insertEdition : nullptr;
+	Sci::Position run = insertEdition.RunAt(start);
+	Sci::Position runReversion = insertReversion ? insertReversion->RunAt(start) : 0;
+	for (Sci::Position position = start; position < end;) {
+		const Sci::Position endRun = insertEdition.RunStart(run + 1);
+		Sci::Position next = endRun;
+		int edition = insertEdition.RunValue(run);
+		Sci::Position endRunReversion = length;
+		if (insertReversion) {
+			endRunReversion = insertReversion->RunStart(runReversion + 1);
+			next = std::min(next, endRunReversion);
+			edition = CombineEdition(edition, insertReversion->RunValue(runReversion));
+		}
+		next = std::min(next, end);
+		if (edition) {
+			if (!insertions.empty() && insertions.back().end == position && insertions.back().edition == static_cast<unsigned int>(edition)) {
+				insertions.back().end = next;
+			} else {
+				insertions.push_back({ position, next, static_cast<unsigned int>(edition) });
+			}
+		}
+		position = next;
+		if (position == endRun) {
+			run++;
+		}
+		if (insertReversion && position == endRunReversion) {
+			runReversion++;
+		}
+	}
+
+	// Merge deletion positions of both logs
+	const EditionSetOwned empty{};
+	const SparseVector<EditionSetOwned> &deleteEdition = changeLog.deleteEdition;
+	const SparseVector<EditionSetOwned> *deleteReversion = changeLogReversions ? &changeLogReversions->deleteEdition : nullptr;
+	Sci::Position element = DeletionElement(deleteEdition, start);
+	Sci::Position elementReversion = deleteReversion ? DeletionElement(*deleteReversion, start) : 0;
+	const Sci::Position elements = deleteEdition.Elements();
+	const Sci::Position elementsReversion = deleteReversion ? deleteReversion->Elements() : 0;
+	while (true) {
+		const Sci::Position position = (element <= elements) ? deleteEdition.PositionOfElement(element) : length + 1;
+		const Sci::Position positionReversion = (deleteReversion && elementReversion <= elementsReversion) ?
+			deleteReversion->PositionOfElement(elementReversion) : length + 1;
+		const Sci::Position positionNext = std::min(position, positionReversion);
+		if (positionNext > end) {
+			break;
+		}
+		const EditionSetOwned &editions = (position == positionNext) ? deleteEdition.ElementValueOr(element, empty) : empty;
+		const EditionSetOwned &editionsReversion = (positionReversion == positionNext) ? deleteReversion->ElementValueOr(elementReversion, empty) : empty;
+		const unsigned int editionSet = CombineDeletions(editions, editionsReversion);
+		if (editionSet) {
+			deletions.push_back({ positionNext, positionNext, editionSet });
+		}
+		if (position == positionNext) {
+			element++;
+		}
+		if (positionReversion == positionNext) {
+			elementReversion++;
+		}
+	}
+}
+
 size_t ChangeHistory::DeletionCount(Sci::Position start, Sci::Position length) const noexcept {
 	return changeLog.DeletionCount(start, length);
 }
@@ -41,6 +41,8 @@ struct EditionCount {
 using EditionSet = std::vector<EditionCount>;
 using EditionSetOwned = std::unique_ptr<EditionSet>;
 
+struct EditionRange;
+
 class ChangeStack {
 	std::vector<int> steps;
 	std::vector<ChangeSpan> changes;
@@ -49,10 +51,13 @@ public:
 	void AddStep();
 	void PushDeletion(Sci::Position positionDeletion, const EditionCount &ec);
 	void PushInsertion(Sci::Position positionInsertion, Sci::Position length, int edition);
-	[[nodiscard]] int PopStep() noexcept;
-	[[nodiscard]] ChangeSpan PopSpan(int maxSteps) noexcept;
+	[[nodiscard]] int PopStep();
+	[[nodiscard]] ChangeSpan PopSpan(int maxSteps);
 	void SetSavePoint() noexcept;
+	void DropOldest(size_t count) noexcept;
 	void Check() const noexcept;
+	void Save(HistoryWriter &writer) const;
+	void Load(HistoryReader &reader);
 };
 
 struct ChangeLog {
@@ -77,6 +82,8 @@ struct ChangeLog {
 	Sci::Position Length() const noexcept;
 	[[nodiscard]] size_t DeletionCount(Sci::Position start, Sci::Position length) const noexcept;
 	void Check() const noexcept;
+	void Save(HistoryWriter &writer) const;
+	void Load(HistoryReader &reader);
 };
 
 enum class ReversionState { clear, reverting, detached };
@@ -99,6 +106,7 @@ public:
 	void SetSavePoint();
 
 	void UndoDeleteStep(Sci::Position position, Sci::Position deleteLength, bool isDetached);
+	void DropOldestSteps(size_t count) noexcept;
 
 	[[nodiscard]] Sci::Position Length() const noexcept;
 
@@ -106,11 +114,18 @@ public:
 	void SetEpoch(int epoch) noexcept;
 	void EditionCreateHistory(Sci::Position start, Sci::Position length);
 
+	// Saving and restoring with undo history
+	void Save(HistoryWriter &writer) const;
+	void Load(HistoryReader &reader);
+
 	// Queries for drawing
 	[[nodiscard]] int EditionAt(Sci::Position pos) const noexcept;
 	[[nodiscard]] Sci::Position EditionEndRun(Sci::Position pos) const noexcept;
 	[[nodiscard]] unsigned int EditionDeletesAt(Sci::Position pos) const noexcept;
 	[[nodiscard]] Sci::Position EditionNextDelete(Sci::Position pos) const noexcept;
+	// Insertions with non-zero editions overlapping [start, end) and deletions in [start, end]
+	// found with one search for each log instead of a search for each run
+	void EditionRanges(Sci::Position start, Sci::Position end, std::vector<EditionRange> &insertions, std::vector<EditionRange> &deletions) const;
 
 	// Testing - not used by Scintilla
 	[[nodiscard]] size_t DeletionCount(Sci::Position start, Sci::Position length) const noexcept;
@@ -22,11 +22,11 @@
 #include <vector>
 #include <array>
 //#include <map>
-#include <forward_list>
 #include <optional>
 #include <algorithm>
 #include <iterator>
 #include <memory>
+#include <atomic>
 
 #include <windows.h>
 #if defined(BOOST_REGEX_STANDALONE)
@@ -59,6 +59,7 @@
 #include "RESearch.h"
 #include "UniConversion.h"
 #include "ElapsedPeriod.h"
+#include "FrameTrace.h"
 
 using namespace Scintilla;
 using namespace Scintilla::Internal;
@@ -86,19 +87,72 @@ void LexInterface::Colourise(Sci::Position start, Sci::Position end) {
 		PLATFORM_ASSERT(start + len <= lengthDoc);
 
 		if (len > 0) {
+			const TraceScope traceScope(FrameTraceSpan::Colourise, start, end);
+			// Only lexers that restart from the line state alone may keep styles from before text changes.
+			const Sci::Position endStale = (instance->Version() >= lvLineResume) ? pdoc->GetEndStaleStyled() : 0;
+			// After text changes, lex a growing number of lines at a time. When an unchanged line
+			// ends with the same line state and style as before and lexing resumes after it without
+			// backtracking, styles after that are the same as before and lexing stops.
+			Sci::Line line = std::max(pdoc->SciLineFromPosition(start), pdoc->SciLineFromPosition(pdoc->GetEndChanged()) + 1) + 1;
+			Sci::Line lineStep = 1;
+			Sci::Position pos = start;
+			Sci::Position posConverged = -1;
+			while (pos < end) {
+				const Sci::Position lineStart = pdoc->LineStart(line);
+				const bool converge = endStale > start && lineStart <= end && lineStart <= endStale;
+				const Sci::Position lexEnd = converge ? lineStart : end;
+				int lineState = 0;
+				unsigned char style = 0;
+				if (converge) {
+					lineState = pdoc->GetLineState(line - 1);
+					style = pdoc->StyleIndexAt(lineStart - 1);
+				}
+				int styleStart = 0;
+				if (pos > 0) {
+					styleStart = pdoc->StyleIndexAt(pos - 1);
+				}
+				pdoc->ResetStartStyled(pos);
+				instance->Lex(pos, lexEnd - pos, styleStart, pdoc);
+				if (pos == posConverged && pdoc->GetStartStyled() == pos) {
+					pos = lexEnd;
+					pdoc->KeepStaleStyles();
+					break;
+				}
+				pos = lexEnd;
+				posConverged = -1;
+				if (converge && lineState == pdoc->GetLineState(line - 1) && style == pdoc->StyleIndexAt(lineStart - 1)) {
+					posConverged = pos;
+				}
+				line += lineStep;
+				lineStep *= 2;
+			}
+			if (enableUrlHighlight) {
+				pdoc->HighlightUrl(start, pos - start, urlIgnoreStyle);
+			}
+		}
+
+		performingStyle = false;
+	}
+}
+
+// Fold levels are calculated separately from styling so they are only found
+// for text that is displayed or queried, see Document::EnsureFoldedTo.
+bool LexInterface::Fold(Sci::Position start, Sci::Position end) {
+	if (pdoc && instance && !performingStyle) {
+		performingStyle = true;
+		const Sci::Position len = end - start;
+		if (len > 0) {
+			const TraceScope traceScope(FrameTraceSpan::Fold, start, end);
 			int styleStart = 0;
 			if (start > 0) {
 				styleStart = pdoc->StyleIndexAt(start - 1);
 			}
-			instance->Lex(start, len, styleStart, pdoc);
 			instance->Fold(start, len, styleStart, pdoc);
-			if (enableUrlHighlight) {
-				pdoc->HighlightUrl(start, len, urlIgnoreStyle);
-			}
 		}
-
 		performingStyle = false;
+		return true;
 	}
+	return false;
 }
 
 bool LexInterface::UseContainerLexing() const noexcept {
@@ -221,6 +275,13 @@ void Document::RemoveLine(Sci::Line line) {
 	}
 }
 
+void Document::RemoveLines(Sci::Line line, Sci::Line lines) {
+	for (const auto &pl : perLineData) {
+		if (pl)
+			pl->RemoveLines(line, lines);
+	}
+}
+
 LineMarkers *Document::Markers() const noexcept {
 	return static_cast<LineMarkers *>(perLineData[ldMarkers].get());
 }
@@ -323,44 +384,54 @@ void Document::TentativeUndo() {
 			bool multiLine = false;
 			const int steps = cb.TentativeSteps();
 			//Platform::DebugPrintf("Steps=%d\n", steps);
+			std::vector<Action> ranges;
 			for (int step = 0; step < steps; step++) {
-				const Sci::Line prevLinesTotal = LinesTotal();
-				const Action action = cb.GetUndoStep();
-				if (action.at == ActionType::remove) {
-					NotifyModified(DocModification(
-						ModificationFlags::BeforeInsert | ModificationFlags::Undo, action));
-				} else if (action.at == ActionType::container) {
-					DocModification dm(ModificationFlags::Container | ModificationFlags::Undo);
-					dm.token = action.position;
-					NotifyModified(dm);
-				} else {
-					NotifyModified(DocModification(
-						ModificationFlags::BeforeDelete | ModificationFlags::Undo, action));
-				}
-				cb.PerformUndoStep();
-				if (action.at != ActionType::container) {
-					ModifiedAt(action.position);
+				if (!ReadStepRanges(true, ranges)) {
+					break;
 				}
+				for (size_t range = 0; range < ranges.size(); range++) {
+					const Sci::Line prevLinesTotal = LinesTotal();
+					const Action &action = ranges[range];
+					if (action.at == ActionType::remove) {
+						NotifyModified(DocModification(
+							ModificationFlags::BeforeInsert | ModificationFlags::Undo, action));
+					} else if (action.at == ActionType::container) {
+						DocModification dm(ModificationFlags::Container | ModificationFlags::Undo);
+						dm.token = action.position;
+						NotifyModified(dm);
+					} else {
+						NotifyModified(DocModification(
+							ModificationFlags::BeforeDelete | ModificationFlags::Undo, action));
+					}
+					cb.PerformUndoRange(action);
+					if (action.at != ActionType::container) {
+						ModifiedTextAt(action.position, action.position, (action.at == ActionType::remove) ? action.lenData : -action.lenData);
+					}
 
-				ModificationFlags modFlags = ModificationFlags::Undo;
-				// With undo, an insertion action becomes a deletion notification
-				if (action.at == ActionType::remove) {
-					modFlags |= ModificationFlags::InsertText;
-				} else if (action.at == ActionType::insert) {
-					modFlags |= ModificationFlags::DeleteText;
-				}
-				if (steps > 1)
-					modFlags |= ModificationFlags::MultiStepUndoRedo;
-				const Sci::Line linesAdded = LinesTotal() - prevLinesTotal;
-				if (linesAdded != 0)
-					multiLine = true;
-				if (step == steps - 1) {
-					modFlags |= ModificationFlags::LastStepInUndoRedo;
-					if (multiLine)
-						modFlags |= ModificationFlags::MultilineUndoRedo;
+					ModificationFlags modFlags = ModificationFlags::Undo;
+					// With undo, an insertion action becomes a deletion notification
+					if (action.at == ActionType::remove) {
+						modFlags |= ModificationFlags::InsertText;
+					} else if (action.at == ActionType::insert) {
+						modFlags |= ModificationFlags::DeleteText;
+					}
+					if ((steps > 1) || (ranges.size() > 1))
+						modFlags |= ModificationFlags::MultiStepUndoRedo;
+					const Sci::Line linesAdded = LinesTotal() - prevLinesTotal;
+					if (linesAdded != 0)
+						multiLine = true;
+					if ((step == steps - 1) && (range == ranges.size() - 1)) {
+						modFlags |= ModificationFlags::LastStepInUndoRedo;
+						if (multiLine)
+							modFlags |= ModificationFlags::MultilineUndoRedo;
+					}
+					if (range == ranges.size() - 1) {
+						// Complete the step before its last notification so UndoCurrent is already updated
+						cb.CompletedUndoStep();
+					}
+					NotifyModified(DocModification(modFlags, action.position, action.lenData,
+						linesAdded, action.data));
 				}
-				NotifyModified(DocModification(modFlags, action.position, action.lenData,
-					linesAdded, action.data));
 			}
 
 			const bool endSavePoint = cb.IsSavePoint();
@@ -406,6 +477,11 @@ void Document::SetUndoCurrent(int action) {
 	cb.SetUndoCurrent(action);
 }
 
+void Document::SetUndoHistoryData(std::string_view data) {
+	cb.SetUndoHistoryData(data);
+	NotifySavePoint(cb.IsSavePoint());
+}
+
 int Document::UndoCurrent() const noexcept {
 	return cb.UndoCurrent();
 }
@@ -418,7 +494,7 @@ Sci::Position Document::UndoActionPosition(int action) const noexcept {
 	return cb.UndoActionPosition(action);
 }
 
-std::string_view Document::UndoActionText(int action) const noexcept {
+std::string_view Document::UndoActionText(int action) const {
 	return cb.UndoActionText(action);
 }
 
@@ -437,17 +513,22 @@ MarkerMask Document::GetMark(Sci::Line line, bool includeChangeHistory) const no
 
 		const Sci::Position start = LineStart(line);
 		const Sci::Position lineNext = LineStart(line + 1);
-		for (Sci::Position position = start; position < lineNext;) {
-			const int edition = EditionAt(position);
-			if (edition) {
-				marksEdition |= 1U << (edition - 1);
-			}
-			position = EditionEndRun(position);
-		}
 		const Sci::Position lineEnd = LineEnd(line);
-		for (Sci::Position position = start; position <= lineEnd;) {
-			marksEdition |= EditionDeletesAt(position);
-			position = EditionNextDelete(position);
+		try {
+			std::vector<EditionRange> insertions;
+			std::vector<EditionRange> deletions;
+			EditionRanges(start, lineNext, insertions, deletions);
+			for (const EditionRange &range : insertions) {
+				marksEdition |= 1U << (range.edition - 1);
+			}
+			// deletions inside line end are not marked on this line
+			for (const EditionRange &range : deletions) {
+				if (range.start <= lineEnd) {
+					marksEdition |= range.edition;
+				}
+			}
+		} catch (...) {
+			// out of memory, show markers without change history
 		}
 
 		/* Bits: RevertedToOrigin, Saved, Modified, RevertedToModified */
@@ -656,14 +737,19 @@ Sci::Line Document::GetLastChild(Sci::Line lineParent, FoldLevel level, Sci::Lin
 	if (lastLine < 0 || lastLine > maxLine) {
 		lastLine = maxLine;
 	}
-	Sci::Line lineEndStyled = SciLineFromPosition(GetEndStyled()) - 1;
+	Sci::Line lineEndStyled = SciLineFromPosition(GetEndFolded()) - 1;
 	Sci::Line lineMaxSubord = lineParent;
 	while (lineMaxSubord < maxLine) {
 		if (lineMaxSubord >= lineEndStyled) {
 			// two or more lines are required to make stable fold for most lexer
-			EnsureStyledTo(LineStart(lineMaxSubord + 2 + 1));
+			EnsureFoldedTo(LineStart(lineMaxSubord + 2 + 1));
 			// LexerBase::Fold() already moved one line back
-			lineEndStyled = SciLineFromPosition(GetEndStyled()) - 1;
+			lineEndStyled = SciLineFromPosition(GetEndFolded()) - 1;
+		}
+		const Sci::Line lineSkipEnd = std::min(lineEndStyled, lastLine);
+		if (lineMaxSubord + 1 < lineSkipEnd) {
+			// Jump over styled lines inside the fold, leaving the last one for the checks below
+			lineMaxSubord = Levels()->FindLevelAtOrBelow(lineMaxSubord + 1, lineSkipEnd, levelStart) - 1;
 		}
 		if (!IsSubordinate(levelStart, GetFoldLevel(lineMaxSubord + 1)))
 			break;
@@ -1298,6 +1384,35 @@ EncodingFamily Document::CodePageFamily() const noexcept {
 void Document::ModifiedAt(Sci::Position pos) noexcept {
 	if (endStyled > pos)
 		endStyled = pos;
+	if (endStaleStyled > pos)
+		endStaleStyled = pos;
+	if (endFolded > pos)
+		endFolded = pos;
+}
+
+// Text inserted (lengthChange > 0) or deleted at position, restyle from pos while
+// keeping shifted styles after the change for LexInterface::Colourise.
+void Document::ModifiedTextAt(Sci::Position pos, Sci::Position position, Sci::Position lengthChange) noexcept {
+	Sci::Position styledEnd = std::max(endStyled, endStaleStyled);
+	Sci::Position changedEnd = (endStaleStyled > endStyled) ? endChanged : 0;
+	if (lengthChange > 0) {
+		if (styledEnd > position) {
+			styledEnd += lengthChange;
+		}
+		if (changedEnd > position) {
+			changedEnd += lengthChange;
+		}
+		changedEnd = std::max(changedEnd, position + lengthChange);
+	} else {
+		const Sci::Position deleteEnd = position - lengthChange;
+		styledEnd = (styledEnd > deleteEnd) ? styledEnd + lengthChange : std::min(styledEnd, position);
+		changedEnd = (changedEnd > deleteEnd) ? changedEnd + lengthChange : position;
+	}
+	ModifiedAt(pos);
+	if (styledEnd > endStyled) {
+		endStaleStyled = styledEnd;
+		endChanged = changedEnd;
+	}
 }
 
 void Document::CheckReadOnly() noexcept {
@@ -1351,9 +1466,9 @@ bool Document::DeleteChars(Sci::Position pos, Sci::Position len) {
 		if (startSavePoint && cb.IsCollectingUndo())
 			NotifySavePoint(false);
 		if ((pos < LengthNoExcept()) || (pos == 0))
-			ModifiedAt(pos);
+			ModifiedTextAt(pos, pos, -len);
 		else
-			ModifiedAt(pos - 1);
+			ModifiedTextAt(pos - 1, pos, -len);
 		NotifyModified(
 			DocModification(
 				ModificationFlags::DeleteText | ModificationFlags::User |
@@ -1438,7 +1553,7 @@ Sci::Position Document::InsertString(Sci::Position position, const char *s, Sci:
 #endif
 	if (startSavePoint && cb.IsCollectingUndo())
 		NotifySavePoint(false);
-	ModifiedAt(position);
+	ModifiedTextAt(position, position, insertLength);
 	NotifyModified(
 		DocModification(
 			ModificationFlags::InsertText | ModificationFlags::User |
@@ -1477,6 +1592,18 @@ void * SCI_METHOD Document::ConvertToDocument() noexcept {
 	return AsDocumentEditable();
 }
 
+// Undo text that was compressed or spilled to a temporary file may not be readable.
+// The rest of the history can not be used then so it is dropped and undo or redo stops.
+bool Document::ReadStepRanges(bool undo, std::vector<Action> &ranges) {
+	try {
+		cb.StepRanges(undo ? cb.GetUndoStep() : cb.GetRedoStep(), undo, ranges);
+		return true;
+	} catch (const std::exception &) {
+		cb.DeleteUndoHistory();
+		return false;
+	}
+}
+
 Sci::Position Document::Undo() {
 	Sci::Position newPos = -1;
 	CheckReadOnly();
@@ -1488,56 +1615,67 @@ Sci::Position Document::Undo() {
 			const int steps = cb.StartUndo();
 			//Platform::DebugPrintf("Steps=%d\n", steps);
 			Range coalescedRemove;	// Default is empty at 0
+			std::vector<Action> ranges;
 			for (int step = 0; step < steps; step++) {
-				const Sci::Line prevLinesTotal = LinesTotal();
-				const Action action = cb.GetUndoStep();
-				if (action.at == ActionType::remove) {
-					NotifyModified(DocModification(
-						ModificationFlags::BeforeInsert | ModificationFlags::Undo, action));
-				} else if (action.at == ActionType::container) {
-					DocModification dm(ModificationFlags::Container | ModificationFlags::Undo);
-					dm.token = action.position;
-					NotifyModified(dm);
-				} else {
-					NotifyModified(DocModification(
-						ModificationFlags::BeforeDelete | ModificationFlags::Undo, action));
-				}
-				cb.PerformUndoStep();
-				if (action.at != ActionType::container) {
-					if ((action.at == ActionType::insert) && (action.position >= LengthNoExcept()) && (action.position > 0))
-						ModifiedAt(action.position - 1);
-					else
-						ModifiedAt(action.position);
-					newPos = action.position;
+				if (!ReadStepRanges(true, ranges)) {
+					break;
 				}
-
-				ModificationFlags modFlags = ModificationFlags::Undo;
-				// With undo, an insertion action becomes a deletion notification
-				if (action.at == ActionType::remove) {
-					newPos += action.lenData;
-					modFlags |= ModificationFlags::InsertText;
-					if (coalescedRemove.Contains(action.position)) {
-						coalescedRemove.end += action.lenData;
-						newPos = coalescedRemove.end;
+				for (size_t range = 0; range < ranges.size(); range++) {
+					const Sci::Line prevLinesTotal = LinesTotal();
+					const Action &action = ranges[range];
+					if (action.at == ActionType::remove) {
+						NotifyModified(DocModification(
+							ModificationFlags::BeforeInsert | ModificationFlags::Undo, action));
+					} else if (action.at == ActionType::container) {
+						DocModification dm(ModificationFlags::Container | ModificationFlags::Undo);
+						dm.token = action.position;
+						NotifyModified(dm);
 					} else {
-						coalescedRemove = Range(action.position, action.position + action.lenData);
+						NotifyModified(DocModification(
+							ModificationFlags::BeforeDelete | ModificationFlags::Undo, action));
 					}
-				} else if (action.at == ActionType::insert) {
-					modFlags |= ModificationFlags::DeleteText;
-					coalescedRemove = Range();
-				}
-				if (steps > 1)
-					modFlags |= ModificationFlags::MultiStepUndoRedo;
-				const Sci::Line linesAdded = LinesTotal() - prevLinesTotal;
-				if (linesAdded != 0)
-					multiLine = true;
-				if (step == steps - 1) {
-					modFlags |= ModificationFlags::LastStepInUndoRedo;
-					if (multiLine)
-						modFlags |= ModificationFlags::MultilineUndoRedo;
+					cb.PerformUndoRange(action);
+					if (action.at != ActionType::container) {
+						const Sci::Position lengthChange = (action.at == ActionType::remove) ? action.lenData : -action.lenData;
+						if ((action.at == ActionType::insert) && (action.position >= LengthNoExcept()) && (action.position > 0))
+							ModifiedTextAt(action.position - 1, action.position, lengthChange);
+						else
+							ModifiedTextAt(action.position, action.position, lengthChange);
+						newPos = action.position;
+					}
+
+					ModificationFlags modFlags = ModificationFlags::Undo;
+					// With undo, an insertion action becomes a deletion notification
+					if (action.at == ActionType::remove) {
+						newPos += action.lenData;
+						modFlags |= ModificationFlags::InsertText;
+						if (coalescedRemove.Contains(action.position)) {
+							coalescedRemove.end += action.lenData;
+							newPos = coalescedRemove.end;
+						} else {
+							coalescedRemove = Range(action.position, action.position + action.lenData);
+						}
+					} else if (action.at == ActionType::insert) {
+						modFlags |= ModificationFlags::DeleteText;
+						coalescedRemove = Range();
+					}
+					if ((steps > 1) || (ranges.size() > 1))
+						modFlags |= ModificationFlags::MultiStepUndoRedo;
+					const Sci::Line linesAdded = LinesTotal() - prevLinesTotal;
+					if (linesAdded != 0)
+						multiLine = true;
+					if ((step == steps - 1) && (range == ranges.size() - 1)) {
+						modFlags |= ModificationFlags::LastStepInUndoRedo;
+						if (multiLine)
+							modFlags |= ModificationFlags::MultilineUndoRedo;
+					}
+					if (range == ranges.size() - 1) {
+						// Complete the step before its last notification so UndoCurrent is already updated
+						cb.CompletedUndoStep();
+					}
+					NotifyModified(DocModification(modFlags, action.position, action.lenData,
+						linesAdded, action.data, 0, newPos));
 				}
-				NotifyModified(DocModification(modFlags, action.position, action.lenData,
-					linesAdded, action.data, 0, newPos));
 			}
 
 			const bool endSavePoint = cb.IsSavePoint();
@@ -1558,46 +1696,56 @@ Sci::Position Document::Redo() {
 			const bool startSavePoint = cb.IsSavePoint();
 			bool multiLine = false;
 			const int steps = cb.StartRedo();
+			std::vector<Action> ranges;
 			for (int step = 0; step < steps; step++) {
-				const Sci::Line prevLinesTotal = LinesTotal();
-				const Action action = cb.GetRedoStep();
-				if (action.at == ActionType::insert) {
-					NotifyModified(DocModification(
-						ModificationFlags::BeforeInsert | ModificationFlags::Redo, action));
-				} else if (action.at == ActionType::container) {
-					DocModification dm(ModificationFlags::Container | ModificationFlags::Redo);
-					dm.token = action.position;
-					NotifyModified(dm);
-				} else {
-					NotifyModified(DocModification(
-						ModificationFlags::BeforeDelete | ModificationFlags::Redo, action));
-				}
-				cb.PerformRedoStep();
-				if (action.at != ActionType::container) {
-					ModifiedAt(action.position);
-					newPos = action.position;
+				if (!ReadStepRanges(false, ranges)) {
+					break;
 				}
+				for (size_t range = 0; range < ranges.size(); range++) {
+					const Sci::Line prevLinesTotal = LinesTotal();
+					const Action &action = ranges[range];
+					if (action.at == ActionType::insert) {
+						NotifyModified(DocModification(
+							ModificationFlags::BeforeInsert | ModificationFlags::Redo, action));
+					} else if (action.at == ActionType::container) {
+						DocModification dm(ModificationFlags::Container | ModificationFlags::Redo);
+						dm.token = action.position;
+						NotifyModified(dm);
+					} else {
+						NotifyModified(DocModification(
+							ModificationFlags::BeforeDelete | ModificationFlags::Redo, action));
+					}
+					cb.PerformRedoRange(action);
+					if (action.at != ActionType::container) {
+						ModifiedTextAt(action.position, action.position, (action.at == ActionType::insert) ? action.lenData : -action.lenData);
+						newPos = action.position;
+					}
 
-				ModificationFlags modFlags = ModificationFlags::Redo;
-				if (action.at == ActionType::insert) {
-					newPos += action.lenData;
-					modFlags |= ModificationFlags::InsertText;
-				} else if (action.at == ActionType::remove) {
-					modFlags |= ModificationFlags::DeleteText;
-				}
-				if (steps > 1)
-					modFlags |= ModificationFlags::MultiStepUndoRedo;
-				const Sci::Line linesAdded = LinesTotal() - prevLinesTotal;
-				if (linesAdded != 0)
-					multiLine = true;
-				if (step == steps - 1) {
-					modFlags |= ModificationFlags::LastStepInUndoRedo;
-					if (multiLine)
-						modFlags |= ModificationFlags::MultilineUndoRedo;
+					ModificationFlags modFlags = ModificationFlags::Redo;
+					if (action.at == ActionType::insert) {
+						newPos += action.lenData;
+						modFlags |= ModificationFlags::InsertText;
+					} else if (action.at == ActionType::remove) {
+						modFlags |= ModificationFlags::DeleteText;
+					}
+					if ((steps > 1) || (ranges.size() > 1))
+						modFlags |= ModificationFlags::MultiStepUndoRedo;
+					const Sci::Line linesAdded = LinesTotal() - prevLinesTotal;
+					if (linesAdded != 0)
+						multiLine = true;
+					if ((step == steps - 1) && (range == ranges.size() - 1)) {
+						modFlags |= ModificationFlags::LastStepInUndoRedo;
+						if (multiLine)
+							modFlags |= ModificationFlags::MultilineUndoRedo;
+					}
+					if (range == ranges.size() - 1) {
+						// Complete the step before its last notification so UndoCurrent is already updated
+						cb.CompletedRedoStep();
+					}
+					NotifyModified(
+						DocModification(modFlags, action.position, action.lenData,
+							linesAdded, action.data, 0, newPos));
 				}
-				NotifyModified(
-					DocModification(modFlags, action.position, action.lenData,
-						linesAdded, action.data, 0, newPos));
 			}
 
 			const bool endSavePoint = cb.IsSavePoint();
@@ -2548,6 +2696,9 @@ int Document::CharacterCategoryOptimization() const noexcept {
 
 void SCI_METHOD Document::StartStyling(Sci_Position position) noexcept {
 	endStyled = position;
+	startStyled = std::min(startStyled, position);
+	// Restyled text must be folded again
+	endFolded = std::min(endFolded, position);
 }
 
 bool SCI_METHOD Document::SetStyleFor(Sci_Position length, unsigned char style) {
@@ -2582,6 +2733,34 @@ bool SCI_METHOD Document::SetStyles(Sci_Position length, const unsigned char *st
 	return true;
 }
 
+bool SCI_METHOD Document::SetStyleRuns(Sci_Position count, const StyleRun *runs) {
+	if (count <= 0 || enteredStyling != 0 || !cb.HasStyles()) {
+		return false;
+	}
+	enteredStyling++;
+	ChangedRange range;
+	for (Sci_Position index = 0; index < count; index++) {
+		const StyleRun &run = runs[index];
+		if (run.length > 0) {
+			const ChangedRange changed = cb.SetStyleFor(endStyled, run.length, static_cast<char>(run.style));
+			endStyled += run.length;
+			if (!changed.Empty()) {
+				if (range.Empty()) {
+					range.start = changed.start;
+				}
+				range.end = changed.end;
+			}
+		}
+	}
+	if (!range.Empty()) {
+		const DocModification mh(ModificationFlags::ChangeStyle | ModificationFlags::User,
+			range.start, range.Length());
+		NotifyModified(mh);
+	}
+	enteredStyling--;
+	return true;
+}
+
 void Document::EnsureStyledTo(Sci::Position pos) {
 	if ((enteredStyling == 0) && (pos > GetEndStyled())) {
 		IncrementStyleClock();
@@ -2598,6 +2777,33 @@ void Document::EnsureStyledTo(Sci::Position pos) {
 	}
 }
 
+Sci::Position Document::GetEndFolded() const noexcept {
+	if (pli && !pli->UseContainerLexing()) {
+		return endFolded;
+	}
+	// Container lexers set fold levels while styling
+	return endStyled;
+}
+
+void Document::EnsureFoldedTo(Sci::Position pos) {
+	if (!pli || pli->UseContainerLexing()) {
+		EnsureStyledTo(pos);
+	} else if (pos > endFolded) {
+		EnsureStyledTo(pos);
+		const Sci::Position end = std::min(pos, GetEndStyled());
+		if (end > endFolded && pli->Fold(LineStartPosition(endFolded), end)) {
+			endFolded = end;
+		}
+	}
+}
+
+// Make the fold level of a line current without asking a container lexer to style.
+void Document::EnsureLineFolded(Sci::Line line) {
+	if (pli && !pli->UseContainerLexing()) {
+		EnsureFoldedTo(LineStart(line + 1));
+	}
+}
+
 void Document::StyleToAdjustingLineDuration(Sci::Position pos) {
 	const Sci::Position stylingStart = GetEndStyled();
 	const ElapsedPeriod epStyling;
@@ -2607,8 +2813,11 @@ void Document::StyleToAdjustingLineDuration(Sci::Position pos) {
 }
 
 void Document::LexerChanged(bool hasStyles_) { //! removed in Scintilla 5.3
+	// styles from previous lexer can not be reused
+	endStaleStyled = 0;
 	if (cb.EnsureStyleBuffer(hasStyles_)) {
 		endStyled = 0;
+		endFolded = 0;
 	}
 }
 
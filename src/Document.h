@@ -217,6 +217,7 @@ public:
 	LexInterface &operator=(LexInterface &&) = delete;
 	virtual ~LexInterface() noexcept;
 	void Colourise(Sci::Position start, Sci::Position end);
+	bool Fold(Sci::Position start, Sci::Position end);
 	virtual Scintilla::LineEndType LineEndTypesSupported() const noexcept;
 	bool UseContainerLexing() const noexcept;
 };
@@ -282,7 +283,7 @@ struct CharacterWideInfo {
 
 /**
  */
-class Document : PerLine, public Scintilla::IDocument, public Scintilla::ILoader, public Scintilla::IDocumentEditable {
+class Document : PerLine, public Scintilla::IDocumentStyleRuns, public Scintilla::ILoader, public Scintilla::IDocumentEditable {
 
 public:
 	/** Used to pair watcher pointer with user data. */
@@ -305,6 +306,13 @@ private:
 #endif
 	std::unique_ptr<CaseFolder> pcf;
 	Sci::Position endStyled = 0;
+	Sci::Position endFolded = 0;
+	// styles in [endStyled, endStaleStyled) are from before text changes ending at endChanged,
+	// they are kept when lexing reaches an unchanged line in the same state as before.
+	Sci::Position endStaleStyled = 0;
+	Sci::Position endChanged = 0;
+	// lowest position passed to StartStyling, lexers may backtrack before the requested start.
+	Sci::Position startStyled = 0;
 	int styleClock = 0;
 	int enteredModification = 0;
 	int enteredStyling = 0;
@@ -373,6 +381,7 @@ public:
 	void InsertLine(Sci::Line line) override;
 	void InsertLines(Sci::Line line, Sci::Line lines) override;
 	void RemoveLine(Sci::Line line) override;
+	void RemoveLines(Sci::Line line, Sci::Line lines) override;
 
 	Scintilla::LineEndType LineEndTypesSupported() const noexcept;
 	bool SetDBCSCodePage(int dbcsCodePage_);
@@ -385,7 +394,7 @@ public:
 	}
 
 	int SCI_METHOD Version() const noexcept override {
-		return Scintilla::dvRelease4;
+		return Scintilla::dvStyleRuns;
 	}
 	int SCI_METHOD DEVersion() const noexcept override {
 		return Scintilla::deRelease0;
@@ -431,6 +440,7 @@ public:
 
 	// Gateways to modifying document
 	void ModifiedAt(Sci::Position pos) noexcept;
+	void ModifiedTextAt(Sci::Position pos, Sci::Position position, Sci::Position lengthChange) noexcept;
 	void CheckReadOnly() noexcept;
 	void TrimReplacement(std::string_view &text, Range &range) const noexcept;
 	bool DeleteChars(Sci::Position pos, Sci::Position len);
@@ -459,8 +469,8 @@ public:
 	bool IsCollectingUndo() const noexcept {
 		return cb.IsCollectingUndo();
 	}
-	void BeginUndoAction(bool coalesceWithPrior = false) noexcept {
-		cb.BeginUndoAction(coalesceWithPrior);
+	void BeginUndoAction(bool coalesceWithPrior = false, bool multipleSelection = false) noexcept {
+		cb.BeginUndoAction(coalesceWithPrior, multipleSelection);
 	}
 	void EndUndoAction() noexcept;
 	bool AfterUndoSequenceStart() const noexcept {
@@ -499,9 +509,34 @@ public:
 	int UndoCurrent() const noexcept;
 	int UndoActionType(int action) const noexcept;
 	Sci::Position UndoActionPosition(int action) const noexcept;
-	std::string_view UndoActionText(int action) const noexcept;
+	std::string_view UndoActionText(int action) const;
 	void PushUndoActionType(int type, Sci::Position position);
 	void ChangeLastUndoActionText(size_t length, const char *text);
+	void SetUndoSpillThreshold(size_t bytes) noexcept {
+		cb.SetUndoSpillThreshold(bytes);
+	}
+	size_t UndoSpillThreshold() const noexcept {
+		return cb.UndoSpillThreshold();
+	}
+	void SetUndoMemoryLimit(size_t bytes) {
+		cb.SetUndoMemoryLimit(bytes);
+	}
+	size_t UndoMemoryLimit() const noexcept {
+		return cb.UndoMemoryLimit();
+	}
+	void SetUndoActionLimit(int actions) {
+		cb.SetUndoActionLimit(actions);
+	}
+	int UndoActionLimit() const noexcept {
+		return cb.UndoActionLimit();
+	}
+	size_t UndoMemoryUsage() const noexcept {
+		return cb.UndoMemoryUsage();
+	}
+	std::string UndoHistoryData() const {
+		return cb.UndoHistoryData();
+	}
+	void SetUndoHistoryData(std::string_view data);
 
 	void ChangeHistorySet(bool enable) {
 		cb.ChangeHistorySet(enable);
@@ -518,10 +553,19 @@ public:
 	[[nodiscard]] Sci::Position EditionNextDelete(Sci::Position pos) const noexcept {
 		return cb.EditionNextDelete(pos);
 	}
+	void EditionRanges(Sci::Position start, Sci::Position end, std::vector<EditionRange> &insertions, std::vector<EditionRange> &deletions) const {
+		cb.EditionRanges(start, end, insertions, deletions);
+	}
 
 	const char * SCI_METHOD BufferPointer() noexcept override {
 		return cb.BufferPointer();
 	}
+	void SCI_METHOD GetSegments(const char **segment1, Sci_Position *length1, const char **segment2) const noexcept override {
+		const SplitView view = cb.AllView();
+		*segment1 = view.segment1;
+		*length1 = view.length1;
+		*segment2 = view.segment2;
+	}
 	const char *RangePointer(Sci::Position position, Sci::Position rangeLength) noexcept {
 		return cb.RangePointer(position, rangeLength);
 	}
@@ -576,6 +620,12 @@ public:
 	int CheckRange(const char *chars, const char *styles, Sci::Position position, Sci::Position rangeLength) const noexcept {
 		return cb.CheckRange(chars, styles, position, rangeLength);
 	}
+	Sci::Position CommonPrefix(const char *chars, const char *styles, Sci::Position position, Sci::Position rangeLength) const noexcept {
+		return cb.CommonPrefix(chars, styles, position, rangeLength);
+	}
+	Sci::Position CommonSuffix(const char *chars, const char *styles, Sci::Position position, Sci::Position rangeLength) const noexcept {
+		return cb.CommonSuffix(chars, styles, position, rangeLength);
+	}
 	MarkerMask GetMark(Sci::Line line, bool includeChangeHistory) const noexcept;
 	Sci::Line MarkerNext(Sci::Line lineStart, MarkerMask mask) const noexcept;
 	int AddMark(Sci::Line line, int markerNum);
@@ -650,10 +700,31 @@ public:
 	void SCI_METHOD StartStyling(Sci_Position position) noexcept override;
 	bool SCI_METHOD SetStyleFor(Sci_Position length, unsigned char style) override;
 	bool SCI_METHOD SetStyles(Sci_Position length, const unsigned char *styles) override;
+	bool SCI_METHOD SetStyleRuns(Sci_Position count, const Scintilla::StyleRun *runs) override;
 	Sci::Position GetEndStyled() const noexcept {
 		return endStyled;
 	}
+	Sci::Position GetEndStaleStyled() const noexcept {
+		return (endStaleStyled > endStyled) ? endStaleStyled : 0;
+	}
+	Sci::Position GetEndChanged() const noexcept {
+		return endChanged;
+	}
+	void KeepStaleStyles() noexcept {
+		if (endStaleStyled > endStyled) {
+			endStyled = endStaleStyled;
+		}
+	}
+	Sci::Position GetStartStyled() const noexcept {
+		return startStyled;
+	}
+	void ResetStartStyled(Sci::Position position) noexcept {
+		startStyled = position;
+	}
 	void EnsureStyledTo(Sci::Position pos);
+	Sci::Position GetEndFolded() const noexcept;
+	void EnsureFoldedTo(Sci::Position pos);
+	void EnsureLineFolded(Sci::Line line);
 	void StyleToAdjustingLineDuration(Sci::Position pos);
 	void LexerChanged(bool hasStyles_);
 	bool EnableUrlHighlight() const noexcept;
@@ -712,6 +783,7 @@ public:
 	Sci::Position BraceMatch(Sci::Position position, Sci::Position maxReStyle, Sci::Position startPos, bool useStartPos) const noexcept;
 
 private:
+	bool ReadStepRanges(bool undo, std::vector<Action> &ranges);
 	void NotifyModifyAttempt() noexcept;
 	void NotifySavePoint(bool atSavePoint) noexcept;
 	void NotifyGroupCompleted() noexcept;
@@ -733,10 +805,11 @@ class UndoGroup {
 	Document *pdoc;
 	bool groupNeeded;
 public:
-	explicit UndoGroup(Document *pdoc_, bool groupNeeded_ = true) noexcept :
+	// multipleSelection merges the same change at each selection into one compound action
+	explicit UndoGroup(Document *pdoc_, bool groupNeeded_ = true, bool multipleSelection = false) noexcept :
 		pdoc(pdoc_), groupNeeded(groupNeeded_) {
 		if (groupNeeded) {
-			pdoc->BeginUndoAction();
+			pdoc->BeginUndoAction(false, multipleSelection);
 		}
 	}
 	// Deleted so UndoGroup objects can not be copied.
@@ -106,6 +106,7 @@ public:
 	virtual Point GetVisibleOriginInMain() const noexcept = 0;
 	virtual Sci::Line LinesOnScreen() const noexcept = 0;
 	virtual void OnLineWrapped(Sci::Line lineDoc, int linesWrapped, int option) = 0;
+	virtual bool PaintIntersects(PRectangle rc) const noexcept = 0;
 	bool BidirectionalEnabled() const noexcept;
 	bool BidirectionalR2L() const noexcept {
 		return bidirectional == Scintilla::Bidirectional::R2L;
@@ -20,7 +20,6 @@
 #include <vector>
 #include <array>
 #include <map>
-#include <forward_list>
 #include <optional>
 #include <algorithm>
 #include <iterator>
@@ -67,6 +66,7 @@
 #include "MarginView.h"
 #include "EditView.h"
 #include "ElapsedPeriod.h"
+#include "FrameTrace.h"
 
 using namespace Scintilla;
 using namespace Scintilla::Internal;
@@ -297,18 +297,90 @@ int EditView::GetNextTabstop(Sci::Line line, int x) const noexcept {
 void EditView::LinesAddedOrRemoved(Sci::Line lineOfPos, Sci::Line linesAdded) const {
 	if (ldTabstops) {
 		if (linesAdded > 0) {
-			for (Sci::Line line = lineOfPos; line < lineOfPos + linesAdded; line++) {
-				ldTabstops->InsertLine(line);
-			}
-		} else {
-			for (Sci::Line line = (lineOfPos + -linesAdded) - 1; line >= lineOfPos; line--) {
-				ldTabstops->RemoveLine(line);
+			ldTabstops->InsertLines(lineOfPos, linesAdded);
+		} else if (linesAdded < 0) {
+			ldTabstops->RemoveLines(lineOfPos, -linesAdded);
+		}
+	}
+}
+
+void LineBitmapCache::SetBudget(int kiloBytes) noexcept {
+	budget = static_cast<size_t>(std::max(kiloBytes, 0)) * 1024;
+	Release();
+}
+
+void LineBitmapCache::Clear() noexcept {
+	for (Entry &entry : entries) {
+		entry.lineDoc = -1;
+	}
+}
+
+void LineBitmapCache::Invalidate(Sci::Line lineFirst, Sci::Line lineLast) noexcept {
+	for (Entry &entry : entries) {
+		if (entry.lineDoc >= lineFirst && entry.lineDoc <= lineLast) {
+			entry.lineDoc = -1;
+		}
+	}
+}
+
+void LineBitmapCache::Release() noexcept {
+	entries.clear();
+	clock = 0;
+}
+
+Surface *LineBitmapCache::Find(Sci::Line lineDoc, int subLine, int xOffset, int width_, int height_) noexcept {
+	if (width != width_ || height != height_) {
+		Release();
+		width = width_;
+		height = height_;
+		return nullptr;
+	}
+	for (Entry &entry : entries) {
+		if (entry.lineDoc == lineDoc && entry.subLine == subLine && entry.xOffset == xOffset) {
+			entry.lastUsed = ++clock;
+			return entry.pixmap.get();
+		}
+	}
+	return nullptr;
+}
+
+void LineBitmapCache::Store(Surface *surfaceWindow, Surface &pixmapLine, Sci::Line lineDoc, int subLine, int xOffset) {
+	const size_t bytesPerLine = static_cast<size_t>(width) * height * 4;
+	if (bytesPerLine == 0) {
+		return;
+	}
+	const size_t maxEntries = budget / bytesPerLine;
+	Entry *slot = nullptr;
+	if (entries.size() < maxEntries) {
+		slot = &entries.emplace_back();
+	} else {
+		// Replace unused or least recently used line, reusing its pixmap
+		for (Entry &entry : entries) {
+			if (!slot || entry.lineDoc < 0 || entry.lastUsed < slot->lastUsed) {
+				slot = &entry;
+				if (entry.lineDoc < 0) {
+					break;
+				}
 			}
 		}
+		if (!slot) {
+			return;
+		}
+	}
+	if (!slot->pixmap) {
+		slot->pixmap = surfaceWindow->AllocatePixMap(width, height);
 	}
+	const PRectangle rcLine = PRectangle::FromInts(0, 0, width, height);
+	slot->pixmap->Copy(rcLine, Point(), pixmapLine);
+	slot->pixmap->FlushDrawing();
+	slot->lineDoc = lineDoc;
+	slot->subLine = subLine;
+	slot->xOffset = xOffset;
+	slot->lastUsed = ++clock;
 }
 
 void EditView::DropGraphics() noexcept {
+	lineBitmaps.Release();
 	pixmapLine.reset();
 	pixmapIndentGuide.reset();
 	pixmapIndentGuideHighlight.reset();
@@ -361,16 +433,70 @@ inline void UpdateMaximum(std::atomic<T> &maximum, const T &value) noexcept {
 	while(prev < value && !maximum.compare_exchange_weak(prev, value)) {}
 }
 
+// Positions after an edit inside a long line, they are shifted into place
+// once segments measured again reach an unchanged segment end.
+struct RelayoutTail {
+	int restart = -1;	// first position to measure again, -1 for full layout
+	int start = 0;		// old position of first character after the edit
+	int end = 0;		// old lastSegmentEnd
+	int delta = 0;		// change of line length
+	int subLine = 0;	// subline containing restart
+	std::vector<XYPOSITION> positions;
+	std::vector<int> segmentEnds;
+
+	bool SyncAt(int posInLine) const noexcept {
+		const int pos = posInLine - delta;
+		return pos >= start && std::binary_search(segmentEnds.begin(), segmentEnds.end(), pos);
+	}
+};
+
+void PrepareRelayout(const EditModel &model, const ViewStyle &vstyle, const LineLayout *ll, Sci::Position posLineStart, int lineLength, int width, RelayoutTail &tail) {
+	const int oldLength = ll->numCharsInLine;
+	const int common = std::min(oldLength, lineLength);
+	if (common < static_cast<int>(EditModel::ParallelLayoutBlockSize*2) || ll->lastSegmentEnd == 0
+		|| model.BidirectionalEnabled() || vstyle.edgeState == EdgeVisualStyle::Background) {
+		return;
+	}
+
+	const char * const chars = ll->chars.get();
+	const char * const styles = reinterpret_cast<const char *>(ll->styles);
+	const int prefix = static_cast<int>(model.pdoc->CommonPrefix(chars, styles, posLineStart, common));
+	if (prefix >= ll->lastSegmentEnd + UTF8MaxBytes) {
+		// edit after laid out text
+		tail.restart = ll->lastSegmentEnd;
+	} else {
+		// segment end is decided by characters around it, so restart before the edit.
+		tail.restart = ll->SegmentEndBefore(prefix - UTF8MaxBytes);
+		const int remain = common - prefix;
+		const int suffix = static_cast<int>(model.pdoc->CommonSuffix(chars + oldLength - remain,
+			styles + oldLength - remain, posLineStart + lineLength - remain, remain));
+		tail.start = oldLength - suffix;
+		tail.end = ll->lastSegmentEnd;
+		tail.delta = lineLength - oldLength;
+		if (tail.start < tail.end) {
+			tail.positions.assign(ll->positions + tail.start, ll->positions + tail.end + 1);
+			const auto it = std::lower_bound(ll->segmentEnds.begin(), ll->segmentEnds.end(), tail.start);
+			tail.segmentEnds.assign(it, ll->segmentEnds.end());
+		}
+	}
+	if (ll->widthLine == width && ll->lines > 2) {
+		tail.subLine = ll->SubLineFromPosition(tail.restart, PointEnd::start);
+	}
+}
+
 struct LayoutWorker {
 	LineLayout * const ll;
 	const ViewStyle &vstyle;
 	Surface * const surface;
 	PositionCache &posCache;
 	const EditModel &model;
+	const RelayoutTail &tail;
 
 	std::vector<TextSegment> segmentList;
+	std::vector<int> segmentEnds {};
 	uint32_t segmentCount = 0;
 	int maxPosInLine = 0;
+	int syncPos = 0;
 	std::atomic<uint32_t> nextIndex = 0;
 	std::atomic<uint32_t> finishedCount = 0;
 
@@ -446,7 +572,17 @@ struct LayoutWorker {
 
 		BreakFinder bfLayout(ll, nullptr, Range(startPos, endPos), posLineStart, 0, BreakFinder::BreakFor::Layout, model, nullptr, posInLine);
 		do {
-			segmentList.push_back(bfLayout.Next());
+			const TextSegment ts = bfLayout.Next();
+			segmentList.push_back(ts);
+			if (!bfLayout.Subdividing()) {
+				const int end = ts.end();
+				if (end < endPos && tail.SyncAt(end)) {
+					// remaining segments are same as before the edit
+					syncPos = end;
+					break;
+				}
+				segmentEnds.push_back(end);
+			}
 		} while (bfLayout.More());
 
 		maxPosInLine = static_cast<int>(posInLine);
@@ -550,6 +686,7 @@ uint32_t EditView::LayoutLine(const EditModel &model, Surface *surface, const Vi
 	// Hard to cope when too narrow, so just assume there is space
 	width = std::max(width, LineLayout::wrapWidthMinimum);
 
+	RelayoutTail tail;
 	auto validity = ll->validity;
 	if (validity == LineLayout::ValidLevel::checkTextAndStyle) {
 		const Sci::Position lineLength = (vstyle.viewEOL ? posLineEnd : model.pdoc->LineEnd(line)) - posLineStart;
@@ -572,6 +709,9 @@ uint32_t EditView::LayoutLine(const EditModel &model, Surface *surface, const Vi
 				validity = (ll->widthLine != width)? LineLayout::ValidLevel::positions : LineLayout::ValidLevel::lines;
 			}
 		}
+		if (validity == LineLayout::ValidLevel::invalid) {
+			PrepareRelayout(model, vstyle, ll, posLineStart, static_cast<int>(lineLength), width, tail);
+		}
 	}
 	if (validity == LineLayout::ValidLevel::invalid) {
 		// Fill base line layout
@@ -589,26 +729,34 @@ uint32_t EditView::LayoutLine(const EditModel &model, Surface *surface, const Vi
 
 		// Layout the line, determining the position of each character,
 		// with an extra element at the end for the end of the line.
-		ll->lastSegmentEnd = 0;
 		ll->numCharsInLine = numCharsInLine;
 		ll->numCharsBeforeEOL = numCharsBeforeEOL;
-
 		ll->xHighlightGuide = 0;
-		ll->edgeColumn = -1;
-		ll->widthLine = LineLayout::wrapWidthInfinite;
-		ll->lines = 1;
-		ll->ClearPositions();
-		if (numCharsInLine == 0) {
-			// empty line with viewEOL disabled
-			ll->widthLine = width;
-			ll->wrapIndent = 0;
-			validity = LineLayout::ValidLevel::lines;
-		} else if (vstyle.edgeState == EdgeVisualStyle::Background) {
-			Sci::Position edgePosition = model.pdoc->FindColumn(line, vstyle.theEdge.column);
-			if (edgePosition >= posLineStart) {
-				edgePosition -= posLineStart;
+
+		if (tail.restart >= 0) {
+			// Keep positions before the edit, wrapping is resumed later
+			ll->lastSegmentEnd = tail.restart;
+			ll->TruncateSegments(tail.restart);
+			ll->ClearPositions(tail.restart + 1);
+		} else {
+			ll->lastSegmentEnd = 0;
+			ll->segmentEnds.clear();
+			ll->edgeColumn = -1;
+			ll->widthLine = LineLayout::wrapWidthInfinite;
+			ll->lines = 1;
+			ll->ClearPositions();
+			if (numCharsInLine == 0) {
+				// empty line with viewEOL disabled
+				ll->widthLine = width;
+				ll->wrapIndent = 0;
+				validity = LineLayout::ValidLevel::lines;
+			} else if (vstyle.edgeState == EdgeVisualStyle::Background) {
+				Sci::Position edgePosition = model.pdoc->FindColumn(line, vstyle.theEdge.column);
+				if (edgePosition >= posLineStart) {
+					edgePosition -= posLineStart;
+				}
+				ll->edgeColumn = static_cast<int>(edgePosition);
 			}
-			ll->edgeColumn = static_cast<int>(edgePosition);
 		}
 	}
 
@@ -621,7 +769,8 @@ uint32_t EditView::LayoutLine(const EditModel &model, Surface *surface, const Vi
 		//}
 		//const ElapsedPeriod period;
 		//posInLine = ll->numCharsInLine; // whole line
-		LayoutWorker worker{ ll, vstyle, surface, posCache, model, {}};
+		const TraceScope traceScope(FrameTraceSpan::LayoutLine, line, posInLine);
+		LayoutWorker worker{ ll, vstyle, surface, posCache, model, tail, {}};
 		const uint32_t threadCount = worker.Start(posLineStart, posInLine, option);
 
 		// Accumulate absolute positions from relative positions within segments and expand tabs
@@ -646,7 +795,7 @@ uint32_t EditView::LayoutLine(const EditModel &model, Surface *surface, const Vi
 		}
 
 		const TextSegment &ts = worker.segmentList[finishedCount - 1];
-		const int endPos = ts.end();
+		int endPos = ts.end();
 		const uint32_t bytes = endPos - ll->lastSegmentEnd;
 		wrappedBytes = bytes / threadCount;
 #if 0
@@ -657,14 +806,37 @@ uint32_t EditView::LayoutLine(const EditModel &model, Surface *surface, const Vi
 				bytes, threadCount, wrappedBytes, duration, model.durationWrapOneUnit.Duration()*1e3);
 		}
 #endif
-		ll->lastSegmentEnd = endPos;
-		if (endPos == ll->numCharsInLine) {
+		for (const int end : worker.segmentEnds) {
+			if (end > endPos) {
+				break;
+			}
+			ll->segmentEnds.push_back(end);
+		}
+		if (endPos == worker.syncPos) {
+			// Shift old positions after the edit, tab stops are computed again as they depend on start position.
+			const Representation *tabRepr = (vstyle.tabDrawMode == TabDrawMode::ControlChar) ? nullptr : model.reprs->GetRepresentation("\t");
+			const int syncPos = endPos - tail.delta;
+			const XYPOSITION *tailPositions = tail.positions.data() + (syncPos - tail.start);
+			XYPOSITION dx = ll->positions[endPos] - tailPositions[0];
+			for (int i = 1; i <= tail.end - syncPos; i++) {
+				const int index = endPos + i;
+				if (tabRepr && ll->chars[index - 1] == '\t' && vstyle.styles[ll->styles[index - 1]].visible) {
+					dx = NextTabstopPos(line, ll->positions[index - 1], vstyle.tabWidth) - tailPositions[i];
+				}
+				ll->positions[index] = tailPositions[i] + dx;
+			}
+			for (auto it = std::upper_bound(tail.segmentEnds.begin(), tail.segmentEnds.end(), syncPos); it != tail.segmentEnds.end(); ++it) {
+				ll->segmentEnds.push_back(*it + tail.delta);
+			}
+			endPos = tail.end + tail.delta;
+		} else if (endPos == ll->numCharsInLine) {
 			// Small hack to make lines that end with italics not cut off the edge of the last character
 			// Not quite the same as before which would effectively ignore trailing invisible segments
 			if (!ts.representation && (ll->chars[endPos - 1] != ' ') && vstyle.styles[ll->styles[ts.start]].italic) {
 				ll->positions[endPos] += vstyle.lastSegItalicsOffset;
 			}
 		}
+		ll->lastSegmentEnd = endPos;
 		validity = LineLayout::ValidLevel::positions;
 	}
 	if ((validity == LineLayout::ValidLevel::positions) || (ll->widthLine != width)) {
@@ -713,7 +885,13 @@ uint32_t EditView::LayoutLine(const EditModel &model, Surface *surface, const Vi
 				wrapIndent = aveCharWidth; // Indent to show start visual
 			}
 			//const ElapsedPeriod period;
-			ll->WrapLine(model.pdoc, posLineStart, vstyle.wrap.state, width, wrapIndent, partialLine);
+			bool resumeWrap = partialLine;
+			if (tail.subLine >= 2) {
+				// wrap again from previous subline, its end may be changed by the edit
+				ll->lines = tail.subLine + 1;
+				resumeWrap = true;
+			}
+			ll->WrapLine(model.pdoc, posLineStart, vstyle.wrap.state, width, wrapIndent, resumeWrap);
 			//const double duration = period.Duration()*1e3;
 			//printf("wrap line=%zd(%d)%d duration=%f, lines=%d, %.0f/%d\n", line + 1, ll->lastSegmentEnd,
 			//	static_cast<int>(vstyle.wrap.state), duration, ll->lines, ll->positions[ll->lastSegmentEnd], width);
@@ -729,6 +907,15 @@ uint32_t EditView::LayoutLine(const EditModel &model, Surface *surface, const Vi
 	return wrappedBytes;
 }
 
+// Extend partial layout of a long unwrapped line until it reaches x.
+void EditView::ExtendLayout(const EditModel &model, Surface *surface, const ViewStyle &vstyle, LineLayout *ll, XYPOSITION x) {
+	while (ll->PartialPosition() && ll->positions[ll->lastSegmentEnd] < x) {
+		const XYPOSITION remain = x - ll->positions[ll->lastSegmentEnd];
+		const int posInLine = ll->lastSegmentEnd + static_cast<int>(remain / vstyle.aveCharWidth);
+		LayoutLine(model, surface, vstyle, ll, model.wrapWidth, LayoutLineOption::IdleUpdate, posInLine);
+	}
+}
+
 // Fill the LineLayout bidirectional data fields according to each char style
 
 void EditView::UpdateBidiData(const EditModel &model, const ViewStyle &vstyle, LineLayout *ll) {
@@ -2184,38 +2371,27 @@ void DrawIndicators(Surface *surface, const EditModel &model, const ViewStyle &v
 	if (FlagSet(model.changeHistoryOption, ChangeHistoryOption::Indicators)) {
 		// Draw editions
 		constexpr int indexHistory = static_cast<int>(IndicatorNumbers::HistoryRevertedToOriginInsertion);
-		{
-			// Draw insertions
-			Sci::Position startPos = posLineStart + lineStart;
-			while (startPos < posLineEnd) {
-				const Range rangeRun(startPos, model.pdoc->EditionEndRun(startPos));
-				const Sci::Position endPos = std::min(rangeRun.end, posLineEnd);
-				const int edition = model.pdoc->EditionAt(startPos);
-				if (edition != 0) {
-					const int indicator = ((edition - 1) * 2) + indexHistory;
-					const Sci::Position posSecond = model.pdoc->MovePositionOutsideChar(rangeRun.First() + 1, 1);
-					DrawIndicator(indicator, startPos - posLineStart, endPos - posLineStart,
+		std::vector<EditionRange> insertions;
+		std::vector<EditionRange> deletions;
+		model.pdoc->EditionRanges(posLineStart + lineStart, posLineEnd, insertions, deletions);
+		// Draw insertions
+		for (const EditionRange &range : insertions) {
+			const int indicator = ((range.edition - 1) * 2) + indexHistory;
+			const Sci::Position posSecond = model.pdoc->MovePositionOutsideChar(range.start + 1, 1);
+			DrawIndicator(indicator, range.start - posLineStart, range.end - posLineStart,
+				surface, vsDraw, ll, xStart, rcLine, posSecond - posLineStart, subLine, Indicator::State::normal,
+				1, model.BidirectionalEnabled(), tabWidthMinimumPixels);
+		}
+		// Draw deletions
+		for (const EditionRange &range : deletions) {
+			const Sci::Position posSecond = model.pdoc->MovePositionOutsideChar(range.start + 1, 1);
+			for (unsigned int edition = 0; edition < 4; edition++) {
+				if (range.edition & (1 << edition)) {
+					const int indicator = (edition * 2) + indexHistory + 1;
+					DrawIndicator(indicator, range.start - posLineStart, posSecond - posLineStart,
 						surface, vsDraw, ll, xStart, rcLine, posSecond - posLineStart, subLine, Indicator::State::normal,
 						1, model.BidirectionalEnabled(), tabWidthMinimumPixels);
 				}
-				startPos = endPos;
-			}
-		}
-		{
-			// Draw deletions
-			Sci::Position startPos = posLineStart + lineStart;
-			while (startPos <= posLineEnd) {
-				const unsigned int editions = model.pdoc->EditionDeletesAt(startPos);
-				const Sci::Position posSecond = model.pdoc->MovePositionOutsideChar(startPos + 1, 1);
-				for (unsigned int edition = 0; edition < 4; edition++) {
-					if (editions & (1 << edition)) {
-						const int indicator = (edition * 2) + indexHistory + 1;
-						DrawIndicator(indicator, startPos - posLineStart, posSecond - posLineStart,
-							surface, vsDraw, ll, xStart, rcLine, posSecond - posLineStart, subLine, Indicator::State::normal,
-							1, model.BidirectionalEnabled(), tabWidthMinimumPixels);
-					}
-				}
-				startPos = model.pdoc->EditionNextDelete(startPos);
 			}
 		}
 	}
@@ -2679,6 +2855,9 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, const V
 		const Point ptOrigin = model.GetVisibleOriginInMain();
 
 		const int screenLinePaintFirst = static_cast<int>(rcArea.top) / vsDraw.lineHeight;
+		const Sci::Line lineVisibleFirst = model.TopLineOfMain() + screenLinePaintFirst;
+		const Sci::Line lineVisibleLast = model.TopLineOfMain() + (static_cast<int>(rcArea.bottom) - 1) / vsDraw.lineHeight;
+		const TraceScope traceScope(FrameTraceSpan::PaintText, lineVisibleFirst, lineVisibleLast);
 		const int xOrigin = vsDraw.textStart - model.xOffset + static_cast<int>(ptOrigin.x);
 
 		const SelectionPosition posCaret = model.posDrag.IsValid() ? model.posDrag : model.sel.RangeMain().caret;
@@ -2702,6 +2881,9 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, const V
 			surfaceWindow->SetClip(rcClipText);
 		}
 
+		// Lines overlapping damaged lines are invalidated with them.
+		const int lineOverlap = LinesOverlap() ? vsDraw.lineOverlap : 0;
+
 		// Loop on visible lines
 #if defined(TIME_PAINTING)
 		double durLayout = 0.0;
@@ -2722,7 +2904,7 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, const V
 			int yposScreen = screenLinePaintFirst * vsDraw.lineHeight;
 			int ypos = bufferedDraw ? 0 : yposScreen;
 			const int bottom = static_cast<int>(rcArea.bottom);
-			Sci::Line lineVisible = model.TopLineOfMain() + screenLinePaintFirst;
+			Sci::Line lineVisible = lineVisibleFirst;
 			const Sci::Line linesDisplayed = model.pcs->LinesDisplayed();
 			while (lineVisible < linesDisplayed && yposScreen < bottom) {
 
@@ -2732,6 +2914,34 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, const V
 				const Sci::Line lineStartSet = model.pcs->DisplayFromDoc(lineDoc);
 				const int subLine = static_cast<int>(lineVisible - lineStartSet);
 
+				// Skip lines between damaged lines that were not invalidated themselves.
+				const PRectangle rcLineScreen(rcTextArea.left - leftTextOverlap, static_cast<XYPOSITION>(yposScreen - lineOverlap),
+					rcClient.right, static_cast<XYPOSITION>(yposScreen + vsDraw.lineHeight + lineOverlap));
+				if (!model.PaintIntersects(rcLineScreen)) {
+					if (!bufferedDraw) {
+						ypos += vsDraw.lineHeight;
+					}
+					yposScreen += vsDraw.lineHeight;
+					lineVisible++;
+					continue;
+				}
+
+				const Point from = Point::FromInts(vsDraw.textStart - leftTextOverlap, 0);
+				const PRectangle rcCopyArea = PRectangle::FromInts(vsDraw.textStart - leftTextOverlap, yposScreen,
+					static_cast<int>(rcClient.right - vsDraw.rightMarginWidth),
+					yposScreen + vsDraw.lineHeight);
+				if (bufferedDraw && lineBitmaps.Enabled()) {
+					// Line is unchanged since drawn before scrolling
+					Surface *pixmapCached = lineBitmaps.Find(lineDoc, subLine, model.xOffset,
+						static_cast<int>(rcClient.Width()), vsDraw.lineHeight);
+					if (pixmapCached) {
+						surfaceWindow->Copy(rcCopyArea, from, *pixmapCached);
+						yposScreen += vsDraw.lineHeight;
+						lineVisible++;
+						continue;
+					}
+				}
+
 				// Copy this line and its styles from the document into local arrays
 				// and determine the x position at which each character starts.
 #if defined(TIME_PAINTING)
@@ -2741,6 +2951,10 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, const V
 					lineDocPrevious = lineDoc;
 					ll = RetrieveLineLayout(lineDoc, model);
 					LayoutLine(model, surface, vsDraw, ll, model.wrapWidth, LayoutLineOption::PaintText);
+					if (ll->PartialPosition() && model.wrapWidth == LineLayout::wrapWidthInfinite) {
+						// text visible in the view must be laid out, text after it is prefetched on idle.
+						ExtendLayout(model, surface, vsDraw, ll, model.xOffset + rcClient.Width());
+					}
 					if (model.BidirectionalEnabled()) {
 						// Fill the line bidi data
 						UpdateBidiData(model, vsDraw, ll);
@@ -2791,12 +3005,11 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, const V
 					}
 
 					if (bufferedDraw) {
-						const Point from = Point::FromInts(vsDraw.textStart - leftTextOverlap, 0);
-						const PRectangle rcCopyArea = PRectangle::FromInts(vsDraw.textStart - leftTextOverlap, yposScreen,
-							static_cast<int>(rcClient.right - vsDraw.rightMarginWidth),
-							yposScreen + vsDraw.lineHeight);
 						pixmapLine->FlushDrawing();
 						surfaceWindow->Copy(rcCopyArea, from, *pixmapLine);
+						if (lineBitmaps.Enabled()) {
+							lineBitmaps.Store(surfaceWindow, *pixmapLine, lineDoc, subLine, model.xOffset);
+						}
 					}
 
 					UpdateMaxWidth(ll->positions[ll->numCharsInLine]);
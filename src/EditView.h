@@ -67,6 +67,36 @@ typedef void (*DrawTabArrowFn)(Surface *surface, PRectangle rcTab, int ymid,
 
 class LineTabstops;
 
+// Lines drawn in buffered mode kept while the view is only scrolled vertically,
+// so lines that stay visible are copied instead of being laid out and drawn again.
+class LineBitmapCache {
+	struct Entry {
+		Sci::Line lineDoc = -1;
+		int subLine = 0;
+		int xOffset = 0;
+		uint32_t lastUsed = 0;
+		std::unique_ptr<Surface> pixmap;
+	};
+	std::vector<Entry> entries;
+	size_t budget = 0;
+	uint32_t clock = 0;
+	int width = 0;
+	int height = 0;
+public:
+	void SetBudget(int kiloBytes) noexcept;
+	int Budget() const noexcept {
+		return static_cast<int>(budget / 1024);
+	}
+	bool Enabled() const noexcept {
+		return budget != 0;
+	}
+	void Clear() noexcept;
+	void Invalidate(Sci::Line lineFirst, Sci::Line lineLast) noexcept;
+	void Release() noexcept;
+	Surface *Find(Sci::Line lineDoc, int subLine, int xOffset, int width_, int height_) noexcept;
+	void Store(Surface *surfaceWindow, Surface &pixmapLine, Sci::Line lineDoc, int subLine, int xOffset);
+};
+
 /**
 * EditView draws the main text area.
 */
@@ -97,6 +127,7 @@ public:
 	std::unique_ptr<Surface> pixmapLine;
 	std::unique_ptr<Surface> pixmapIndentGuide;
 	std::unique_ptr<Surface> pixmapIndentGuideHighlight;
+	LineBitmapCache lineBitmaps;
 
 	LineLayoutCache llc;
 	PositionCache posCache;
@@ -135,6 +166,7 @@ public:
 	LineLayout *RetrieveLineLayout(Sci::Line lineNumber, const EditModel &model);
 	uint32_t LayoutLine(const EditModel &model, Surface *surface, const ViewStyle &vstyle,
 		LineLayout *ll, int width, LayoutLineOption option, int posInLine = 0);
+	void ExtendLayout(const EditModel &model, Surface *surface, const ViewStyle &vstyle, LineLayout *ll, XYPOSITION x);
 
 	static void UpdateBidiData(const EditModel &model, const ViewStyle &vstyle, LineLayout *ll);
 
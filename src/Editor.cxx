@@ -20,7 +20,6 @@
 #include <vector>
 #include <array>
 #include <map>
-#include <forward_list>
 #include <optional>
 #include <algorithm>
 #include <iterator>
@@ -67,6 +66,7 @@
 #include "EditView.h"
 #include "Editor.h"
 #include "ElapsedPeriod.h"
+#include "FrameTrace.h"
 
 using namespace Scintilla;
 using namespace Scintilla::Internal;
@@ -202,8 +202,10 @@ Editor::Editor() {
 	paintAbandonedByStyling = false;
 	paintingAllText = false;
 	willRedrawAll = false;
+	redrawForScroll = false;
 	idleStyling = IdleStyling::None;
 	needIdleStyling = false;
+	needLayoutPrefetch = false;
 
 	recordingMacro = false;
 	convertPastes = true;
@@ -472,6 +474,9 @@ void Editor::DiscardOverdraw() noexcept {
 }
 
 void Editor::Redraw() noexcept {
+	if (!redrawForScroll) {
+		view.lineBitmaps.Clear();
+	}
 	if (redrawPendingText) {
 		return;
 	}
@@ -496,6 +501,13 @@ void Editor::RedrawSelMargin(Sci::Line line, bool allAfter) noexcept {
 		Redraw();
 		return;
 	}
+	if (markersInText) {
+		if (line >= 0) {
+			view.lineBitmaps.Invalidate(line, allAfter ? pdoc->LinesTotal() : line);
+		} else {
+			view.lineBitmaps.Clear();
+		}
+	}
 	if (redrawPendingMargin) {
 		return;
 	}
@@ -555,7 +567,14 @@ PRectangle Editor::RectangleFromRange(Range r, int overlap) const noexcept {
 	return rc;
 }
 
+void Editor::InvalidateLineBitmaps(Sci::Position start, Sci::Position end) noexcept {
+	if (view.lineBitmaps.Enabled()) {
+		view.lineBitmaps.Invalidate(pdoc->SciLineFromPosition(start), pdoc->SciLineFromPosition(end));
+	}
+}
+
 void Editor::InvalidateRange(Sci::Position start, Sci::Position end) noexcept {
+	InvalidateLineBitmaps(start, end);
 	if (redrawPendingText) {
 		return;
 	}
@@ -1003,6 +1022,8 @@ void Editor::ScrollTo(Sci::Line line, bool moveThumb) {
 		// Optimize by styling the view as this will invalidate any needed area
 		// which could abort the initial paint if discovered later.
 		StyleAreaBounded(GetClientRectangle(), true);
+		// Lines drawn before scrolling are still valid
+		redrawForScroll = true;
 #ifndef UNDER_CE
 		// Perform redraw rather than scroll if many lines would be redrawn anyway.
 		if (performBlit) {
@@ -1014,6 +1035,7 @@ void Editor::ScrollTo(Sci::Line line, bool moveThumb) {
 #else
 		Redraw();
 #endif
+		redrawForScroll = false;
 		if (moveThumb) {
 			SetVerticalScrollPos();
 		}
@@ -1030,6 +1052,7 @@ void Editor::HorizontalScrollTo(int xPos) {
 	if (xPos < 0)
 		xPos = 0;
 	if (!Wrapping() && (xOffset != xPos)) {
+		NeedLayoutPrefetch(xPos);
 		xOffset = xPos;
 		ContainerNeedsUpdate(Update::HScroll);
 		SetHorizontalScrollPos();
@@ -1447,6 +1470,7 @@ void Editor::SetXYScroll(XYScrollPosition newXY) {
 			SetVerticalScrollPos();
 		}
 		if (newXY.xOffset != xOffset) {
+			NeedLayoutPrefetch(newXY.xOffset);
 			xOffset = newXY.xOffset;
 			ContainerNeedsUpdate(Update::HScroll);
 			if (newXY.xOffset > 0) {
@@ -1818,6 +1842,7 @@ bool Editor::WrapLines(WrapScope ws) {
 		pdoc->EnsureStyledTo(pdoc->LineStart(lineToWrapEnd));
 
 		if (lineToWrap < lineToWrapEnd) {
+			const TraceScope traceScope(FrameTraceSpan::WrapLines, lineToWrap, lineToWrapEnd);
 			PRectangle rcTextArea = GetClientRectangle();
 			rcTextArea.left = static_cast<XYPOSITION>(vs.textStart);
 			rcTextArea.right -= vs.rightMarginWidth;
@@ -1871,6 +1896,44 @@ bool Editor::WrapLines(WrapScope ws) {
 	return wrapOccurred;
 }
 
+void Editor::NeedLayoutPrefetch(int xOffsetNew) noexcept {
+	// long lines are laid out from line start, only scrolling toward line end needs prefetch.
+	if (xOffsetNew > xOffset && !Wrapping()) {
+		needLayoutPrefetch = true;
+		SetIdle(true);
+	}
+}
+
+// Lay out partially laid out visible lines ahead of the view in the direction of
+// horizontal scrolling, so further scrolling does not wait for measuring text.
+bool Editor::PrefetchLayout() {
+	if (Wrapping()) {
+		return false;
+	}
+	const AutoSurface surface(this);
+	if (!surface) {
+		return false;
+	}
+
+	constexpr int prefetchPages = 2;
+	const PRectangle rcText = GetTextRectangle();
+	const XYPOSITION xTarget = xOffset + rcText.Width()*(1 + prefetchPages);
+	const Sci::Line lineVisibleEnd = std::min(topLine + LinesOnScreen() + 1, pcs->LinesDisplayed());
+	SetIdleTaskTime(MaxPaintTextTime);
+	for (Sci::Line lineVisible = topLine; lineVisible < lineVisibleEnd; lineVisible++) {
+		const Sci::Line lineDoc = pcs->DocFromDisplay(lineVisible);
+		LineLayout * const ll = view.RetrieveLineLayout(lineDoc, *this);
+		// lines not laid out yet are handled by painting
+		if (ll->validity != LineLayout::ValidLevel::invalid && ll->PartialPosition()) {
+			view.ExtendLayout(*this, surface, vs, ll, xTarget);
+			if (IdleTaskTimeExpired()) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
 void Editor::LinesJoin() {
 	if (!RangeContainsProtected(targetRange.start.Position(), targetRange.end.Position())) {
 		const UndoGroup ug(pdoc);
@@ -1973,6 +2036,7 @@ void Editor::RefreshPixMaps(Surface *surfaceWindow) {
 }
 
 void Editor::Paint(Surface *surfaceWindow, PRectangle rcArea) {
+	const TraceScope traceScope(FrameTraceSpan::Paint, topLine, LinesOnScreen());
 	redrawPendingText = false;
 	redrawPendingMargin = false;
 
@@ -2061,6 +2125,7 @@ void Editor::Paint(Surface *surfaceWindow, PRectangle rcArea) {
 	if (!view.bufferedDraw)
 		surfaceWindow->PopClip();
 
+	frameTrace.AddCacheCounter();
 	NotifyPainted();
 }
 
@@ -2175,7 +2240,7 @@ void Editor::InsertCharacter(std::string_view sv, CharacterSource charSource) {
 	bool handled = false;
 	bool wrapOccurred = false;
 	{
-		const UndoGroup ug(pdoc, (sel.Count() > 1) || !sel.Empty() || inOverstrike);
+		const UndoGroup ug(pdoc, (sel.Count() > 1) || !sel.Empty() || inOverstrike, sel.Count() > 1);
 		// enclose selection on typing punctuation, empty selection will be handled in Notification::CharAdded.
 		char encloseCh = '\0';
 		if (charSource == CharacterSource::DirectInput && sv.length() == 1 && !sel.Empty() && !sel.IsRectangular()) {
@@ -2314,7 +2379,7 @@ void Editor::ClearSelectionRange(SelectionRange &range) {
 void Editor::ClearBeforeTentativeStart() {
 	// Make positions for the first composition string.
 	FilterSelections();
-	const UndoGroup ug(pdoc, (sel.Count() > 1) || !sel.Empty() || inOverstrike);
+	const UndoGroup ug(pdoc, (sel.Count() > 1) || !sel.Empty() || inOverstrike, sel.Count() > 1);
 	for (size_t r = 0; r < sel.Count(); r++) {
 		if (!RangeContainsProtected(sel.Range(r))) {
 			ClearSelectionRange(sel.Range(r));
@@ -2427,6 +2492,7 @@ void Editor::ClearDocumentStyle() {
 	const Sci::Position endStyled = pdoc->GetEndStyled();
 	pdoc->StartStyling(0);
 	pdoc->SetStyleFor(endStyled, 0);
+	pdoc->ModifiedAt(endStyled);
 	pcs->ShowAll();
 	SetAnnotationHeights(0, pdoc->LinesTotal());
 	pdoc->ClearLevels();
@@ -2541,7 +2607,7 @@ void Editor::Clear() {
 			sel.RangeMain().Start().VirtualSpace()) {
 			singleVirtual = true;
 		}
-		const UndoGroup ug(pdoc, (sel.Count() > 1) || singleVirtual);
+		const UndoGroup ug(pdoc, (sel.Count() > 1) || singleVirtual, sel.Count() > 1);
 		for (size_t r = 0; r < sel.Count(); r++) {
 			const Sci::Position caretPosition = sel.Range(r).caret.Position();
 			if (!RangeContainsProtected(caretPosition, caretPosition + 1)) {
@@ -2657,7 +2723,7 @@ void Editor::DelCharBack(bool allowLineStartDeletion) {
 		FilterSelections();
 	if (sel.IsRectangular())
 		allowLineStartDeletion = false;
-	const UndoGroup ug(pdoc, (sel.Count() > 1) || !sel.Empty());
+	const UndoGroup ug(pdoc, (sel.Count() > 1) || !sel.Empty(), sel.Count() > 1);
 	if (sel.Empty()) {
 		for (size_t r = 0; r < sel.Count(); r++) {
 			const Sci::Position caretPosition = sel.Range(r).caret.Position();
@@ -2974,8 +3040,8 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 		if (paintState == PaintState::painting) {
 			CheckForChangeOutsidePaint(
 				Range(mh.position, pdoc->LineStart(mh.line + 1)));
-		} else {
-			// Could check that change is before last visible line.
+		} else if (mh.line <= pcs->DocFromDisplay(topLine + LinesOnScreen())) {
+			// Lexers update line state after visible area while styling on idle.
 			Redraw();
 		}
 	}
@@ -2994,6 +3060,8 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 		if (FlagSet(mh.modificationType, ModificationFlags::ChangeStyle)) {
 			pdoc->IncrementStyleClock();
 		}
+		// Styling may be performed while painting without invalidating
+		InvalidateLineBitmaps(mh.position, mh.position + mh.length);
 		if (paintState == PaintState::notPainting) {
 			const Sci::Line lineDocTop = pcs->DocFromDisplay(topLine);
 			if (mh.position < pdoc->LineStart(lineDocTop)) {
@@ -3060,6 +3128,11 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 		//CheckModificationForWrap(mh);
 		if (FlagSet(mh.modificationType, ModificationFlags::InsertText | ModificationFlags::DeleteText)) {
 			view.llc.Invalidate(LineLayout::ValidLevel::checkTextAndStyle);
+			if (mh.linesAdded != 0) {
+				view.lineBitmaps.Clear();
+			} else {
+				InvalidateLineBitmaps(mh.position, mh.position + mh.length);
+			}
 			const Sci::Line lineDoc = pdoc->SciLineFromPosition(mh.position);
 			const Sci::Line lines = std::max<Sci::Line>(0, mh.linesAdded);
 			if (Wrapping()) {
@@ -3505,7 +3578,7 @@ void Editor::NewLine() {
 		sel.DropAdditionalRanges();
 	}
 
-	const UndoGroup ug(pdoc, !sel.Empty() || (sel.Count() > 1));
+	const UndoGroup ug(pdoc, !sel.Empty() || (sel.Count() > 1), sel.Count() > 1);
 
 	// Clear each range
 	if (!sel.Empty()) {
@@ -4042,7 +4115,7 @@ int Editor::DelWordOrLine(Message iMessage) {
 		sel.DropAdditionalRanges();
 	}
 
-	const UndoGroup ug0(pdoc, (sel.Count() > 1) || !leftwards);
+	const UndoGroup ug0(pdoc, (sel.Count() > 1) || !leftwards, sel.Count() > 1);
 
 	for (size_t r = 0; r < sel.Count(); r++) {
 		if (leftwards) {
@@ -5432,6 +5505,8 @@ bool Editor::Idle() {
 		needWrap = wrapPending.NeedsWrap();
 	} else if (needIdleStyling) {
 		IdleStyle();
+	} else if (needLayoutPrefetch) {
+		needLayoutPrefetch = PrefetchLayout();
 	}
 
 	// Add more idle things to do here, but make sure idleDone is
@@ -5439,7 +5514,7 @@ bool Editor::Idle() {
 	// false will stop calling this idle function until SetIdle() is
 	// called again.
 
-	const bool idleDone = !needWrap && !needIdleStyling; // && thatDone && theOtherThingDone...
+	const bool idleDone = !needWrap && !needIdleStyling && !needLayoutPrefetch; // && thatDone && theOtherThingDone...
 
 	return !idleDone;
 }
@@ -5575,6 +5650,8 @@ void Editor::StyleAreaBounded(PRectangle rcArea, bool scrolling) {
 		// Can style all wanted now.
 		StyleToPositionInView(posAfterArea);
 	}
+	// Fold levels are only needed for displayed lines so are not found by idle styling
+	pdoc->EnsureFoldedTo(std::min(posAfterArea, pdoc->GetEndStyled()));
 	StartIdleStyling(posAfterMax < posAfterArea);
 }
 
@@ -5615,6 +5692,12 @@ bool Editor::PaintContains(PRectangle rc) const noexcept {
 	return rcPaint.Contains(rc);
 }
 
+// Whether any part of rc needs to be painted, lines between separately invalidated
+// lines are inside paint rectangle but can be skipped.
+bool Editor::PaintIntersects(PRectangle rc) const noexcept {
+	return paintingAllText || rcPaint.Intersects(rc);
+}
+
 bool Editor::PaintContainsMargin() const noexcept {
 	if (HasMarginWindow()) {
 		// With separate margin view, paint of text view
@@ -5627,6 +5710,9 @@ bool Editor::PaintContainsMargin() const noexcept {
 }
 
 void Editor::CheckForChangeOutsidePaint(Range r) noexcept {
+	if (paintState == PaintState::painting && r.Valid()) {
+		InvalidateLineBitmaps(r.start, r.end);
+	}
 	if (paintState == PaintState::painting && !paintingAllText) {
 		//Platform::DebugPrintf("Checking range in paint %d-%d\n", r.start, r.end);
 		if (!r.Valid())
@@ -5794,6 +5880,7 @@ void Editor::SetFoldExpanded(Sci::Line lineDoc, bool expanded) {
 
 void Editor::FoldLine(Sci::Line line, FoldAction action) {
 	if (line >= 0) {
+		pdoc->EnsureLineFolded(line);
 		FoldLevel level = pdoc->GetFoldLevel(line);
 		if (action == FoldAction::Toggle) {
 			if (!LevelIsHeader(level)) {
@@ -5889,6 +5976,7 @@ void Editor::EnsureLineVisible(Sci::Line lineDoc, bool enforcePolicy) {
 	}
 
 	if (!pcs->GetVisible(lineDoc)) {
+		pdoc->EnsureLineFolded(lineDoc);
 		// Back up to find a non-blank line
 		Sci::Line lookLine = lineDoc;
 		FoldLevel lookLineLevel = pdoc->GetFoldLevel(lookLine);
@@ -5939,7 +6027,7 @@ void Editor::FoldAll(FoldAction action) {
 	action = static_cast<FoldAction>(static_cast<int>(action) & ~static_cast<int>(FoldAction::ContractEveryLevel));
 	bool expanding = action == FoldAction::Expand;
 	if (!expanding) {
-		pdoc->EnsureStyledTo(pdoc->LengthNoExcept());
+		pdoc->EnsureFoldedTo(pdoc->LengthNoExcept());
 	}
 
 	Sci::Line line = 0;
@@ -6745,6 +6833,7 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		break;
 
 	case Message::SetXOffset:
+		NeedLayoutPrefetch(static_cast<int>(wParam));
 		xOffset = static_cast<int>(wParam);
 		ContainerNeedsUpdate(Update::HScroll);
 		SetHorizontalScrollPos();
@@ -6959,6 +7048,40 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		pdoc->ChangeLastUndoActionText(wParam, CharPtrFromSPtr(lParam));
 		break;
 
+	case Message::SetUndoSpillThreshold:
+		pdoc->SetUndoSpillThreshold(wParam);
+		break;
+
+	case Message::GetUndoSpillThreshold:
+		return pdoc->UndoSpillThreshold();
+
+	case Message::SetUndoMemoryLimit:
+		pdoc->SetUndoMemoryLimit(wParam);
+		break;
+
+	case Message::GetUndoMemoryLimit:
+		return pdoc->UndoMemoryLimit();
+
+	case Message::SetUndoActionLimit:
+		pdoc->SetUndoActionLimit(static_cast<int>(wParam));
+		break;
+
+	case Message::GetUndoActionLimit:
+		return pdoc->UndoActionLimit();
+
+	case Message::GetUndoMemoryUsage:
+		return pdoc->UndoMemoryUsage();
+
+	case Message::GetUndoHistoryData: {
+		const std::string data = pdoc->UndoHistoryData();
+		return BytesResult(lParam, data);
+	}
+
+	case Message::SetUndoHistoryData:
+		pdoc->SetUndoHistoryData(std::string_view(ConstCharPtrFromSPtr(lParam), wParam));
+		Redraw();
+		break;
+
 	case Message::GetCaretPeriod:
 		return caret.period;
 
@@ -7247,6 +7370,35 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		dragDropEnabled = wParam != 0;
 		break;
 
+	case Message::SetFrameTraceCapacity:
+		frameTrace.SetCapacity(static_cast<int>(wParam));
+		break;
+
+	case Message::GetFrameTraceCapacity:
+		return frameTrace.Capacity();
+
+	case Message::GetFrameTraceCount:
+		return frameTrace.Count(static_cast<FrameTraceSpan>(wParam));
+
+	case Message::GetFrameTraceDuration:
+		return static_cast<sptr_t>(frameTrace.Duration(static_cast<FrameTraceSpan>(wParam)));
+
+	case Message::GetPositionCacheHitRate:
+		return frameTrace.CacheHitRate();
+
+	case Message::SetLineBitmapCache:
+		view.lineBitmaps.SetBudget(static_cast<int>(wParam));
+		Redraw();
+		break;
+
+	case Message::GetLineBitmapCache:
+		return view.lineBitmaps.Budget();
+
+	case Message::GetFrameTrace: {
+		const std::string json = frameTrace.ChromeTraceJSON();
+		return BytesResult(lParam, json);
+	}
+
 	case Message::GetPhasesDraw:
 		return static_cast<sptr_t>(view.phasesDraw);
 
@@ -7952,12 +8104,14 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		}
 
 	case Message::GetFoldLevel:
+		pdoc->EnsureLineFolded(LineFromUPtr(wParam));
 		return pdoc->GetLevel(LineFromUPtr(wParam));
 
 	case Message::GetLastChild:
 		return pdoc->GetLastChild(LineFromUPtr(wParam), (lParam < 0 ? FoldLevel::None : static_cast<FoldLevel>(lParam)));
 
 	case Message::GetFoldParent:
+		pdoc->EnsureLineFolded(LineFromUPtr(wParam));
 		return pdoc->GetFoldParent(LineFromUPtr(wParam));
 
 	case Message::ShowLines:
@@ -8029,6 +8183,7 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		break;
 
 	case Message::FoldChildren:
+		pdoc->EnsureLineFolded(LineFromUPtr(wParam));
 		FoldExpand(LineFromUPtr(wParam), static_cast<FoldAction>(lParam), pdoc->GetFoldLevel(wParam));
 		break;
 
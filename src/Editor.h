@@ -277,9 +277,11 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	bool paintAbandonedByStyling;
 	bool paintingAllText;
 	bool willRedrawAll;
+	bool redrawForScroll;
 	WorkNeeded workNeeded;
 	Scintilla::IdleStyling idleStyling;
 	bool needIdleStyling;
+	bool needLayoutPrefetch;
 
 	bool recordingMacro;
 	bool convertPastes;
@@ -356,6 +358,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	virtual void Redraw() noexcept;
 	void RedrawSelMargin(Sci::Line line = -1, bool allAfter = false) noexcept;
 	PRectangle RectangleFromRange(Range r, int overlap) const noexcept;
+	void InvalidateLineBitmaps(Sci::Position start, Sci::Position end) noexcept;
 	void InvalidateRange(Sci::Position start, Sci::Position end) noexcept;
 
 	bool UserVirtualSpace() const noexcept {
@@ -434,6 +437,8 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 		wsAll, wsVisible, wsIdle
 	};
 	bool WrapLines(WrapScope ws);
+	void NeedLayoutPrefetch(int xOffsetNew) noexcept;
+	bool PrefetchLayout();
 	void LinesJoin();
 	void LinesSplit(int pixelWidth);
 
@@ -612,6 +617,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 
 	virtual bool SupportsFeature(Scintilla::Supports feature) const;
 	virtual bool SCICALL PaintContains(PRectangle rc) const noexcept;
+	bool SCICALL PaintIntersects(PRectangle rc) const noexcept override;
 	bool PaintContainsMargin() const noexcept;
 	void CheckForChangeOutsidePaint(Range r) noexcept;
 	void SetBraceHighlight(Sci::Position pos0, Sci::Position pos1, int matchStyle) noexcept;
@@ -0,0 +1,152 @@
+// Scintilla source code edit control
+/** @file FrameTrace.cxx
+ ** Record timed spans of painting, layout, wrapping and styling for diagnosing slow frames.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <thread>
+
+#include "ScintillaTypes.h"
+
+#include "Position.h"
+#include "ElapsedPeriod.h"
+#include "FrameTrace.h"
+
+using namespace Scintilla;
+using namespace Scintilla::Internal;
+
+namespace {
+
+constexpr int maxFrameTraceCapacity = 1024*1024;
+
+struct SpanInfo {
+	const char *name;
+	const char *arg1;
+	const char *arg2;
+};
+
+constexpr SpanInfo spanInfos[] = {
+	{ "Paint", "topLine", "linesOnScreen" },
+	{ "PaintText", "visibleFirst", "visibleLast" },
+	{ "LayoutLine", "line", "posInLine" },
+	{ "WrapLines", "lineStart", "lineEnd" },
+	{ "Colourise", "start", "end" },
+	{ "PositionCache", "hits", "misses" },
+	{ "Fold", "start", "end" },
+};
+
+uint32_t CurrentThreadId() noexcept {
+	return static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+}
+
+}
+
+namespace Scintilla::Internal {
+
+FrameTrace frameTrace;
+
+}
+
+void FrameTrace::SetCapacity(int capacity_) {
+	enabled.store(false, std::memory_order_relaxed);
+	capacity_ = std::clamp(capacity_, 0, maxFrameTraceCapacity);
+	events.reset();
+	capacity = capacity_;
+	count = 0;
+	cacheHits = 0;
+	cacheMisses = 0;
+	if (capacity) {
+		events = std::make_unique<TraceEvent[]>(capacity);
+		frequency = QueryPerformanceFrequency();
+		origin = QueryPerformanceCounter();
+		enabled.store(true, std::memory_order_relaxed);
+	}
+}
+
+void FrameTrace::Add(FrameTraceSpan span, int64_t begin, Sci::Position arg1, Sci::Position arg2) noexcept {
+	if (Enabled()) {
+		const int64_t end = (span == FrameTraceSpan::PositionCache) ? begin : QueryPerformanceCounter();
+		const uint32_t slot = count.fetch_add(1, std::memory_order_relaxed) % capacity;
+		events[slot] = { begin, end, arg1, arg2, CurrentThreadId(), span };
+	}
+}
+
+void FrameTrace::AddCacheCounter() noexcept {
+	if (Enabled()) {
+		Add(FrameTraceSpan::PositionCache, QueryPerformanceCounter(), cacheHits, cacheMisses);
+	}
+}
+
+int FrameTrace::Count(FrameTraceSpan span) const noexcept {
+	const uint32_t recorded = std::min(count.load(), capacity);
+	int total = 0;
+	for (uint32_t i = 0; i < recorded; i++) {
+		total += events[i].span == span;
+	}
+	return total;
+}
+
+int64_t FrameTrace::Duration(FrameTraceSpan span) const noexcept {
+	const uint32_t recorded = std::min(count.load(), capacity);
+	int64_t total = 0;
+	for (uint32_t i = 0; i < recorded; i++) {
+		const TraceEvent &event = events[i];
+		if (event.span == span) {
+			total += event.end - event.begin;
+		}
+	}
+	// in microseconds
+	return total * 1000'000 / frequency;
+}
+
+int FrameTrace::CacheHitRate() const noexcept {
+	const uint32_t hits = cacheHits;
+	const uint32_t total = hits + cacheMisses;
+	return total ? static_cast<int>(hits * UINT64_C(100) / total) : 0;
+}
+
+std::string FrameTrace::ChromeTraceJSON() const {
+	std::string json = "{\"traceEvents\":[";
+	const uint32_t total = count.load();
+	const uint32_t recorded = std::min(total, capacity);
+	// oldest first
+	const uint32_t first = (total > capacity) ? total % capacity : 0;
+	const double scale = 1e6 / static_cast<double>(frequency);
+	char buffer[256];
+	for (uint32_t i = 0; i < recorded; i++) {
+		const TraceEvent &event = events[(first + i) % capacity];
+		const SpanInfo &info = spanInfos[static_cast<int>(event.span)];
+		const double ts = static_cast<double>(event.begin - origin) * scale;
+		int len;
+		if (event.span == FrameTraceSpan::PositionCache) {
+			len = snprintf(buffer, sizeof(buffer),
+				"%s\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"%s\":%zd,\"%s\":%zd}}",
+				i ? "," : "", info.name, event.threadId, ts, info.arg1, static_cast<ptrdiff_t>(event.arg1), info.arg2, static_cast<ptrdiff_t>(event.arg2));
+		} else {
+			const double dur = static_cast<double>(event.end - event.begin) * scale;
+			len = snprintf(buffer, sizeof(buffer),
+				"%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"%s\":%zd,\"%s\":%zd}}",
+				i ? "," : "", info.name, event.threadId, ts, dur, info.arg1, static_cast<ptrdiff_t>(event.arg1), info.arg2, static_cast<ptrdiff_t>(event.arg2));
+		}
+		json.append(buffer, len);
+	}
+	json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+	return json;
+}
+
+TraceScope::TraceScope(FrameTraceSpan span_, Sci::Position arg1_, Sci::Position arg2_) noexcept :
+	arg1{arg1_}, arg2{arg2_}, span{span_} {
+	if (frameTrace.Enabled()) {
+		begin = QueryPerformanceCounter();
+	}
+}
@@ -0,0 +1,74 @@
+// Scintilla source code edit control
+/** @file FrameTrace.h
+ ** Record timed spans of painting, layout, wrapping and styling for diagnosing slow frames.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+#pragma once
+
+namespace Scintilla::Internal {
+
+struct TraceEvent {
+	int64_t begin;
+	int64_t end;
+	Sci::Position arg1;
+	Sci::Position arg2;
+	uint32_t threadId;
+	Scintilla::FrameTraceSpan span;
+};
+
+// Process wide ring buffer of the most recent spans, disabled until a capacity is set.
+// Slots are claimed atomically so spans may be recorded from wrapping threads,
+// reading and resizing only happen on the UI thread when no other thread is recording.
+class FrameTrace {
+	std::unique_ptr<TraceEvent[]> events;
+	uint32_t capacity = 0;
+	std::atomic<uint32_t> count = 0;
+	std::atomic<uint32_t> cacheHits = 0;
+	std::atomic<uint32_t> cacheMisses = 0;
+	int64_t origin = 0;
+	int64_t frequency = 1;
+	std::atomic<bool> enabled = false;
+public:
+	bool Enabled() const noexcept {
+		return enabled.load(std::memory_order_relaxed);
+	}
+	void SetCapacity(int capacity_);
+	int Capacity() const noexcept {
+		return capacity;
+	}
+	void Add(Scintilla::FrameTraceSpan span, int64_t begin, Sci::Position arg1, Sci::Position arg2) noexcept;
+	void CountCache(bool hit) noexcept {
+		if (Enabled()) {
+			(hit ? cacheHits : cacheMisses).fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	void AddCacheCounter() noexcept;
+	int Count(Scintilla::FrameTraceSpan span) const noexcept;
+	int64_t Duration(Scintilla::FrameTraceSpan span) const noexcept;
+	int CacheHitRate() const noexcept;
+	std::string ChromeTraceJSON() const;
+};
+
+extern FrameTrace frameTrace;
+
+// Record the lifetime of the scope as a span when tracing is enabled.
+class TraceScope {
+	int64_t begin = 0;
+	Sci::Position arg1;
+	Sci::Position arg2;
+	Scintilla::FrameTraceSpan span;
+public:
+	explicit TraceScope(Scintilla::FrameTraceSpan span_, Sci::Position arg1_ = 0, Sci::Position arg2_ = 0) noexcept;
+	// Deleted so TraceScope objects can not be copied.
+	TraceScope(const TraceScope &) = delete;
+	TraceScope(TraceScope &&) = delete;
+	TraceScope &operator=(const TraceScope &) = delete;
+	TraceScope &operator=(TraceScope &&) = delete;
+	~TraceScope() {
+		if (begin) {
+			frameTrace.Add(span, begin, arg1, arg2);
+		}
+	}
+};
+
+}
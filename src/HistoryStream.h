@@ -0,0 +1,98 @@
+// Scintilla source code edit control
+/** @file HistoryStream.h
+ ** Variable length integer encoding used for compound undo actions and saved undo history.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+#pragma once
+
+namespace Scintilla::Internal {
+
+// Unsigned values are stored 7 bits per byte, least significant first, with the high bit
+// set on all but the last byte. Signed values are zigzag encoded so small magnitudes stay short.
+
+constexpr size_t maxVarintLength = 10;
+
+inline size_t WriteVarint(char *out, size_t value) noexcept {
+	size_t length = 0;
+	while (value >= 0x80) {
+		out[length++] = static_cast<char>((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	out[length++] = static_cast<char>(value);
+	return length;
+}
+
+inline bool ReadVarint(std::string_view &data, size_t &value) noexcept {
+	value = 0;
+	for (unsigned int shift = 0; shift < 64 && !data.empty(); shift += 7) {
+		const unsigned char ch = data.front();
+		data.remove_prefix(1);
+		value |= static_cast<size_t>(ch & 0x7F) << shift;
+		if (ch < 0x80) {
+			return true;
+		}
+	}
+	return false;
+}
+
+constexpr size_t ZigZagEncode(intptr_t value) noexcept {
+	return (static_cast<size_t>(value) << 1) ^ static_cast<size_t>(value >> (sizeof(intptr_t)*8 - 1));
+}
+
+constexpr intptr_t ZigZagDecode(size_t value) noexcept {
+	return static_cast<intptr_t>(value >> 1) ^ -static_cast<intptr_t>(value & 1);
+}
+
+class HistoryWriter {
+	std::string &out;
+public:
+	explicit HistoryWriter(std::string &out_) noexcept : out{out_} {}
+	void Unsigned(size_t value) {
+		char buffer[maxVarintLength];
+		out.append(buffer, WriteVarint(buffer, value));
+	}
+	void Signed(intptr_t value) {
+		Unsigned(ZigZagEncode(value));
+	}
+	void Bytes(std::string_view text) {
+		out.append(text);
+	}
+};
+
+// Reads values in the order they were written, throwing when the data ends early
+// or a value is outside the range expected by the caller.
+class HistoryReader {
+	std::string_view data;
+public:
+	explicit HistoryReader(std::string_view data_) noexcept : data{data_} {}
+	[[noreturn]] static void Fail() {
+		throw std::runtime_error("HistoryReader: invalid undo history data.");
+	}
+	[[nodiscard]] bool AtEnd() const noexcept {
+		return data.empty();
+	}
+	size_t Unsigned(size_t maxValue = SIZE_MAX) {
+		size_t value = 0;
+		if (!ReadVarint(data, value) || value > maxValue) {
+			Fail();
+		}
+		return value;
+	}
+	intptr_t Signed(intptr_t minValue, intptr_t maxValue) {
+		const intptr_t value = ZigZagDecode(Unsigned());
+		if (value < minValue || value > maxValue) {
+			Fail();
+		}
+		return value;
+	}
+	std::string_view Bytes(size_t length) {
+		if (length > data.length()) {
+			Fail();
+		}
+		const std::string_view text = data.substr(0, length);
+		data.remove_prefix(length);
+		return text;
+	}
+};
+
+}
@@ -167,6 +167,16 @@ public:
 		body.Delete(partition);
 	}
 
+	void RemovePartitions(T partition, T count) {
+		if (partition > stepPartition) {
+			ApplyStep(partition);
+		}
+		// Partitions inside the removed range that had not yet received the step are dropped,
+		// so the step only needs to move back past the ones that had.
+		stepPartition -= std::min(count, stepPartition - partition + 1);
+		body.DeleteRange(partition, count);
+	}
+
 	T PositionFromPartition(T partition) const noexcept {
 		PLATFORM_ASSERT(partition >= 0);
 		PLATFORM_ASSERT(partition < body.Length());
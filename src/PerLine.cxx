@@ -12,9 +12,9 @@
 
 #include <stdexcept>
 #include <utility>
+#include <string>
 #include <string_view>
 #include <vector>
-#include <forward_list>
 #include <optional>
 #include <algorithm>
 #include <memory>
@@ -33,130 +33,193 @@
 
 using namespace Scintilla::Internal;
 
-MarkerHandleSet::MarkerHandleSet() noexcept = default;
+namespace {
+
+constexpr Sci::Line markerBlockLines = 64;
 
-bool MarkerHandleSet::Empty() const noexcept {
-	return mhList.empty();
 }
 
-MarkerMask MarkerHandleSet::MarkValue() const noexcept {
-	MarkerMask m = 0;
-	for (const MarkerHandleNumber &mhn : mhList) {
-		m |= (1U << mhn.number);
+void LineMarkers::CombineBlock(Sci::Line block) noexcept {
+	const Sci::Line lineEnd = blocks.PositionFromPartition(block + 1);
+	MarkerMask mask = 0;
+	for (Sci::Line line = blocks.PositionFromPartition(block); line < lineEnd; line++) {
+		mask |= masks[line];
 	}
-	return m;
+	blockMasks[block] = mask;
 }
 
-bool MarkerHandleSet::Contains(int handle) const noexcept {
-	for (const MarkerHandleNumber &mhn : mhList) {
-		if (mhn.handle == handle) {
-			return true;
+void LineMarkers::SplitBlock(Sci::Line block) {
+	// Keep blocks short so few lines are scanned in a block with a wanted marker
+	const Sci::Line blockFirst = block;
+	Sci::Line lineStart = blocks.PositionFromPartition(block);
+	const Sci::Line lineEnd = blocks.PositionFromPartition(block + 1);
+	while (lineEnd - lineStart > 2*markerBlockLines) {
+		lineStart += markerBlockLines;
+		block++;
+		blocks.InsertPartition(block, lineStart);
+		blockMasks.Insert(block, 0);
+	}
+	if (block != blockFirst) {
+		for (Sci::Line split = blockFirst; split <= block; split++) {
+			CombineBlock(split);
 		}
 	}
-	return false;
 }
 
-MarkerHandleNumber const *MarkerHandleSet::GetMarkerHandleNumber(int which) const noexcept {
-	for (const MarkerHandleNumber &mhn : mhList) {
-		if (which == 0)
-			return &mhn;
-		which--;
+void LineMarkers::JoinBlock(Sci::Line block) {
+	// Join a block with the next one while they are short together
+	if (block + 1 < blocks.Partitions()) {
+		const Sci::Line lineStart = blocks.PositionFromPartition(block);
+		const Sci::Line lineEnd = blocks.PositionFromPartition(block + 2);
+		if (lineEnd - lineStart <= markerBlockLines) {
+			blockMasks[block] |= blockMasks[block + 1];
+			blocks.RemovePartition(block + 1);
+			blockMasks.Delete(block + 1);
+		}
 	}
-	return nullptr;
-}
-
-bool MarkerHandleSet::InsertHandle(int handle, int markerNum) {
-	mhList.emplace_front(handle, markerNum);
-	return true;
-}
-
-void MarkerHandleSet::RemoveHandle(int handle) {
-	mhList.remove_if([handle](const MarkerHandleNumber &mhn) noexcept { return mhn.handle == handle; });
 }
 
-bool MarkerHandleSet::RemoveNumber(int markerNum, bool all) {
-	bool performedDeletion = false;
-	mhList.remove_if([&](const MarkerHandleNumber &mhn) noexcept {
-		if ((all || !performedDeletion) && (mhn.number == markerNum)) {
-			performedDeletion = true;
-			return true;
+void LineMarkers::RecalculateMask(Sci::Line line) noexcept {
+	MarkerMask mask = 0;
+	if (handles[line]) {
+		for (const MarkerHandleNumber &mhn : *handles[line]) {
+			mask |= 1U << mhn.number;
 		}
-		return false;
-	});
-	return performedDeletion;
-}
-
-void MarkerHandleSet::CombineWith(MarkerHandleSet *other) noexcept {
-	mhList.splice_after(mhList.before_begin(), other->mhList);
+		if (handles[line]->empty()) {
+			handles[line].reset();
+		}
+	}
+	masks[line] = mask;
+	// Markers may have been removed so combine the block again
+	CombineBlock(blocks.PartitionFromPosition(line));
 }
 
 void LineMarkers::Init() {
-	markers.DeleteAll();
+	masks.DeleteAll();
+	handles.DeleteAll();
+	blocks.DeleteAll();
+	blockMasks.DeleteAll();
 }
 
 bool LineMarkers::IsActive() const noexcept {
-	return markers.Length() != 0;
+	return masks.Length() != 0;
 }
 
 void LineMarkers::InsertLine(Sci::Line line) {
-	if (markers.Length()) {
-		markers.Insert(line, nullptr);
-	}
+	InsertLines(line, 1);
 }
 
 void LineMarkers::InsertLines(Sci::Line line, Sci::Line lines) {
-	if (markers.Length()) {
-		markers.InsertEmpty(line, lines);
+	if (masks.Length()) {
+		masks.InsertValue(line, lines, 0);
+		handles.InsertEmpty(line, lines);
+		// New lines have no markers so the mask of the block they join stays the same
+		const Sci::Line block = blocks.PartitionFromPosition(line);
+		blocks.InsertText(block, lines);
+		SplitBlock(block);
 	}
 }
 
 void LineMarkers::RemoveLine(Sci::Line line) {
-	// Retain the markers from the deleted line by oring them into the previous line
-	if (markers.Length()) {
+	RemoveLines(line, 1);
+}
+
+void LineMarkers::RemoveLines(Sci::Line line, Sci::Line lines) {
+	if (masks.Length()) {
+		// Retain the markers from the deleted lines by merging them into the previous line.
+		// Each deleted line's markers go in front of those already there, so the last
+		// deleted line ends up first.
+		for (Sci::Line lineMerge = line; lineMerge < line + lines; lineMerge++) {
+			if (masks[lineMerge]) {
+				if (line > 0) {
+					masks[line - 1] |= masks[lineMerge];
+					std::unique_ptr<MarkerHandleList> &target = handles[line - 1];
+					if (!target) {
+						target = std::move(handles[lineMerge]);
+					} else {
+						const MarkerHandleList &source = *handles[lineMerge];
+						target->insert(target->begin(), source.begin(), source.end());
+					}
+				}
+				// Elements deleted from a SplitVector are not destroyed
+				handles[lineMerge].reset();
+			}
+		}
+		masks.DeleteRange(line, lines);
+		handles.DeleteRange(line, lines);
+
+		// Shrink the blocks that held the deleted lines, removing those left empty
+		Sci::Line block = blocks.PartitionFromPosition(line);
+		Sci::Line remaining = lines;
+		while (remaining > 0) {
+			const Sci::Line lineStart = blocks.PositionFromPartition(block);
+			const Sci::Line lineEnd = blocks.PositionFromPartition(block + 1);
+			const Sci::Line removed = std::min(lineEnd, line + remaining) - std::max(lineStart, line);
+			blocks.InsertText(block, -removed);
+			remaining -= removed;
+			if ((lineEnd - lineStart == removed) && (blocks.Partitions() > 1)) {
+				// The first block always starts at line 0 so remove the start of the next block instead
+				blocks.RemovePartition(std::max<Sci::Line>(block, 1));
+				blockMasks.Delete(block);
+			} else {
+				block++;
+			}
+		}
 		if (line > 0) {
-			MergeMarkers(line - 1);
+			const Sci::Line blockBefore = blocks.PartitionFromPosition(line - 1);
+			CombineBlock(blockBefore);
+			JoinBlock(blockBefore);
+		}
+		if (line < masks.Length()) {
+			const Sci::Line blockAfter = blocks.PartitionFromPosition(line);
+			CombineBlock(blockAfter);
+			JoinBlock(blockAfter);
 		}
-		markers.Delete(line);
 	}
 }
 
 Sci::Line LineMarkers::LineFromHandle(int markerHandle) const noexcept {
-	for (Sci::Line line = 0; line < markers.Length(); line++) {
-		if (markers[line] && markers[line]->Contains(markerHandle)) {
-			return line;
+	// Only look in blocks and lines that have markers
+	for (Sci::Line block = 0; block < blocks.Partitions(); block++) {
+		if (blockMasks[block]) {
+			const Sci::Line lineEnd = blocks.PositionFromPartition(block + 1);
+			for (Sci::Line line = blocks.PositionFromPartition(block); line < lineEnd; line++) {
+				if (masks[line]) {
+					for (const MarkerHandleNumber &mhn : *handles[line]) {
+						if (mhn.handle == markerHandle) {
+							return line;
+						}
+					}
+				}
+			}
 		}
 	}
 	return -1;
 }
 
 int LineMarkers::HandleFromLine(Sci::Line line, int which) const noexcept {
-	if (IsValidIndex(line, markers.Length()) && markers[line]) {
-		MarkerHandleNumber const *pnmh = markers[line]->GetMarkerHandleNumber(which);
-		return pnmh ? pnmh->handle : -1;
+	if (IsValidIndex(line, masks.Length()) && handles[line] && which >= 0) {
+		const MarkerHandleList &list = *handles[line];
+		if (static_cast<size_t>(which) < list.size()) {
+			return list[which].handle;
+		}
 	}
 	return -1;
 }
 
 int LineMarkers::NumberFromLine(Sci::Line line, int which) const noexcept {
-	if (IsValidIndex(line, markers.Length()) && markers[line]) {
-		MarkerHandleNumber const *pnmh = markers[line]->GetMarkerHandleNumber(which);
-		return pnmh ? pnmh->number : -1;
+	if (IsValidIndex(line, masks.Length()) && handles[line] && which >= 0) {
+		const MarkerHandleList &list = *handles[line];
+		if (static_cast<size_t>(which) < list.size()) {
+			return list[which].number;
+		}
 	}
 	return -1;
 }
 
-void LineMarkers::MergeMarkers(Sci::Line line) {
-	if (markers[line + 1]) {
-		if (!markers[line])
-			markers[line] = std::make_unique<MarkerHandleSet>();
-		markers[line]->CombineWith(markers[line + 1].get());
-		markers[line + 1].reset();
-	}
-}
-
 MarkerMask LineMarkers::MarkValue(Sci::Line line) const noexcept {
-	if (IsValidIndex(line, markers.Length()) && markers[line])
-		return markers[line]->MarkValue();
+	if (IsValidIndex(line, masks.Length()))
+		return masks[line];
 	else
 		return 0;
 }
@@ -164,42 +227,59 @@ MarkerMask LineMarkers::MarkValue(Sci::Line line) const noexcept {
 Sci::Line LineMarkers::MarkerNext(Sci::Line lineStart, MarkerMask mask) const noexcept {
 	if (lineStart < 0)
 		lineStart = 0;
-	const Sci::Line length = markers.Length();
-	for (Sci::Line iLine = lineStart; iLine < length; iLine++) {
-		const MarkerHandleSet *onLine = markers[iLine].get();
-		if (onLine && ((onLine->MarkValue() & mask) != 0))
-			return iLine;
+	if (lineStart >= masks.Length())
+		return -1;
+	for (Sci::Line block = blocks.PartitionFromPosition(lineStart); block < blocks.Partitions(); block++) {
+		if (blockMasks[block] & mask) {
+			const Sci::Line lineEnd = blocks.PositionFromPartition(block + 1);
+			for (Sci::Line line = std::max(lineStart, blocks.PositionFromPartition(block)); line < lineEnd; line++) {
+				if (masks[line] & mask)
+					return line;
+			}
+		}
 	}
 	return -1;
 }
 
 int LineMarkers::AddMark(Sci::Line line, int markerNum, Sci::Line lines) {
-	if (!markers.Length()) {
+	if (!masks.Length()) {
 		// No existing markers so allocate one element per line
-		markers.InsertEmpty(0, lines);
+		masks.InsertValue(0, lines, 0);
+		handles.InsertEmpty(0, lines);
+		blocks.InsertText(0, lines);
+		blockMasks.Insert(0, 0);
+		SplitBlock(0);
 	}
-	if (!markers[line]) {
-		// Need new structure to hold marker handle
-		markers[line] = std::make_unique<MarkerHandleSet>();
+	if (!handles[line]) {
+		// Need new list to hold marker handle
+		handles[line] = std::make_unique<MarkerHandleList>();
 	}
 
 	handleCurrent++;
-	markers[line]->InsertHandle(handleCurrent, markerNum);
+	handles[line]->insert(handles[line]->begin(), MarkerHandleNumber{handleCurrent, markerNum});
+	const MarkerMask bit = 1U << markerNum;
+	masks[line] |= bit;
+	blockMasks[blocks.PartitionFromPosition(line)] |= bit;
 	return handleCurrent;
 }
 
 bool LineMarkers::DeleteMark(Sci::Line line, int markerNum, bool all) {
 	bool someChanges = false;
-	if (IsValidIndex(line, markers.Length()) && markers[line]) {
+	if (IsValidIndex(line, masks.Length()) && handles[line]) {
+		MarkerHandleList &list = *handles[line];
 		if (markerNum < 0) {
 			someChanges = true;
-			markers[line].reset();
+			list.clear();
 		} else {
-			someChanges = markers[line]->RemoveNumber(markerNum, all);
-			if (markers[line]->Empty()) {
-				markers[line].reset();
-			}
+			list.erase(std::remove_if(list.begin(), list.end(), [&](const MarkerHandleNumber &mhn) noexcept {
+				if ((all || !someChanges) && (mhn.number == markerNum)) {
+					someChanges = true;
+					return true;
+				}
+				return false;
+			}), list.end());
 		}
+		RecalculateMask(line);
 	}
 	return someChanges;
 }
@@ -207,15 +287,50 @@ bool LineMarkers::DeleteMark(Sci::Line line, int markerNum, bool all) {
 void LineMarkers::DeleteMarkFromHandle(int markerHandle) {
 	const Sci::Line line = LineFromHandle(markerHandle);
 	if (line >= 0) {
-		markers[line]->RemoveHandle(markerHandle);
-		if (markers[line]->Empty()) {
-			markers[line].reset();
+		MarkerHandleList &list = *handles[line];
+		list.erase(std::remove_if(list.begin(), list.end(), [markerHandle](const MarkerHandleNumber &mhn) noexcept {
+			return mhn.handle == markerHandle;
+		}), list.end());
+		RecalculateMask(line);
+	}
+}
+
+namespace {
+
+constexpr Sci::Line foldBlockLines = 64;
+
+}
+
+const FoldBlock &LineLevels::Block(size_t block) const noexcept {
+	// Summarise any blocks from the first stale one up to block
+	while (blocksValid <= block) {
+		const Sci::Line lineStart = blocksValid * foldBlockLines;
+		const Sci::Line lineEnd = std::min(lineStart + foldBlockLines, levels.Length());
+		FoldBlock summary{FoldLevel::NumberMask, FoldLevel::NumberMask};
+		for (Sci::Line line = lineStart; line < lineEnd; line++) {
+			const FoldLevel level = GetFoldLevel(line);
+			const FoldLevel levelNumber = LevelNumberPart(level);
+			if (!LevelIsWhitespace(level)) {
+				summary.minLevel = std::min(summary.minLevel, levelNumber);
+			}
+			if (LevelIsHeader(level)) {
+				summary.minHeader = std::min(summary.minHeader, levelNumber);
+			}
 		}
+		blocks[blocksValid] = summary;
+		blocksValid++;
 	}
+	return blocks[block];
+}
+
+void LineLevels::InvalidateBlocks(Sci::Line line) {
+	blocks.resize((levels.Length() + foldBlockLines - 1) / foldBlockLines);
+	blocksValid = std::min<size_t>(blocksValid, std::max<Sci::Line>(line, 0) / foldBlockLines);
 }
 
 void LineLevels::Init() {
 	levels.DeleteAll();
+	InvalidateBlocks(0);
 }
 
 bool LineLevels::IsActive() const noexcept {
@@ -226,6 +341,7 @@ void LineLevels::InsertLine(Sci::Line line) {
 	if (levels.Length()) {
 		const int level = (line < levels.Length()) ? levels[line] : static_cast<int>(Scintilla::FoldLevel::Base);
 		levels.Insert(line, level);
+		InvalidateBlocks(line);
 	}
 }
 
@@ -233,6 +349,7 @@ void LineLevels::InsertLines(Sci::Line line, Sci::Line lines) {
 	if (levels.Length()) {
 		const int level = (line < levels.Length()) ? levels[line] : static_cast<int>(Scintilla::FoldLevel::Base);
 		levels.InsertValue(line, lines, level);
+		InvalidateBlocks(line);
 	}
 }
 
@@ -246,15 +363,34 @@ void LineLevels::RemoveLine(Sci::Line line) {
 			levels[line - 1] &= ~static_cast<int>(Scintilla::FoldLevel::HeaderFlag);
 		else if (line > 0)
 			levels[line - 1] |= firstHeader;
+		InvalidateBlocks(line - 1);
+	}
+}
+
+void LineLevels::RemoveLines(Sci::Line line, Sci::Line lines) {
+	if (levels.Length()) {
+		int firstHeader = 0;
+		for (Sci::Line lineRemove = line; lineRemove < line + lines; lineRemove++) {
+			firstHeader |= levels[lineRemove] & static_cast<int>(Scintilla::FoldLevel::HeaderFlag);
+		}
+		levels.DeleteRange(line, lines);
+		if (line == levels.Length() - 1) // Last line loses the header flag
+			levels[line - 1] &= ~static_cast<int>(Scintilla::FoldLevel::HeaderFlag);
+		else if (line > 0)
+			levels[line - 1] |= firstHeader;
+		InvalidateBlocks(line - 1);
 	}
 }
 
 void LineLevels::ExpandLevels(Sci::Line sizeNew) {
-	levels.InsertValue(levels.Length(), sizeNew - levels.Length(), static_cast<int>(Scintilla::FoldLevel::Base));
+	const Sci::Line lineStart = levels.Length();
+	levels.InsertValue(lineStart, sizeNew - lineStart, static_cast<int>(Scintilla::FoldLevel::Base));
+	InvalidateBlocks(lineStart);
 }
 
 void LineLevels::ClearLevels() {
 	levels.DeleteAll();
+	InvalidateBlocks(0);
 }
 
 int LineLevels::SetLevel(Sci::Line line, int level, Sci::Line lines) {
@@ -262,7 +398,11 @@ int LineLevels::SetLevel(Sci::Line line, int level, Sci::Line lines) {
 		if (!levels.Length()) {
 			ExpandLevels(lines + 1);
 		}
-		return levels.ReplaceValueAt(line, level);
+		const int prev = levels.ReplaceValueAt(line, level);
+		if (prev != level) {
+			InvalidateBlocks(line);
+		}
+		return prev;
 	}
 	return level;
 }
@@ -288,16 +428,45 @@ Sci::Line LineLevels::GetFoldParent(Sci::Line line) const noexcept {
 		if (level <= FoldLevel::Base) {
 			return -1;
 		}
-		for (Sci::Line lineLook = line - 1; lineLook >= 0; lineLook--) {
+		Sci::Line lineLook = line - 1;
+		while (lineLook >= 0) {
+			if ((lineLook % foldBlockLines) == foldBlockLines - 1 && Block(lineLook / foldBlockLines).minHeader >= level) {
+				// No header in this whole block can be the parent
+				lineLook -= foldBlockLines;
+				continue;
+			}
 			const FoldLevel levelTry = GetFoldLevel(lineLook);
 			if (LevelIsHeader(levelTry) && LevelNumberPart(levelTry) < level) {
 				return lineLook;
 			}
+			lineLook--;
 		}
 	}
 	return -1;
 }
 
+// Find the first line from lineStart before lineEnd that is not whitespace and has a level
+// number at or below level, ending the fold of a header with that level.
+// Returns lineEnd when all these lines are inside the fold.
+Sci::Line LineLevels::FindLevelAtOrBelow(Sci::Line lineStart, Sci::Line lineEnd, FoldLevel level) const noexcept {
+	if (lineEnd > levels.Length()) {
+		return lineStart;
+	}
+	Sci::Line line = lineStart;
+	while (line < lineEnd) {
+		if ((line % foldBlockLines) == 0 && line + foldBlockLines <= lineEnd && Block(line / foldBlockLines).minLevel > level) {
+			line += foldBlockLines;
+			continue;
+		}
+		const FoldLevel levelTry = GetFoldLevel(line);
+		if (!LevelIsWhitespace(levelTry) && LevelNumberPart(levelTry) <= level) {
+			return line;
+		}
+		line++;
+	}
+	return lineEnd;
+}
+
 void LineState::Init() {
 	lineStates.DeleteAll();
 }
@@ -326,6 +495,12 @@ void LineState::RemoveLine(Sci::Line line) {
 	}
 }
 
+void LineState::RemoveLines(Sci::Line line, Sci::Line lines) {
+	if (lineStates.Length() > line) {
+		lineStates.DeleteRange(line, std::min(lines, lineStates.Length() - line));
+	}
+}
+
 int LineState::SetLineState(Sci::Line line, int state, Sci::Line lines) {
 	if (IsValidIndex(line, lines)) {
 		lineStates.EnsureLength(lines + 1);
@@ -399,6 +574,16 @@ void LineAnnotation::RemoveLine(Sci::Line line) {
 	}
 }
 
+void LineAnnotation::RemoveLines(Sci::Line line, Sci::Line lines) {
+	if (IsValidIndex(line - 1, annotations.Length())) {
+		lines = std::min(lines, annotations.Length() - (line - 1));
+		for (Sci::Line lineRemove = line - 1; lineRemove < line - 1 + lines; lineRemove++) {
+			annotations[lineRemove].reset();
+		}
+		annotations.DeleteRange(line - 1, lines);
+	}
+}
+
 bool LineAnnotation::MultipleStyles(Sci::Line line) const noexcept {
 	if (IsValidIndex(line, annotations.Length()) && annotations[line])
 		return reinterpret_cast<AnnotationHeader *>(annotations[line].get())->style == IndividualStyles;
@@ -524,6 +709,16 @@ void LineTabstops::RemoveLine(Sci::Line line) {
 	}
 }
 
+void LineTabstops::RemoveLines(Sci::Line line, Sci::Line lines) {
+	if (tabstops.Length() > line) {
+		lines = std::min(lines, tabstops.Length() - line);
+		for (Sci::Line lineRemove = line; lineRemove < line + lines; lineRemove++) {
+			tabstops[lineRemove].reset();
+		}
+		tabstops.DeleteRange(line, lines);
+	}
+}
+
 bool LineTabstops::ClearTabstops(Sci::Line line) noexcept {
 	if (line < tabstops.Length()) {
 		TabstopList *tl = tabstops[line].get();
@@ -10,48 +10,49 @@ namespace Scintilla::Internal {
 
 /**
  * This holds the marker identifier and the marker type to display.
- * MarkerHandleNumbers are members of lists.
  */
 struct MarkerHandleNumber {
 	int handle;
 	int number;
-	MarkerHandleNumber(int handle_, int number_) noexcept : handle(handle_), number(number_) {}
 };
 
 /**
- * A marker handle set contains any number of MarkerHandleNumbers.
+ * The markers on one line, newest first.
  */
-class MarkerHandleSet {
-	std::forward_list<MarkerHandleNumber> mhList;
-
-public:
-	MarkerHandleSet() noexcept;
-	bool Empty() const noexcept;
-	MarkerMask MarkValue() const noexcept;	///< Bit set of marker numbers.
-	bool Contains(int handle) const noexcept;
-	bool InsertHandle(int handle, int markerNum);
-	void RemoveHandle(int handle);
-	bool RemoveNumber(int markerNum, bool all);
-	void CombineWith(MarkerHandleSet *other) noexcept;
-	MarkerHandleNumber const *GetMarkerHandleNumber(int which) const noexcept;
-};
+using MarkerHandleList = std::vector<MarkerHandleNumber>;
 
+/**
+ * Markers are held as a bit set of marker numbers for each line, with the bit sets of
+ * each block of lines combined so searches can skip blocks without the wanted markers.
+ * Blocks are partitions of the lines that grow and shrink as lines are inserted and removed,
+ * so an edit only updates the blocks it touches.
+ * Marked lines also hold their handles, so inserting or removing lines only moves the gap
+ * of the per line vectors instead of renumbering the handles after them.
+ */
 class LineMarkers final : public PerLine {
-	SplitVector<std::unique_ptr<MarkerHandleSet>> markers;
+	SplitVector<MarkerMask> masks;
+	SplitVector<std::unique_ptr<MarkerHandleList>> handles;
+	Partitioning<Sci::Line> blocks;
+	SplitVector<MarkerMask> blockMasks;
 	/// Handles are allocated sequentially and should never have to be reused as 32 bit ints are very big.
 	int handleCurrent;
+
+	void CombineBlock(Sci::Line block) noexcept;
+	void SplitBlock(Sci::Line block);
+	void JoinBlock(Sci::Line block);
+	void RecalculateMask(Sci::Line line) noexcept;
 public:
-	LineMarkers() noexcept : handleCurrent(0) {}
+	LineMarkers() : handleCurrent(0) {}
 	void Init() override;
 	bool IsActive() const noexcept override;
 	void InsertLine(Sci::Line line) override;
 	void InsertLines(Sci::Line line, Sci::Line lines) override;
 	void RemoveLine(Sci::Line line) override;
+	void RemoveLines(Sci::Line line, Sci::Line lines) override;
 
 	MarkerMask MarkValue(Sci::Line line) const noexcept;
 	Sci::Line MarkerNext(Sci::Line lineStart, MarkerMask mask) const noexcept;
 	int AddMark(Sci::Line line, int markerNum, Sci::Line lines);
-	void MergeMarkers(Sci::Line line);
 	bool DeleteMark(Sci::Line line, int markerNum, bool all);
 	void DeleteMarkFromHandle(int markerHandle);
 	Sci::Line LineFromHandle(int markerHandle) const noexcept;
@@ -59,9 +60,23 @@ public:
 	int NumberFromLine(Sci::Line line, int which) const noexcept;
 };
 
+/**
+ * Lowest fold level numbers found in a block of lines, used to skip blocks
+ * when searching for the end or the parent of a fold.
+ */
+struct FoldBlock {
+	Scintilla::FoldLevel minLevel;	///< Of lines that are not whitespace.
+	Scintilla::FoldLevel minHeader;	///< Of header lines.
+};
+
 class LineLevels final : public PerLine {
 	SplitVector<int> levels;
+	/// Summaries of blocks of lines, only the first blocksValid are up to date.
+	mutable std::vector<FoldBlock> blocks;
+	mutable size_t blocksValid = 0;
 	Scintilla::FoldLevel GetFoldLevel(Sci::Line line) const noexcept;
+	const FoldBlock &Block(size_t block) const noexcept;
+	void InvalidateBlocks(Sci::Line line);
 public:
 	LineLevels() noexcept = default;
 	void Init() override;
@@ -69,12 +84,14 @@ public:
 	void InsertLine(Sci::Line line) override;
 	void InsertLines(Sci::Line line, Sci::Line lines) override;
 	void RemoveLine(Sci::Line line) override;
+	void RemoveLines(Sci::Line line, Sci::Line lines) override;
 
 	void ExpandLevels(Sci::Line sizeNew = -1);
 	void ClearLevels();
 	int SetLevel(Sci::Line line, int level, Sci::Line lines);
 	int GetLevel(Sci::Line line) const noexcept;
 	Sci::Line GetFoldParent(Sci::Line line) const noexcept;
+	Sci::Line FindLevelAtOrBelow(Sci::Line lineStart, Sci::Line lineEnd, Scintilla::FoldLevel level) const noexcept;
 };
 
 class LineState final : public PerLine {
@@ -86,6 +103,7 @@ public:
 	void InsertLine(Sci::Line line) override;
 	void InsertLines(Sci::Line line, Sci::Line lines) override;
 	void RemoveLine(Sci::Line line) override;
+	void RemoveLines(Sci::Line line, Sci::Line lines) override;
 
 	int SetLineState(Sci::Line line, int state, Sci::Line lines);
 	int GetLineState(Sci::Line line) const noexcept;
@@ -102,6 +120,7 @@ public:
 	void InsertLine(Sci::Line line) override;
 	void InsertLines(Sci::Line line, Sci::Line lines) override;
 	void RemoveLine(Sci::Line line) override;
+	void RemoveLines(Sci::Line line, Sci::Line lines) override;
 
 	bool MultipleStyles(Sci::Line line) const noexcept;
 	int Style(Sci::Line line) const noexcept;
@@ -126,6 +145,7 @@ public:
 	void InsertLine(Sci::Line line) override;
 	void InsertLines(Sci::Line line, Sci::Line lines) override;
 	void RemoveLine(Sci::Line line) override;
+	void RemoveLines(Sci::Line line, Sci::Line lines) override;
 
 	bool ClearTabstops(Sci::Line line) noexcept;
 	bool AddTabstop(Sci::Line line, int x);
@@ -24,6 +24,7 @@
 #include <algorithm>
 #include <iterator>
 #include <memory>
+#include <atomic>
 
 #include "ParallelSupport.h"
 #include "ScintillaTypes.h"
@@ -60,6 +61,7 @@
 #include "PositionCache.h"
 #include "EditModel.h"
 //#include "ElapsedPeriod.h"
+#include "FrameTrace.h"
 
 using namespace Scintilla;
 using namespace Scintilla::Internal;
@@ -81,6 +83,10 @@ void LineLayout::Resize(int maxLineLength_) {
 		constexpr size_t sentinel = sizeof(int); // fix out-of-bounds read for KeyFromString()
 		constexpr size_t alignment = sizeof(XYPOSITION)*2;
 		unsigned length = maxLineLength_ + sentinel;
+		if (maxLineLength_ >= static_cast<int>(EditModel::ParallelLayoutBlockSize)) {
+			// reserve space for typing, so long line is not fully laid out again after small insertion.
+			length += maxLineLength_ >> 6;
+		}
 		length = NP2_align_up(length, alignment);
 		const size_t lineAllocation = length;
 		length -= sentinel;
@@ -94,6 +100,7 @@ void LineLayout::Resize(int maxLineLength_) {
 		positions = reinterpret_cast<XYPOSITION *>(styles + lineAllocation);
 		lineStarts.reset();
 		bidiData.reset();
+		segmentEnds.clear();
 	}
 }
 
@@ -110,10 +117,10 @@ void LineLayout::EnsureBidiData() {
 	}
 }
 
-void LineLayout::ClearPositions() const noexcept {
-	const unsigned length = numCharsInLine + sizeof(int);
-	//std::fill_n(positions, length, 0.0f);
-	memset(positions, 0, length * sizeof(XYPOSITION));
+void LineLayout::ClearPositions(int start) const noexcept {
+	const unsigned length = numCharsInLine + sizeof(int) - start;
+	//std::fill_n(positions + start, length, 0.0f);
+	memset(positions + start, 0, length * sizeof(XYPOSITION));
 }
 
 void LineLayout::Invalidate(ValidLevel validity_) noexcept {
@@ -125,6 +132,16 @@ bool LineLayout::CanHold(Sci::Line lineDoc, int lineLength_) const noexcept {
 	return (lineNumber == lineDoc) && (lineLength_ <= maxLineLength);
 }
 
+int LineLayout::SegmentEndBefore(int posInLine) const noexcept {
+	const auto it = std::upper_bound(segmentEnds.begin(), segmentEnds.end(), posInLine);
+	return (it == segmentEnds.begin()) ? 0 : *(it - 1);
+}
+
+void LineLayout::TruncateSegments(int posInLine) noexcept {
+	const auto it = std::upper_bound(segmentEnds.begin(), segmentEnds.end(), posInLine);
+	segmentEnds.erase(it, segmentEnds.end());
+}
+
 int LineLayout::LineStart(int line) const noexcept {
 	if (line <= 0) {
 		return 0;
@@ -1320,14 +1337,17 @@ void PositionCache::MeasureWidths(Surface *surface, const Style &style, unsigned
 
 		const LockGuard<NativeMutex> readLock(cacheLock);
 		if (entry->Retrieve(styleNumber, sv, positions)) {
+			frameTrace.CountCache(true);
 			return;
 		}
 
 		const size_t probe2 = (hashValue * 37) & mask;
 		entry2 = &pces[probe2];
 		if (entry2->Retrieve(styleNumber, sv, positions)) {
+			frameTrace.CountCache(true);
 			return;
 		}
+		frameTrace.CountCache(false);
 	}
 
 	if (styleNumber_ & positionCacheUnicode) {
@@ -70,6 +70,9 @@ public:
 	unsigned char *styles = nullptr;
 	XYPOSITION *positions = nullptr;
 	std::unique_ptr<BidiData> bidiData;
+	// Ends of laid out segments where BreakFinder restarts scanning,
+	// used to re-measure only segments touched by an edit on long lines.
+	std::vector<int> segmentEnds;
 
 	// Wrapped line support
 	int widthLine = wrapWidthInfinite;
@@ -80,7 +83,7 @@ public:
 	void Resize(int maxLineLength_);
 	void Reset(Sci::Line lineNumber_, int maxLineLength_);
 	void EnsureBidiData();
-	void ClearPositions() const noexcept;
+	void ClearPositions(int start = 0) const noexcept;
 	void Invalidate(ValidLevel validity_) noexcept;
 	Sci::Line LineNumber() const noexcept {
 		return lineNumber;
@@ -89,6 +92,8 @@ public:
 		return lastSegmentEnd < numCharsInLine;
 	}
 	bool CanHold(Sci::Line lineDoc, int lineLength_) const noexcept;
+	int SegmentEndBefore(int posInLine) const noexcept;
+	void TruncateSegments(int posInLine) noexcept;
 	int LineStart(int line) const noexcept;
 	int LineLength(int line) const noexcept;
 	enum class Scope {
@@ -310,6 +315,9 @@ public:
 	int CurrentPos() const noexcept {
 		return currentPos;
 	}
+	bool Subdividing() const noexcept {
+		return subBreak >= 0;
+	}
 };
 
 constexpr size_t positionCacheDefaultSize = 0x400;
@@ -124,6 +124,21 @@ DISTANCE RunStyles<DISTANCE, STYLE>::EndRun(DISTANCE position) const noexcept {
 	return starts.PositionFromPartition(starts.PartitionFromPosition(position) + 1);
 }
 
+template <typename DISTANCE, typename STYLE>
+DISTANCE RunStyles<DISTANCE, STYLE>::RunAt(DISTANCE position) const noexcept {
+	return starts.PartitionFromPosition(position);
+}
+
+template <typename DISTANCE, typename STYLE>
+DISTANCE RunStyles<DISTANCE, STYLE>::RunStart(DISTANCE run) const noexcept {
+	return starts.PositionFromPartition(run);
+}
+
+template <typename DISTANCE, typename STYLE>
+STYLE RunStyles<DISTANCE, STYLE>::RunValue(DISTANCE run) const noexcept {
+	return styles.ValueAt(run);
+}
+
 template <typename DISTANCE, typename STYLE>
 FillResult<DISTANCE> RunStyles<DISTANCE, STYLE>::FillRange(DISTANCE position, STYLE value, DISTANCE fillLength) {
 	const FillResult<DISTANCE> resultNoChange{ false, position, fillLength };
@@ -37,6 +37,11 @@ public:
 	DISTANCE FindNextChange(DISTANCE position, DISTANCE end) const noexcept;
 	DISTANCE StartRun(DISTANCE position) const noexcept;
 	DISTANCE EndRun(DISTANCE position) const noexcept;
+	// Visit consecutive runs with one search for the first: run at position then
+	// RunStart(run + 1) is its end and RunValue(run) its value
+	DISTANCE RunAt(DISTANCE position) const noexcept;
+	DISTANCE RunStart(DISTANCE run) const noexcept;
+	STYLE RunValue(DISTANCE run) const noexcept;
 	// Returns changed=true if some values may have changed
 	FillResult<DISTANCE> FillRange(DISTANCE position, STYLE value, DISTANCE fillLength);
 	void SetValueAt(DISTANCE position, STYLE value);
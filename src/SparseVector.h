@@ -60,6 +60,10 @@ public:
 		}
 	}
 
+	const T& ElementValueOr(Sci::Position element, const T& empty) const noexcept {
+		return values.ValueOr(element, empty);
+	}
+
 	const T& ValueOr(Sci::Position position, const T& empty) const noexcept {
 		assert(position <= Length());
 		const Sci::Position partition = ElementFromPosition(position);
@@ -400,6 +400,42 @@ public:
 		return result;
 	}
 
+	/// Return the number of leading elements in buffer that are same as the range starting at position.
+	ptrdiff_t CommonPrefix(const T *buffer, ptrdiff_t position, ptrdiff_t rangeLength) const noexcept {
+		ptrdiff_t same = 0;
+		const T* data = body.data() + position;
+		if (position < part1Length) {
+			const ptrdiff_t range1Length = std::min(rangeLength, part1Length - position);
+			while (same < range1Length && buffer[same] == data[same]) {
+				same++;
+			}
+			if (same < range1Length) {
+				return same;
+			}
+		}
+		data += gapLength;
+		while (same < rangeLength && buffer[same] == data[same]) {
+			same++;
+		}
+		return same;
+	}
+
+	/// Return the number of trailing elements in buffer that are same as the range ending at position + rangeLength.
+	ptrdiff_t CommonSuffix(const T *buffer, ptrdiff_t position, ptrdiff_t rangeLength) const noexcept {
+		ptrdiff_t index = rangeLength;
+		const T* data = body.data() + position;
+		const ptrdiff_t range1Length = std::clamp<ptrdiff_t>(part1Length - position, 0, rangeLength);
+		while (index > range1Length && buffer[index - 1] == data[gapLength + index - 1]) {
+			index--;
+		}
+		if (index == range1Length) {
+			while (index > 0 && buffer[index - 1] == data[index - 1]) {
+				index--;
+			}
+		}
+		return rangeLength - index;
+	}
+
 	/// Compact the buffer and return a pointer to the first element.
 	/// Also ensures there is an empty element beyond logical end in case its
 	/// passed to a function expecting a NUL terminated string.
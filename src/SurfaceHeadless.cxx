@@ -0,0 +1,540 @@
+// Scintilla source code edit control
+/** @file SurfaceHeadless.cxx
+ ** Portable surface without a window system for testing and benchmarking drawing.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <optional>
+#include <algorithm>
+#include <memory>
+
+#include "ScintillaTypes.h"
+#include "ILexer.h"
+
+#include "Debugging.h"
+#include "Geometry.h"
+#include "Platform.h"
+#include "CharClassify.h"
+#include "UniConversion.h"
+#include "SurfaceHeadless.h"
+
+using namespace Scintilla;
+using namespace Scintilla::Internal;
+
+namespace {
+
+constexpr int logPixelsHeadless = 96;
+constexpr int pointsPerInch = 72;
+
+// Common East Asian wide and fullwidth ranges occupy two cells.
+constexpr bool IsWideCharacter(unsigned int ch) noexcept {
+	return (ch >= 0x1100 && ch <= 0x115F)
+		|| (ch >= 0x2E80 && ch <= 0x303E)
+		|| (ch >= 0x3041 && ch <= 0x33FF)
+		|| (ch >= 0x3400 && ch <= 0x4DBF)
+		|| (ch >= 0x4E00 && ch <= 0x9FFF)
+		|| (ch >= 0xA000 && ch <= 0xA4CF)
+		|| (ch >= 0xAC00 && ch <= 0xD7A3)
+		|| (ch >= 0xF900 && ch <= 0xFAFF)
+		|| (ch >= 0xFE30 && ch <= 0xFE4F)
+		|| (ch >= 0xFF00 && ch <= 0xFF60)
+		|| (ch >= 0xFFE0 && ch <= 0xFFE6)
+		|| (ch >= 0x1F300 && ch <= 0x1F64F)
+		|| (ch >= 0x20000 && ch <= 0x3FFFD);
+}
+
+int PixelFloor(XYPOSITION xy) noexcept {
+	return static_cast<int>(std::floor(xy));
+}
+
+int PixelRound(XYPOSITION xy) noexcept {
+	return static_cast<int>(std::lround(xy));
+}
+
+unsigned int Mixed(unsigned int a, unsigned int b, XYPOSITION proportion) noexcept {
+	return static_cast<unsigned int>(std::lround(a + proportion * (static_cast<int>(b) - static_cast<int>(a))));
+}
+
+ColourRGBA MixedWith(ColourRGBA colour, ColourRGBA other, XYPOSITION proportion) noexcept {
+	return ColourRGBA(
+		Mixed(colour.GetRed(), other.GetRed(), proportion),
+		Mixed(colour.GetGreen(), other.GetGreen(), proportion),
+		Mixed(colour.GetBlue(), other.GetBlue(), proportion),
+		Mixed(colour.GetAlpha(), other.GetAlpha(), proportion));
+}
+
+const FontHeadless *HeadlessFont(const Font *font_) noexcept {
+	return down_cast<const FontHeadless *>(font_);
+}
+
+}
+
+FontHeadless::FontHeadless(const FontParameters &fp) noexcept {
+	// size is the device height from DeviceHeightFont, as on Win32.
+	const XYPOSITION height = std::max<XYPOSITION>(std::round(fp.size), 1.0);
+	ascent = std::round(height * 0.8);
+	descent = height - ascent;
+	charWidth = std::max<XYPOSITION>(std::round(height * 0.5), 1.0);
+}
+
+SurfaceHeadless::SurfaceHeadless(int width_, int height_, SurfaceMode mode_) :
+	width{std::max(width_, 0)}, height{std::max(height_, 0)}, mode{mode_} {
+	pixels.assign(static_cast<size_t>(width) * height, white);
+}
+
+ColourRGBA SurfaceHeadless::PixelAt(int x, int y) const noexcept {
+	if (x >= 0 && x < width && y >= 0 && y < height) {
+		return pixels[static_cast<size_t>(y) * width + x];
+	}
+	return ColourRGBA(0, 0, 0, 0);
+}
+
+PRectangle SurfaceHeadless::ClipBounds() const noexcept {
+	PRectangle bounds(0, 0, static_cast<XYPOSITION>(width), static_cast<XYPOSITION>(height));
+	for (const PRectangle &clip : clips) {
+		bounds.left = std::max(bounds.left, clip.left);
+		bounds.top = std::max(bounds.top, clip.top);
+		bounds.right = std::min(bounds.right, clip.right);
+		bounds.bottom = std::min(bounds.bottom, clip.bottom);
+	}
+	return bounds;
+}
+
+void SurfaceHeadless::Blend(int x, int y, ColourRGBA colour) noexcept {
+	ColourRGBA &pixel = pixels[static_cast<size_t>(y) * width + x];
+	if (colour.IsOpaque()) {
+		pixel = colour;
+	} else if (colour.GetAlpha()) {
+		pixel = ColourRGBA::AlphaBlend(colour, pixel, colour.GetAlpha());
+	}
+}
+
+void SurfaceHeadless::FillPixels(PRectangle rc, ColourRGBA colour) noexcept {
+	if (pixels.empty()) {
+		return;
+	}
+	const PRectangle bounds = ClipBounds();
+	const int left = std::max(PixelRound(rc.left), PixelRound(bounds.left));
+	const int right = std::min(PixelRound(rc.right), PixelRound(bounds.right));
+	const int top = std::max(PixelRound(rc.top), PixelRound(bounds.top));
+	const int bottom = std::min(PixelRound(rc.bottom), PixelRound(bounds.bottom));
+	for (int y = top; y < bottom; y++) {
+		for (int x = left; x < right; x++) {
+			Blend(x, y, colour);
+		}
+	}
+}
+
+void SurfaceHeadless::FramePixels(PRectangle rc, Stroke stroke) noexcept {
+	const XYPOSITION strokeWidth = std::max<XYPOSITION>(std::round(stroke.width), 1.0);
+	if (rc.Width() <= 2 * strokeWidth || rc.Height() <= 2 * strokeWidth) {
+		FillPixels(rc, stroke.colour);
+		return;
+	}
+	FillPixels(PRectangle(rc.left, rc.top, rc.right, rc.top + strokeWidth), stroke.colour);
+	FillPixels(PRectangle(rc.left, rc.bottom - strokeWidth, rc.right, rc.bottom), stroke.colour);
+	FillPixels(PRectangle(rc.left, rc.top + strokeWidth, rc.left + strokeWidth, rc.bottom - strokeWidth), stroke.colour);
+	FillPixels(PRectangle(rc.right - strokeWidth, rc.top + strokeWidth, rc.right, rc.bottom - strokeWidth), stroke.colour);
+}
+
+void SurfaceHeadless::Init([[maybe_unused]] WindowID wid) noexcept {
+	Release();
+}
+
+void SurfaceHeadless::Init([[maybe_unused]] SurfaceID sid, [[maybe_unused]] WindowID wid, [[maybe_unused]] bool printing) noexcept {
+	Release();
+}
+
+std::unique_ptr<Surface> SurfaceHeadless::AllocatePixMap(int width_, int height_) {
+	return std::make_unique<SurfaceHeadless>(width_, height_, mode);
+}
+
+void SurfaceHeadless::SetMode(SurfaceMode mode_) noexcept {
+	mode = mode_;
+}
+
+void SurfaceHeadless::SetRenderingParams([[maybe_unused]] void *defaultRenderingParams, [[maybe_unused]] void *customRenderingParams) noexcept {
+}
+
+void SurfaceHeadless::Release() noexcept {
+	clips.clear();
+}
+
+bool SurfaceHeadless::SupportsFeature(Supports feature) const noexcept {
+	return feature == Supports::ThreadSafeMeasureWidths;
+}
+
+bool SurfaceHeadless::Initialised() const noexcept {
+	return true;
+}
+
+int SurfaceHeadless::LogPixelsY() const noexcept {
+	return logPixelsHeadless;
+}
+
+int SurfaceHeadless::PixelDivisions() const noexcept {
+	return 1;
+}
+
+int SurfaceHeadless::DeviceHeightFont(int points) const noexcept {
+	return points * logPixelsHeadless / pointsPerInch;
+}
+
+void SurfaceHeadless::LineDraw(Point start, Point end, Stroke stroke) noexcept {
+	// Like GDI, the end point is not drawn.
+	const XYPOSITION strokeWidth = std::max<XYPOSITION>(std::round(stroke.width), 1.0);
+	const XYPOSITION dx = end.x - start.x;
+	const XYPOSITION dy = end.y - start.y;
+	const int steps = std::max(std::abs(PixelRound(dx)), std::abs(PixelRound(dy)));
+	for (int i = 0; i < steps; i++) {
+		const XYPOSITION x = PixelFloor(start.x + dx * i / steps);
+		const XYPOSITION y = PixelFloor(start.y + dy * i / steps);
+		FillPixels(PRectangle(x, y, x + strokeWidth, y + strokeWidth), stroke.colour);
+	}
+}
+
+void SurfaceHeadless::PolyLine(const Point *pts, size_t npts, Stroke stroke) noexcept {
+	for (size_t i = 1; i < npts; i++) {
+		LineDraw(pts[i - 1], pts[i], stroke);
+	}
+}
+
+void SurfaceHeadless::Polygon(const Point *pts, size_t npts, FillStroke fillStroke) {
+	if (npts < 3 || pixels.empty()) {
+		return;
+	}
+	// Even-odd scanline fill through pixel centres.
+	XYPOSITION top = pts[0].y;
+	XYPOSITION bottom = pts[0].y;
+	for (size_t i = 1; i < npts; i++) {
+		top = std::min(top, pts[i].y);
+		bottom = std::max(bottom, pts[i].y);
+	}
+	std::vector<XYPOSITION> crossings;
+	for (int y = PixelFloor(top); y < PixelFloor(bottom) + 1; y++) {
+		const XYPOSITION yCentre = y + 0.5;
+		crossings.clear();
+		for (size_t i = 0; i < npts; i++) {
+			const Point a = pts[i];
+			const Point b = pts[(i + 1) % npts];
+			if ((a.y <= yCentre && yCentre < b.y) || (b.y <= yCentre && yCentre < a.y)) {
+				crossings.push_back(a.x + (yCentre - a.y) * (b.x - a.x) / (b.y - a.y));
+			}
+		}
+		std::sort(crossings.begin(), crossings.end());
+		for (size_t i = 0; i + 1 < crossings.size(); i += 2) {
+			const XYPOSITION left = std::ceil(crossings[i] - 0.5);
+			const XYPOSITION right = std::ceil(crossings[i + 1] - 0.5);
+			FillPixels(PRectangle(left, static_cast<XYPOSITION>(y), right, y + 1.0), fillStroke.fill.colour);
+		}
+	}
+	PolyLine(pts, npts, fillStroke.stroke);
+	LineDraw(pts[npts - 1], pts[0], fillStroke.stroke);
+}
+
+void SurfaceHeadless::RectangleDraw(PRectangle rc, FillStroke fillStroke) noexcept {
+	FillPixels(rc.Inset(fillStroke.stroke.width), fillStroke.fill.colour);
+	FramePixels(rc, fillStroke.stroke);
+}
+
+void SurfaceHeadless::RectangleFrame(PRectangle rc, Stroke stroke) noexcept {
+	FramePixels(rc, stroke);
+}
+
+void SurfaceHeadless::FillRectangle(PRectangle rc, Fill fill) noexcept {
+	FillPixels(rc, fill.colour);
+}
+
+void SurfaceHeadless::FillRectangleAligned(PRectangle rc, Fill fill) noexcept {
+	FillPixels(PixelAlign(rc, 1), fill.colour);
+}
+
+void SurfaceHeadless::FillRectangle(PRectangle rc, Surface &surfacePattern) noexcept {
+	const SurfaceHeadless &pattern = down_cast<SurfaceHeadless &>(surfacePattern);
+	if (pixels.empty() || pattern.pixels.empty()) {
+		// Something is wrong so display in red
+		FillPixels(rc, ColourRGBA(0xff, 0, 0));
+		return;
+	}
+	const PRectangle bounds = ClipBounds();
+	const int left = std::max(PixelRound(rc.left), PixelRound(bounds.left));
+	const int right = std::min(PixelRound(rc.right), PixelRound(bounds.right));
+	const int top = std::max(PixelRound(rc.top), PixelRound(bounds.top));
+	const int bottom = std::min(PixelRound(rc.bottom), PixelRound(bounds.bottom));
+	for (int y = top; y < bottom; y++) {
+		for (int x = left; x < right; x++) {
+			Blend(x, y, pattern.PixelAt((x - left) % pattern.width, (y - top) % pattern.height));
+		}
+	}
+}
+
+void SurfaceHeadless::RoundedRectangle(PRectangle rc, FillStroke fillStroke) noexcept {
+	RectangleDraw(rc, fillStroke);
+}
+
+void SurfaceHeadless::AlphaRectangle(PRectangle rc, [[maybe_unused]] XYPOSITION cornerSize, FillStroke fillStroke) noexcept {
+	RectangleDraw(rc, fillStroke);
+}
+
+void SurfaceHeadless::GradientRectangle(PRectangle rc, const std::vector<ColourStop> &stops, GradientOptions options) noexcept {
+	if (stops.empty()) {
+		return;
+	}
+	const bool horizontal = options == GradientOptions::leftToRight;
+	const int start = PixelRound(horizontal ? rc.left : rc.top);
+	const int end = PixelRound(horizontal ? rc.right : rc.bottom);
+	const XYPOSITION extent = std::max(end - start, 1);
+	for (int i = start; i < end; i++) {
+		const XYPOSITION position = (i - start + 0.5) / extent;
+		ColourRGBA colour = stops.back().colour;
+		if (position <= stops.front().position) {
+			colour = stops.front().colour;
+		} else {
+			for (size_t stop = 1; stop < stops.size(); stop++) {
+				if (position <= stops[stop].position) {
+					const ColourStop &before = stops[stop - 1];
+					const XYPOSITION span = stops[stop].position - before.position;
+					const XYPOSITION proportion = (span > 0) ? (position - before.position) / span : 1.0;
+					colour = MixedWith(before.colour, stops[stop].colour, proportion);
+					break;
+				}
+			}
+		}
+		const PRectangle rcStrip = horizontal ?
+			PRectangle(static_cast<XYPOSITION>(i), rc.top, i + 1.0, rc.bottom) :
+			PRectangle(rc.left, static_cast<XYPOSITION>(i), rc.right, i + 1.0);
+		FillPixels(rcStrip, colour);
+	}
+}
+
+void SurfaceHeadless::DrawRGBAImage(PRectangle rc, int width_, int height_, const unsigned char *pixelsImage) noexcept {
+	if (pixels.empty() || rc.Width() <= 0 || width_ <= 0 || height_ <= 0) {
+		return;
+	}
+	// Centred and unscaled, as on other platforms.
+	if (rc.Width() > width_)
+		rc.left += std::floor((rc.Width() - width_) / 2);
+	if (rc.Height() > height_)
+		rc.top += std::floor((rc.Height() - height_) / 2);
+	const PRectangle bounds = ClipBounds();
+	const int left = PixelRound(rc.left);
+	const int top = PixelRound(rc.top);
+	for (int y = 0; y < height_; y++) {
+		const int yDest = top + y;
+		if (yDest < bounds.top || yDest >= bounds.bottom) {
+			continue;
+		}
+		for (int x = 0; x < width_; x++) {
+			const int xDest = left + x;
+			if (xDest >= bounds.left && xDest < bounds.right) {
+				const unsigned char *pixel = pixelsImage + (static_cast<size_t>(y) * width_ + x) * 4;
+				Blend(xDest, yDest, ColourRGBA(pixel[0], pixel[1], pixel[2], pixel[3]));
+			}
+		}
+	}
+}
+
+void SurfaceHeadless::Ellipse(PRectangle rc, FillStroke fillStroke) noexcept {
+	if (pixels.empty() || rc.Width() <= 0 || rc.Height() <= 0) {
+		return;
+	}
+	const XYPOSITION radiusX = rc.Width() / 2;
+	const XYPOSITION radiusY = rc.Height() / 2;
+	const Point centre = rc.Centre();
+	const XYPOSITION strokeWidth = std::max<XYPOSITION>(std::round(fillStroke.stroke.width), 1.0);
+	const XYPOSITION innerX = std::max<XYPOSITION>(radiusX - strokeWidth, 0.0);
+	const XYPOSITION innerY = std::max<XYPOSITION>(radiusY - strokeWidth, 0.0);
+	for (int y = PixelFloor(rc.top); y < PixelRound(rc.bottom); y++) {
+		for (int x = PixelFloor(rc.left); x < PixelRound(rc.right); x++) {
+			const XYPOSITION dx = x + 0.5 - centre.x;
+			const XYPOSITION dy = y + 0.5 - centre.y;
+			if ((dx * dx) / (radiusX * radiusX) + (dy * dy) / (radiusY * radiusY) <= 1.0) {
+				const bool inner = innerX > 0 && innerY > 0 &&
+					(dx * dx) / (innerX * innerX) + (dy * dy) / (innerY * innerY) <= 1.0;
+				const PRectangle rcPixel(static_cast<XYPOSITION>(x), static_cast<XYPOSITION>(y), x + 1.0, y + 1.0);
+				FillPixels(rcPixel, inner ? fillStroke.fill.colour : fillStroke.stroke.colour);
+			}
+		}
+	}
+}
+
+void SurfaceHeadless::Stadium(PRectangle rc, FillStroke fillStroke, [[maybe_unused]] Ends ends) noexcept {
+	RectangleDraw(rc, fillStroke);
+}
+
+void SurfaceHeadless::Copy(PRectangle rc, Point from, Surface &surfaceSource) noexcept {
+	const SurfaceHeadless &source = down_cast<SurfaceHeadless &>(surfaceSource);
+	if (pixels.empty() || source.pixels.empty()) {
+		return;
+	}
+	const PRectangle bounds = ClipBounds();
+	const int left = PixelRound(rc.left);
+	const int top = PixelRound(rc.top);
+	const int xFrom = PixelRound(from.x);
+	const int yFrom = PixelRound(from.y);
+	for (int y = 0; y < PixelRound(rc.Height()); y++) {
+		const int yDest = top + y;
+		if (yDest < bounds.top || yDest >= bounds.bottom) {
+			continue;
+		}
+		for (int x = 0; x < PixelRound(rc.Width()); x++) {
+			const int xDest = left + x;
+			if (xDest >= bounds.left && xDest < bounds.right) {
+				pixels[static_cast<size_t>(yDest) * width + xDest] = source.PixelAt(xFrom + x, yFrom + y);
+			}
+		}
+	}
+}
+
+std::unique_ptr<IScreenLineLayout> SurfaceHeadless::Layout(const IScreenLine *) noexcept {
+	return {};
+}
+
+void SurfaceHeadless::DrawGlyphs(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text, ColourRGBA fore, bool utf8) {
+	if (pixels.empty() || text.empty()) {
+		return;
+	}
+	// Each character is a solid block from the ascent to the baseline leaving a one pixel gap
+	// on its right, spaces and control characters are blank.
+	const FontHeadless *font = HeadlessFont(font_);
+	std::vector<XYPOSITION> positions(text.length());
+	MeasureWidthsCommon(font_, text, positions.data(), utf8);
+	XYPOSITION left = rc.left;
+	for (size_t i = 0; i < text.length(); i++) {
+		const XYPOSITION right = rc.left + positions[i];
+		if (right > left) {
+			const unsigned char ch = text[i];
+			if (ch > ' ' && ch != 0x7F) {
+				FillPixels(PRectangle(left, ybase - font->ascent, std::max(right - 1, left + 1), ybase), fore);
+			}
+			left = right;
+		}
+	}
+}
+
+void SurfaceHeadless::DrawTextNoClip(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text, ColourRGBA fore, ColourRGBA back) {
+	FillPixels(rc, back);
+	DrawGlyphs(rc, font_, ybase, text, fore, mode.codePage == CpUtf8);
+}
+
+void SurfaceHeadless::DrawTextClipped(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text, ColourRGBA fore, ColourRGBA back) {
+	FillPixels(rc, back);
+	SetClip(rc);
+	DrawGlyphs(rc, font_, ybase, text, fore, mode.codePage == CpUtf8);
+	PopClip();
+}
+
+void SurfaceHeadless::DrawTextTransparent(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text, ColourRGBA fore) {
+	DrawGlyphs(rc, font_, ybase, text, fore, mode.codePage == CpUtf8);
+}
+
+void SurfaceHeadless::MeasureWidthsCommon(const Font *font_, std::string_view text, XYPOSITION *positions, bool utf8) const noexcept {
+	// Every byte of a character is given the position of the end of that character.
+	const XYPOSITION charWidth = HeadlessFont(font_)->charWidth;
+	const size_t length = text.length();
+	const bool dbcs = !utf8 && IsDBCSCodePage(mode.codePage);
+	XYPOSITION position = 0;
+	size_t i = 0;
+	while (i < length) {
+		const unsigned char ch = text[i];
+		size_t lenChar = 1;
+		int cells = 1;
+		if (utf8) {
+			// invalid bytes are treated as single characters
+			lenChar = UTF8DrawBytes(text.data() + i, length - i);
+			if (lenChar > 1 && IsWideCharacter(UnicodeFromUTF8(reinterpret_cast<const unsigned char *>(text.data() + i)))) {
+				cells = 2;
+			}
+		} else if (dbcs && DBCSIsLeadByte(mode.codePage, ch) && i + 1 < length) {
+			lenChar = 2;
+			cells = 2;
+		}
+		position += charWidth * cells;
+		for (size_t j = 0; j < lenChar; j++) {
+			positions[i++] = position;
+		}
+	}
+}
+
+void SurfaceHeadless::MeasureWidths(const Font *font_, std::string_view text, XYPOSITION *positions) noexcept {
+	MeasureWidthsCommon(font_, text, positions, mode.codePage == CpUtf8);
+}
+
+XYPOSITION SurfaceHeadless::WidthText(const Font *font_, std::string_view text) {
+	if (text.empty()) {
+		return 0;
+	}
+	std::vector<XYPOSITION> positions(text.length());
+	MeasureWidths(font_, text, positions.data());
+	return positions.back();
+}
+
+void SurfaceHeadless::DrawTextNoClipUTF8(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text, ColourRGBA fore, ColourRGBA back) {
+	FillPixels(rc, back);
+	DrawGlyphs(rc, font_, ybase, text, fore, true);
+}
+
+void SurfaceHeadless::DrawTextClippedUTF8(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text, ColourRGBA fore, ColourRGBA back) {
+	FillPixels(rc, back);
+	SetClip(rc);
+	DrawGlyphs(rc, font_, ybase, text, fore, true);
+	PopClip();
+}
+
+void SurfaceHeadless::DrawTextTransparentUTF8(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text, ColourRGBA fore) {
+	DrawGlyphs(rc, font_, ybase, text, fore, true);
+}
+
+void SurfaceHeadless::MeasureWidthsUTF8(const Font *font_, std::string_view text, XYPOSITION *positions) noexcept {
+	MeasureWidthsCommon(font_, text, positions, true);
+}
+
+XYPOSITION SurfaceHeadless::WidthTextUTF8(const Font *font_, std::string_view text) {
+	if (text.empty()) {
+		return 0;
+	}
+	std::vector<XYPOSITION> positions(text.length());
+	MeasureWidthsUTF8(font_, text, positions.data());
+	return positions.back();
+}
+
+FontMetrics SurfaceHeadless::Metrics(const Font *font_) noexcept {
+	const FontHeadless *font = HeadlessFont(font_);
+	return { font->ascent, font->descent, 0, font->ascent + font->descent };
+}
+
+void SurfaceHeadless::SetClip(PRectangle rc) noexcept {
+	clips.push_back(rc);
+}
+
+void SurfaceHeadless::PopClip() noexcept {
+	if (!clips.empty()) {
+		clips.pop_back();
+	}
+}
+
+void SurfaceHeadless::FlushCachedState() noexcept {
+}
+
+void SurfaceHeadless::FlushDrawing() noexcept {
+}
+
+namespace Scintilla::Internal {
+
+std::shared_ptr<Font> FontHeadless_Allocate(const FontParameters &fp) {
+	return std::make_shared<FontHeadless>(fp);
+}
+
+std::unique_ptr<Surface> SurfaceHeadless_Allocate(int width, int height, SurfaceMode mode) {
+	return std::make_unique<SurfaceHeadless>(width, height, mode);
+}
+
+}
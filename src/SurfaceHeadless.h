@@ -0,0 +1,115 @@
+// Scintilla source code edit control
+/** @file SurfaceHeadless.h
+ ** Portable surface without a window system for testing and benchmarking drawing.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+#pragma once
+
+namespace Scintilla::Internal {
+
+// Font with deterministic metrics derived only from its size, every character
+// is a cell of charWidth pixels except East Asian wide characters which are two cells.
+class FontHeadless final : public Font {
+public:
+	XYPOSITION ascent;
+	XYPOSITION descent;
+	XYPOSITION charWidth;
+	explicit FontHeadless(const FontParameters &fp) noexcept;
+};
+
+/**
+ * Surface that measures text with FontHeadless metrics and, when allocated with a size,
+ * rasterises into an in-memory RGBA pixel buffer. Shapes are drawn with simple pixel
+ * aligned approximations and glyphs as solid blocks, so output is identical on every host.
+ */
+class SurfaceHeadless final : public Surface {
+	int width = 0;
+	int height = 0;
+	std::vector<ColourRGBA> pixels;
+	std::vector<PRectangle> clips;
+	SurfaceMode mode;
+
+	PRectangle ClipBounds() const noexcept;
+	void Blend(int x, int y, ColourRGBA colour) noexcept;
+	void FillPixels(PRectangle rc, ColourRGBA colour) noexcept;
+	void FramePixels(PRectangle rc, Stroke stroke) noexcept;
+	void DrawGlyphs(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text, ColourRGBA fore, bool utf8);
+	void MeasureWidthsCommon(const Font *font_, std::string_view text, XYPOSITION *positions, bool utf8) const noexcept;
+
+public:
+	SurfaceHeadless() noexcept = default;
+	SurfaceHeadless(int width_, int height_, SurfaceMode mode_);
+	// Deleted so SurfaceHeadless objects can not be copied.
+	SurfaceHeadless(const SurfaceHeadless &) = delete;
+	SurfaceHeadless(SurfaceHeadless &&) = delete;
+	SurfaceHeadless &operator=(const SurfaceHeadless &) = delete;
+	SurfaceHeadless &operator=(SurfaceHeadless &&) = delete;
+	~SurfaceHeadless() noexcept override = default;
+
+	int Width() const noexcept {
+		return width;
+	}
+	int Height() const noexcept {
+		return height;
+	}
+	// Pixel buffer in rows, empty for surfaces only used for measuring.
+	const ColourRGBA *Pixels() const noexcept {
+		return pixels.data();
+	}
+	ColourRGBA PixelAt(int x, int y) const noexcept;
+
+	void Init(WindowID wid) noexcept override;
+	void Init(SurfaceID sid, WindowID wid, bool printing = false) noexcept override;
+	std::unique_ptr<Surface> AllocatePixMap(int width_, int height_) override;
+
+	void SetMode(SurfaceMode mode_) noexcept override;
+	void SetRenderingParams(void *defaultRenderingParams, void *customRenderingParams) noexcept override;
+
+	void Release() noexcept override;
+	bool SupportsFeature(Scintilla::Supports feature) const noexcept override;
+	bool Initialised() const noexcept override;
+	int LogPixelsY() const noexcept override;
+	int PixelDivisions() const noexcept override;
+	int DeviceHeightFont(int points) const noexcept override;
+	void SCICALL LineDraw(Point start, Point end, Stroke stroke) noexcept override;
+	void SCICALL PolyLine(const Point *pts, size_t npts, Stroke stroke) noexcept override;
+	void SCICALL Polygon(const Point *pts, size_t npts, FillStroke fillStroke) override;
+	void SCICALL RectangleDraw(PRectangle rc, FillStroke fillStroke) noexcept override;
+	void SCICALL RectangleFrame(PRectangle rc, Stroke stroke) noexcept override;
+	void SCICALL FillRectangle(PRectangle rc, Fill fill) noexcept override;
+	void SCICALL FillRectangleAligned(PRectangle rc, Fill fill) noexcept override;
+	void SCICALL FillRectangle(PRectangle rc, Surface &surfacePattern) noexcept override;
+	void SCICALL RoundedRectangle(PRectangle rc, FillStroke fillStroke) noexcept override;
+	void SCICALL AlphaRectangle(PRectangle rc, XYPOSITION cornerSize, FillStroke fillStroke) noexcept override;
+	void SCICALL GradientRectangle(PRectangle rc, const std::vector<ColourStop> &stops, GradientOptions options) noexcept override;
+	void SCICALL DrawRGBAImage(PRectangle rc, int width_, int height_, const unsigned char *pixelsImage) noexcept override;
+	void SCICALL Ellipse(PRectangle rc, FillStroke fillStroke) noexcept override;
+	void SCICALL Stadium(PRectangle rc, FillStroke fillStroke, Ends ends) noexcept override;
+	void SCICALL Copy(PRectangle rc, Point from, Surface &surfaceSource) noexcept override;
+
+	std::unique_ptr<IScreenLineLayout> Layout(const IScreenLine *screenLine) noexcept override;
+
+	void SCICALL DrawTextNoClip(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text, ColourRGBA fore, ColourRGBA back) override;
+	void SCICALL DrawTextClipped(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text, ColourRGBA fore, ColourRGBA back) override;
+	void SCICALL DrawTextTransparent(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text, ColourRGBA fore) override;
+	void SCICALL MeasureWidths(const Font *font_, std::string_view text, XYPOSITION *positions) noexcept override;
+	XYPOSITION WidthText(const Font *font_, std::string_view text) override;
+
+	void SCICALL DrawTextNoClipUTF8(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text, ColourRGBA fore, ColourRGBA back) override;
+	void SCICALL DrawTextClippedUTF8(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text, ColourRGBA fore, ColourRGBA back) override;
+	void SCICALL DrawTextTransparentUTF8(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text, ColourRGBA fore) override;
+	void SCICALL MeasureWidthsUTF8(const Font *font_, std::string_view text, XYPOSITION *positions) noexcept override;
+	XYPOSITION WidthTextUTF8(const Font *font_, std::string_view text) override;
+
+	FontMetrics Metrics(const Font *font_) noexcept override;
+
+	void SCICALL SetClip(PRectangle rc) noexcept override;
+	void PopClip() noexcept override;
+	void FlushCachedState() noexcept override;
+	void FlushDrawing() noexcept override;
+};
+
+std::shared_ptr<Font> FontHeadless_Allocate(const FontParameters &fp);
+std::unique_ptr<Surface> SurfaceHeadless_Allocate(int width = 0, int height = 0, SurfaceMode mode = {});
+
+}
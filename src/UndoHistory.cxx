@@ -32,6 +32,7 @@
 #include "Partitioning.h"
 #include "RunStyles.h"
 #include "SparseVector.h"
+#include "HistoryStream.h"
 #include "ChangeHistory.h"
 #include "CellBuffer.h"
 #include "UndoHistory.h"
@@ -194,6 +195,10 @@ void ScaledVector::Truncate(size_t length) noexcept {
 	assert(bytes.size() == length * element.size);
 }
 
+void ScaledVector::DropFront(size_t length) noexcept {
+	bytes.erase(bytes.begin(), bytes.begin() + length * element.size);
+}
+
 void ScaledVector::ReSize(size_t length) {
 	bytes.resize(length * element.size);
 }
@@ -215,6 +220,12 @@ void UndoActions::Truncate(size_t length) noexcept {
 	lengths.Truncate(length);
 }
 
+void UndoActions::DropFront(size_t length) noexcept {
+	types.erase(types.begin(), types.begin() + length);
+	positions.DropFront(length);
+	lengths.DropFront(length);
+}
+
 void UndoActions::PushBack() {
 	types.emplace_back();
 	positions.PushBack();
@@ -231,9 +242,14 @@ intptr_t UndoActions::SSize() const noexcept {
 	return types.size();
 }
 
+size_t UndoActions::SizeInBytes() const noexcept {
+	return types.size() * sizeof(UndoActionType) + positions.SizeInBytes() + lengths.SizeInBytes();
+}
+
 void UndoActions::Create(size_t index, ActionType at_, Sci::Position position_, Sci::Position lenData_, bool mayCoalesce_) {
 	types[index].at = at_;
 	types[index].mayCoalesce = mayCoalesce_;
+	types[index].compound = false;
 	positions.SetValueAt(index, position_);
 	lengths.SetValueAt(index, lenData_);
 }
@@ -261,18 +277,270 @@ Sci::Position UndoActions::Length(int action) const noexcept {
 	return lengths.SignedValueAt(action);
 }
 
+namespace {
+
+// Compress scraps with a byte oriented LZ77 format similar to LZ4 blocks: each sequence is a token
+// byte holding literal length and match length - 4 in its high and low nibbles, with 15 extended by
+// following bytes, then the literals and a 2 byte match offset. The last sequence has no match.
+
+constexpr int hashBits = 12;
+constexpr size_t minMatch = 4;
+constexpr size_t maxOffset = UINT16_MAX;
+constexpr size_t lastLiterals = 12;
+
+inline uint32_t Read32(const char *text) noexcept {
+	uint32_t value;
+	memcpy(&value, text, sizeof(value));
+	return value;
+}
+
+void AppendLength(std::string &out, size_t length) {
+	while (length >= UINT8_MAX) {
+		out.push_back(static_cast<char>(UINT8_MAX));
+		length -= UINT8_MAX;
+	}
+	out.push_back(static_cast<char>(length));
+}
+
+void AppendSequence(std::string &out, const char *literals, size_t lengthLiterals, size_t offset, size_t lengthMatch) {
+	const size_t matchCode = lengthMatch ? lengthMatch - minMatch : 0;
+	const unsigned int token = (std::min<size_t>(lengthLiterals, 15) << 4) | std::min<size_t>(matchCode, 15);
+	out.push_back(static_cast<char>(token));
+	if (lengthLiterals >= 15) {
+		AppendLength(out, lengthLiterals - 15);
+	}
+	out.append(literals, lengthLiterals);
+	if (lengthMatch) {
+		out.push_back(static_cast<char>(offset & byteMask));
+		out.push_back(static_cast<char>(offset >> 8));
+		if (matchCode >= 15) {
+			AppendLength(out, matchCode - 15);
+		}
+	}
+}
+
+void CompressBlock(const char *text, size_t length, std::string &out) {
+	uint32_t table[1 << hashBits]{};	// position + 1 of last occurrence of each hashed 4 bytes
+	size_t anchor = 0;
+	size_t i = 0;
+	const size_t limit = (length > lastLiterals) ? length - lastLiterals : 0;
+	while (i < limit) {
+		const uint32_t sequence = Read32(text + i);
+		const uint32_t hash = (sequence * 2654435761U) >> (32 - hashBits);
+		const size_t candidate = table[hash];
+		table[hash] = static_cast<uint32_t>(i + 1);
+		if (candidate && (i + 1 - candidate) <= maxOffset && Read32(text + candidate - 1) == sequence) {
+			const size_t reference = candidate - 1;
+			size_t lengthMatch = minMatch;
+			while (i + lengthMatch < limit && text[reference + lengthMatch] == text[i + lengthMatch]) {
+				lengthMatch++;
+			}
+			AppendSequence(out, text + anchor, i - anchor, i - reference, lengthMatch);
+			i += lengthMatch;
+			anchor = i;
+		} else {
+			i++;
+		}
+	}
+	AppendSequence(out, text + anchor, length - anchor, 0, 0);
+}
+
+bool ReadLength(const uint8_t *data, size_t length, size_t &in, size_t &value) noexcept {
+	uint8_t ch;
+	do {
+		if (in >= length) {
+			return false;
+		}
+		ch = data[in++];
+		value += ch;
+	} while (ch == UINT8_MAX);
+	return true;
+}
+
+bool DecompressBlock(const char *compressed, size_t length, char *text, size_t lengthText) noexcept {
+	const uint8_t *data = reinterpret_cast<const uint8_t *>(compressed);
+	size_t in = 0;
+	size_t out = 0;
+	while (in < length) {
+		const unsigned int token = data[in++];
+		size_t lengthLiterals = token >> 4;
+		if (lengthLiterals == 15 && !ReadLength(data, length, in, lengthLiterals)) {
+			return false;
+		}
+		if (lengthLiterals > length - in || lengthLiterals > lengthText - out) {
+			return false;
+		}
+		memcpy(text + out, data + in, lengthLiterals);
+		in += lengthLiterals;
+		out += lengthLiterals;
+		if (in == length) {
+			break;
+		}
+		if (length - in < 2) {
+			return false;
+		}
+		const size_t offset = data[in] | (data[in + 1] << 8);
+		in += 2;
+		size_t lengthMatch = token & 15;
+		if (lengthMatch == 15 && !ReadLength(data, length, in, lengthMatch)) {
+			return false;
+		}
+		lengthMatch += minMatch;
+		if (offset == 0 || offset > out || lengthMatch > lengthText - out) {
+			return false;
+		}
+		// byte by byte as the match may overlap the text being produced
+		const char *source = text + out - offset;
+		for (size_t j = 0; j < lengthMatch; j++) {
+			text[out + j] = source[j];
+		}
+		out += lengthMatch;
+	}
+	return out == lengthText;
+}
+
+size_t WriteCompoundRange(char *out, Sci::Position delta, Sci::Position length) noexcept {
+	const size_t lengthDelta = WriteVarint(out, ZigZagEncode(delta));
+	return lengthDelta + WriteVarint(out + lengthDelta, length);
+}
+
+bool SeekSpill(FILE *fp, int64_t offset) noexcept {
+#if defined(_WIN32)
+	return _fseeki64(fp, offset, SEEK_SET) == 0;
+#else
+	return fseeko(fp, offset, SEEK_SET) == 0;
+#endif
+}
+
+}
+
+ScrapStack::~ScrapStack() noexcept {
+	if (spill) {
+		fclose(spill);
+	}
+}
+
 void ScrapStack::Clear() noexcept {
+	blocks.clear();
 	stack.clear();
+	base = 0;
+	discarded = 0;
 	current = 0;
+	window.clear();
+	windowStart = 0;
+	windowEnd = 0;
+	compressedInMemory = 0;
+	spilledBlocks = 0;
+	if (spill) {
+		// temporary file is deleted when closed
+		fclose(spill);
+		spill = nullptr;
+	}
+}
+
+void ScrapStack::ExpandBlock(size_t block, std::string &text) {
+	const ScrapBlock &scrapBlock = blocks[block];
+	const size_t start = text.length();
+	text.resize(start + scrapBlockSize);
+	bool valid;
+	if (scrapBlock.offset >= 0) {
+		std::string compressed(scrapBlock.length, '\0');
+		valid = SeekSpill(spill, scrapBlock.offset)
+			&& fread(compressed.data(), 1, scrapBlock.length, spill) == scrapBlock.length
+			&& DecompressBlock(compressed.data(), scrapBlock.length, text.data() + start, scrapBlockSize);
+	} else {
+		valid = DecompressBlock(scrapBlock.compressed.data(), scrapBlock.length, text.data() + start, scrapBlockSize);
+	}
+	if (!valid) {
+		throw std::runtime_error("ScrapStack::ExpandBlock: undo history text is damaged.");
+	}
+}
+
+void ScrapStack::Truncate(size_t position) {
+	position += discarded;
+	window.clear();
+	windowStart = 0;
+	windowEnd = 0;
+	if (position >= base) {
+		stack.resize(position - base);
+		return;
+	}
+	// Reopen the block containing position and drop all later text
+	const size_t block = position / scrapBlockSize;
+	std::string text;
+	ExpandBlock(block, text);
+	text.resize(position - block * scrapBlockSize);
+	for (size_t b = block; b < blocks.size(); b++) {
+		if (blocks[b].offset < 0) {
+			compressedInMemory -= blocks[b].length;
+		}
+	}
+	if (spilledBlocks > block) {
+		spilledBlocks = block;
+	}
+	blocks.resize(block);
+	stack = std::move(text);
+	base = block * scrapBlockSize;
+}
+
+void ScrapStack::Compact() {
+	// Keep the most recent block uncompressed as small edits and undos mostly touch it.
+	if (stack.length() < 2*scrapBlockSize) {
+		return;
+	}
+	const size_t count = (stack.length() / scrapBlockSize) - 1;
+	for (size_t i = 0; i < count; i++) {
+		ScrapBlock &scrapBlock = blocks.emplace_back();
+		CompressBlock(stack.data() + i * scrapBlockSize, scrapBlockSize, scrapBlock.compressed);
+		scrapBlock.compressed.shrink_to_fit();
+		scrapBlock.length = scrapBlock.compressed.length();
+		compressedInMemory += scrapBlock.length;
+	}
+	stack.erase(0, count * scrapBlockSize);
+	base += count * scrapBlockSize;
+	if (spillThreshold && compressedInMemory > spillThreshold) {
+		Spill();
+	}
+}
+
+void ScrapStack::Spill() noexcept {
+	if (!spill && !spillFailed) {
+		spill = tmpfile();
+		spillFailed = spill == nullptr;
+	}
+	if (!spill) {
+		// Keep everything in memory when no temporary file is available
+		return;
+	}
+	// Spilled blocks are written in order so the file ends after the last spilled block
+	int64_t offset = 0;
+	if (spilledBlocks) {
+		const ScrapBlock &last = blocks[spilledBlocks - 1];
+		offset = last.offset + last.length;
+	}
+	// Write down to half the threshold so spilling happens in batches
+	while (compressedInMemory > spillThreshold / 2 && spilledBlocks < blocks.size()) {
+		ScrapBlock &scrapBlock = blocks[spilledBlocks];
+		if (!SeekSpill(spill, offset) || fwrite(scrapBlock.compressed.data(), 1, scrapBlock.length, spill) != scrapBlock.length) {
+			spillFailed = true;
+			break;
+		}
+		compressedInMemory -= scrapBlock.length;
+		scrapBlock.offset = offset;
+		scrapBlock.compressed = std::string();
+		offset += scrapBlock.length;
+		spilledBlocks++;
+	}
 }
 
 const char *ScrapStack::Push(const char *text, size_t length) {
-	if (current < stack.length()) {
-		stack.resize(current);
+	if (current < Length()) {
+		Truncate(current);
 	}
+	Compact();
 	stack.append(text, length);
-	current = stack.length();
-	return stack.data() + current - length;
+	current = Length();
+	return stack.data() + stack.length() - length;
 }
 
 void ScrapStack::SetCurrent(size_t position) noexcept {
@@ -280,7 +548,7 @@ void ScrapStack::SetCurrent(size_t position) noexcept {
 }
 
 void ScrapStack::MoveForward(size_t length) noexcept {
-	if ((current + length) <= stack.length()) {
+	if ((current + length) <= Length()) {
 		current += length;
 	}
 }
@@ -291,12 +559,190 @@ void ScrapStack::MoveBack(size_t length) noexcept {
 	}
 }
 
-const char *ScrapStack::CurrentText() const noexcept {
-	return stack.data() + current;
+const char *ScrapStack::TextAt(size_t position, size_t length) {
+	position += discarded;
+	if (position >= base) {
+		return stack.data() + position - base;
+	}
+	const size_t end = position + length;
+	if (position < windowStart || end > windowEnd) {
+		// Expand the compressed blocks covering the range followed by any uncompressed text
+		const size_t first = position / scrapBlockSize;
+		window.clear();
+		windowStart = first * scrapBlockSize;
+		for (size_t block = first; block * scrapBlockSize < std::min(end, base); block++) {
+			ExpandBlock(block, window);
+		}
+		if (end > base) {
+			window.append(stack, 0, end - base);
+		}
+		windowEnd = windowStart + window.length();
+	}
+	return window.data() + position - windowStart;
+}
+
+size_t ScrapStack::SpilledLength() const noexcept {
+	// Spilled blocks are contiguous in the file, ending after the last spilled block
+	if (spilledBlocks == 0) {
+		return 0;
+	}
+	const ScrapBlock &last = blocks[spilledBlocks - 1];
+	return static_cast<size_t>(last.offset + last.length - blocks.front().offset);
+}
+
+void ScrapStack::CompactSpill() noexcept {
+	// Copy the spilled blocks still in use to the start of a new temporary file
+	FILE *fp = tmpfile();
+	if (!fp) {
+		return;
+	}
+	std::string compressed;
+	int64_t offset = 0;
+	for (size_t block = 0; block < spilledBlocks; block++) {
+		const ScrapBlock &scrapBlock = blocks[block];
+		compressed.resize(scrapBlock.length);
+		if (!SeekSpill(spill, scrapBlock.offset)
+			|| fread(compressed.data(), 1, scrapBlock.length, spill) != scrapBlock.length
+			|| fwrite(compressed.data(), 1, scrapBlock.length, fp) != scrapBlock.length) {
+			fclose(fp);
+			return;
+		}
+	}
+	for (size_t block = 0; block < spilledBlocks; block++) {
+		blocks[block].offset = offset;
+		offset += blocks[block].length;
+	}
+	fclose(spill);
+	spill = fp;
+}
+
+void ScrapStack::Discard(size_t length) {
+	discarded += length;
+	current -= std::min(current, length);
+	window.clear();
+	windowStart = 0;
+	windowEnd = 0;
+	// Release blocks entirely within discarded text and renumber the remainder from 0
+	const size_t release = std::min(discarded / scrapBlockSize, blocks.size());
+	if (release == 0) {
+		return;
+	}
+	for (size_t block = 0; block < release; block++) {
+		if (blocks[block].offset < 0) {
+			compressedInMemory -= blocks[block].length;
+		}
+	}
+	blocks.erase(blocks.begin(), blocks.begin() + release);
+	discarded -= release * scrapBlockSize;
+	base -= release * scrapBlockSize;
+	spilledBlocks -= std::min(spilledBlocks, release);
+	// Spilling restarts at the beginning of the file when no spilled blocks remain, otherwise
+	// reclaim file space once more of it is unused than used
+	if (spilledBlocks && static_cast<size_t>(blocks.front().offset) > SpilledLength()) {
+		CompactSpill();
+	}
+}
+
+size_t ScrapStack::Usage() const noexcept {
+	return compressedInMemory + SpilledLength() + stack.length();
+}
+
+size_t ScrapStack::LengthToRelease(size_t bytes) const noexcept {
+	size_t released = 0;
+	for (size_t block = 0; block < blocks.size(); block++) {
+		released += blocks[block].length;
+		if (released >= bytes) {
+			return (block + 1) * scrapBlockSize - discarded;
+		}
+	}
+	// Stack is not released so return length of all text
+	return Length();
+}
+
+void ScrapStack::SetSpillThreshold(size_t bytes) noexcept {
+	spillThreshold = bytes;
+	spillFailed = false;
+	if (spillThreshold && compressedInMemory > spillThreshold) {
+		Spill();
+	}
+}
+
+void ScrapStack::Save(HistoryWriter &writer) const {
+	// Compressed blocks are copied as is so saving and loading need not compress again
+	writer.Unsigned(scrapBlockSize);
+	writer.Unsigned(discarded);
+	writer.Unsigned(blocks.size());
+	std::string compressed;
+	for (const ScrapBlock &scrapBlock : blocks) {
+		writer.Unsigned(scrapBlock.length);
+		if (scrapBlock.offset >= 0) {
+			compressed.resize(scrapBlock.length);
+			if (!SeekSpill(spill, scrapBlock.offset) || fread(compressed.data(), 1, scrapBlock.length, spill) != scrapBlock.length) {
+				throw std::runtime_error("ScrapStack::Save: can not read undo history text.");
+			}
+			writer.Bytes(compressed);
+		} else {
+			writer.Bytes(scrapBlock.compressed);
+		}
+	}
+	writer.Unsigned(stack.length());
+	writer.Bytes(stack);
+}
+
+void ScrapStack::Load(HistoryReader &reader) {
+	Clear();
+	if (reader.Unsigned() != scrapBlockSize) {
+		HistoryReader::Fail();
+	}
+	const size_t discardedLoaded = reader.Unsigned();
+	const size_t count = reader.Unsigned();
+	std::string text(scrapBlockSize, '\0');
+	for (size_t i = 0; i < count; i++) {
+		const size_t length = reader.Unsigned();
+		const std::string_view compressed = reader.Bytes(length);
+		// Check now as blocks are next expanded while undoing where failure can not be handled
+		if (!DecompressBlock(compressed.data(), length, text.data(), scrapBlockSize)) {
+			HistoryReader::Fail();
+		}
+		ScrapBlock &scrapBlock = blocks.emplace_back();
+		scrapBlock.compressed = compressed;
+		scrapBlock.length = length;
+		compressedInMemory += length;
+	}
+	const size_t lengthStack = reader.Unsigned();
+	stack = reader.Bytes(lengthStack);
+	base = blocks.size() * scrapBlockSize;
+	if (discardedLoaded > base + stack.length()) {
+		HistoryReader::Fail();
+	}
+	discarded = discardedLoaded;
+	current = Length();
+	if (spillThreshold && compressedInMemory > spillThreshold) {
+		Spill();
+	}
 }
 
-const char *ScrapStack::TextAt(size_t position) const noexcept {
-	return stack.data() + position;
+bool CompoundReader::Next(CompoundRange &range) noexcept {
+	size_t delta = 0;
+	size_t length = 0;
+	if (!ReadVarint(data, delta) || !ReadVarint(data, length) || length > data.length()) {
+		return false;
+	}
+	position += ZigZagDecode(delta);
+	range = { position, data.substr(0, length) };
+	data.remove_prefix(length);
+	return true;
+}
+
+void DecodeCompound(const Action &action, std::vector<Action> &ranges) {
+	CompoundReader reader(action.position, std::string_view(action.data, action.lenData));
+	CompoundRange range{};
+	while (reader.Next(range)) {
+		ranges.push_back({ action.at, action.mayCoalesce, range.position, range.text.data(), static_cast<Sci::Position>(range.text.length()) });
+	}
+	if (!reader.AtEnd()) {
+		throw std::runtime_error("DecodeCompound: invalid compound undo action.");
+	}
 }
 
 // The undo history stores a sequence of user operations that represent the user's view of the
@@ -359,6 +805,9 @@ const char *UndoHistory::AppendAction(ActionType at, Sci::Position position, con
 				coalesce = false;
 			} else if (at == ActionType::container || actions.types[targetAct].at == ActionType::container) {
 				;	// A coalescible containerAction
+			} else if (actions.types[targetAct].compound) {
+				// Compound actions only grow inside groups typing at several selections
+				coalesce = false;
 			} else if ((at != actions.types[targetAct].at)) { // } && (!actions.AtStart(targetAct))) {
 				coalesce = false;
 			} else if ((at == ActionType::insert) &&
@@ -395,6 +844,14 @@ const char *UndoHistory::AppendAction(ActionType at, Sci::Position position, con
 	if ((currentAction > 0) && startSequence) {
 		actions.types[PreviousAction()].mayCoalesce = false;
 	}
+	if (coalesce && (mergeDepth > 0) && lengthData && (at != ActionType::container)
+		&& (currentAction != savePoint) && (currentAction != tentativePoint)) {
+		// Same kind of change at another selection
+		if ((actions.types[PreviousAction()].at == at) && actions.Length(PreviousAction())) {
+			return AppendCompound(position, data, lengthData);
+		}
+	}
+	compoundLast = {};
 	if (currentAction >= actions.SSize()) {
 		actions.PushBack();
 	} else {
@@ -406,18 +863,59 @@ const char *UndoHistory::AppendAction(ActionType at, Sci::Position position, con
 	return dataNew;
 }
 
-void UndoHistory::BeginUndoAction(bool mayCoalesce) noexcept {
+const char *UndoHistory::AppendCompound(Sci::Position position, const char *data, Sci::Position lengthData) {
+	const int previous = PreviousAction();
+	actions.Truncate(currentAction);
+	memory = {};
+	char header[2*maxVarintLength];
+	if (!actions.types[previous].compound) {
+		// Rewrite previous action as a compound action with a single range
+		const Sci::Position lengthPrevious = actions.Length(previous);
+		const size_t start = scraps->Current() - lengthPrevious;
+		const std::string text(scraps->TextAt(start, lengthPrevious), lengthPrevious);
+		scraps->SetCurrent(start);
+		const size_t lengthHeader = WriteCompoundRange(header, 0, lengthPrevious);
+		scraps->Push(header, lengthHeader);
+		scraps->Push(text.data(), text.length());
+		actions.types[previous].compound = true;
+		actions.lengths.SetValueAt(previous, lengthHeader + lengthPrevious);
+		compoundLast = actPos{ previous, static_cast<size_t>(actions.Position(previous)) };
+	} else if (!compoundLast || compoundLast->act != previous) {
+		// Find the last range of a compound action pushed by the container
+		const Sci::Position length = actions.Length(previous);
+		const char *text = scraps->TextAt(scraps->Current() - length, length);
+		CompoundReader reader(actions.Position(previous), std::string_view(text, length));
+		CompoundRange range{ actions.Position(previous), {} };
+		while (reader.Next(range)) {
+		}
+		compoundLast = actPos{ previous, static_cast<size_t>(range.position) };
+	}
+	const size_t lengthHeader = WriteCompoundRange(header, position - static_cast<Sci::Position>(compoundLast->position), lengthData);
+	scraps->Push(header, lengthHeader);
+	const char *dataNew = scraps->Push(data, lengthData);
+	actions.lengths.SetValueAt(previous, actions.Length(previous) + lengthHeader + lengthData);
+	compoundLast->position = position;
+	return dataNew;
+}
+
+void UndoHistory::BeginUndoAction(bool mayCoalesce, bool multipleSelection) noexcept {
 	if (undoSequenceDepth == 0) {
 		if (currentAction > 0) {
 			actions.types[PreviousAction()].mayCoalesce = mayCoalesce;
 		}
 	}
 	undoSequenceDepth++;
+	if (multipleSelection && (mergeDepth == 0)) {
+		mergeDepth = undoSequenceDepth;
+	}
 }
 
 void UndoHistory::EndUndoAction() noexcept {
 	PLATFORM_ASSERT(undoSequenceDepth > 0);
 	undoSequenceDepth--;
+	if (undoSequenceDepth < mergeDepth) {
+		mergeDepth = 0;
+	}
 	if (0 == undoSequenceDepth) {
 		if (currentAction > 0) {
 			actions.types[PreviousAction()].mayCoalesce = false;
@@ -439,6 +937,7 @@ bool UndoHistory::AfterUndoSequenceStart() const noexcept {
 
 void UndoHistory::DropUndoSequence() noexcept {
 	undoSequenceDepth = 0;
+	mergeDepth = 0;
 }
 
 void UndoHistory::DeleteUndoHistory() noexcept {
@@ -448,6 +947,7 @@ void UndoHistory::DeleteUndoHistory() noexcept {
 	tentativePoint = -1;
 	scraps->Clear();
 	memory = {};
+	compoundLast = {};
 }
 
 int UndoHistory::Actions() const noexcept {
@@ -507,16 +1007,27 @@ bool UndoHistory::AfterOrAtDetachPoint() const noexcept {
 	return detach && (*detach <= currentAction);
 }
 
-intptr_t UndoHistory::Delta(int action) const noexcept {
+intptr_t UndoHistory::Delta(int action) const {
 	intptr_t sizeChange = 0;
+	size_t position = 0;
 	for (int act = 0; act < action; act++) {
-		const intptr_t lengthChange = actions.Length(act);
+		const size_t length = actions.Length(act);
+		intptr_t lengthChange = length;
+		if (actions.types[act].compound) {
+			lengthChange = 0;
+			CompoundReader reader(actions.Position(act), std::string_view(scraps->TextAt(position, length), length));
+			CompoundRange range{};
+			while (reader.Next(range)) {
+				lengthChange += range.text.length();
+			}
+		}
+		position += length;
 		sizeChange += (actions.types[act].at == ActionType::insert) ? lengthChange : -lengthChange;
 	}
 	return sizeChange;
 }
 
-bool UndoHistory::Validate(intptr_t lengthDocument) const noexcept {
+bool UndoHistory::Validate(intptr_t lengthDocument) const {
 	// Check history for validity
 	const intptr_t sizeChange = Delta(currentAction);
 	if (sizeChange > lengthDocument) {
@@ -525,16 +1036,38 @@ bool UndoHistory::Validate(intptr_t lengthDocument) const noexcept {
 	}
 	const intptr_t lengthOriginal = lengthDocument - sizeChange;
 	intptr_t lengthCurrent = lengthOriginal;
+	size_t position = 0;
 	for (int act = 0; act < actions.SSize(); act++) {
-		const intptr_t lengthChange = actions.Length(act);
-		if (actions.Position(act) > lengthCurrent) {
-			// Change outside document.
-			return false;
-		}
-		lengthCurrent += (actions.types[act].at == ActionType::insert) ? lengthChange : -lengthChange;
-		if (lengthCurrent < 0) {
-			return false;
+		const size_t length = actions.Length(act);
+		const bool insertion = actions.types[act].at == ActionType::insert;
+		if (actions.types[act].compound) {
+			CompoundReader reader(actions.Position(act), std::string_view(scraps->TextAt(position, length), length));
+			CompoundRange range{};
+			while (reader.Next(range)) {
+				const intptr_t lengthChange = range.text.length();
+				if (range.position < 0 || range.position + (insertion ? 0 : lengthChange) > lengthCurrent) {
+					return false;
+				}
+				lengthCurrent += insertion ? lengthChange : -lengthChange;
+				if (lengthCurrent < 0) {
+					return false;
+				}
+			}
+			if (!reader.AtEnd()) {
+				return false;
+			}
+		} else {
+			const intptr_t lengthChange = length;
+			if (actions.Position(act) + (insertion ? 0 : lengthChange) > lengthCurrent) {
+				// Change outside document.
+				return false;
+			}
+			lengthCurrent += insertion ? lengthChange : -lengthChange;
+			if (lengthCurrent < 0) {
+				return false;
+			}
 		}
+		position += length;
 	}
 	return true;
 }
@@ -542,6 +1075,7 @@ bool UndoHistory::Validate(intptr_t lengthDocument) const noexcept {
 void UndoHistory::SetCurrent(int action, intptr_t lengthDocument) {
 	// Find position in scraps for action
 	memory = {};
+	compoundLast = {};
 	const size_t lengthSum = actions.LengthTo(action);
 	scraps->SetCurrent(lengthSum);
 	currentAction = action;
@@ -559,7 +1093,8 @@ int UndoHistory::Current() const noexcept {
 int UndoHistory::Type(int action) const noexcept {
 	const int baseType = static_cast<int>(actions.types[action].at);
 	const int open = actions.types[action].mayCoalesce ? coalesceFlag : 0;
-	return baseType | open;
+	const int compound = actions.types[action].compound ? compoundFlag : 0;
+	return baseType | open | compound;
 }
 
 Sci::Position UndoHistory::Position(int action) const noexcept {
@@ -570,7 +1105,7 @@ Sci::Position UndoHistory::Length(int action) const noexcept {
 	return actions.Length(action);
 }
 
-std::string_view UndoHistory::Text(int action) noexcept {
+std::string_view UndoHistory::Text(int action) {
 	// Assumes first call after any changes is for action 0.
 	// TODO: may need to invalidate memory in other circumstances
 	if (action == 0) {
@@ -586,7 +1121,7 @@ std::string_view UndoHistory::Text(int action) noexcept {
 		position += actions.Length(act);
 	}
 	const size_t length = actions.Length(action);
-	const char *scrap = scraps->TextAt(position);
+	const char *scrap = scraps->TextAt(position, length);
 	memory = {action, position};
 	return {scrap, length};
 }
@@ -595,6 +1130,8 @@ void UndoHistory::PushUndoActionType(int type, Sci::Position position) {
 	actions.PushBack();
 	actions.Create(actions.SSize() - 1, static_cast<ActionType>(type & byteMask),
 		position, 0, type & coalesceFlag);
+	actions.types[actions.SSize() - 1].compound = type & compoundFlag;
+	compoundLast = {};
 }
 
 void UndoHistory::ChangeLastUndoActionText(size_t length, const char *text) {
@@ -603,6 +1140,166 @@ void UndoHistory::ChangeLastUndoActionText(size_t length, const char *text) {
 	scraps->Push(text, length);
 }
 
+void UndoHistory::SetSpillThreshold(size_t bytes) noexcept {
+	scraps->SetSpillThreshold(bytes);
+}
+
+size_t UndoHistory::SpillThreshold() const noexcept {
+	return scraps->SpillThreshold();
+}
+
+void UndoHistory::SetMemoryLimit(size_t bytes) noexcept {
+	memoryLimit = bytes;
+}
+
+size_t UndoHistory::MemoryLimit() const noexcept {
+	return memoryLimit;
+}
+
+void UndoHistory::SetActionLimit(int count) noexcept {
+	actionLimit = std::max(count, 0);
+}
+
+int UndoHistory::ActionLimit() const noexcept {
+	return actionLimit;
+}
+
+size_t UndoHistory::MemoryUsage() const noexcept {
+	return actions.SizeInBytes() + scraps->Usage();
+}
+
+size_t UndoHistory::TrimOldest() {
+	const bool overActions = actionLimit && actions.SSize() > actionLimit;
+	const size_t usage = (memoryLimit || overActions) ? MemoryUsage() : 0;
+	const bool overMemory = memoryLimit && usage > memoryLimit;
+	if (!overActions && !overMemory) {
+		return 0;
+	}
+
+	// Trim to three quarters of the limits so that trimming happens in batches.
+	// Only whole undo steps before the current action and tentative point are dropped.
+	const int minDrop = overActions ? static_cast<int>(actions.SSize()) - (actionLimit - actionLimit / 4) : 0;
+	const size_t minText = overMemory ? scraps->LengthToRelease(usage - (memoryLimit - memoryLimit / 4)) : 0;
+	const int maxDrop = (tentativePoint >= 0) ? std::min(currentAction, tentativePoint) : currentAction;
+	int drop = 0;
+	size_t lengthDrop = 0;
+	size_t length = 0;
+	for (int act = 0; act < maxDrop; act++) {
+		length += actions.Length(act);
+		if (!actions.types[act].mayCoalesce) {
+			drop = act + 1;
+			lengthDrop = length;
+			if (drop >= minDrop && lengthDrop >= minText) {
+				break;
+			}
+		}
+	}
+	if (drop == 0) {
+		return 0;
+	}
+
+	size_t deletions = 0;
+	size_t position = 0;
+	for (int act = 0; act < drop; act++) {
+		const size_t lengthAct = actions.Length(act);
+		if (actions.types[act].at == ActionType::remove) {
+			if (actions.types[act].compound) {
+				CompoundReader reader(actions.Position(act), std::string_view(scraps->TextAt(position, lengthAct), lengthAct));
+				CompoundRange range{};
+				while (reader.Next(range)) {
+					deletions++;
+				}
+			} else {
+				deletions++;
+			}
+		}
+		position += lengthAct;
+	}
+
+	actions.DropFront(drop);
+	scraps->Discard(lengthDrop);
+	currentAction -= drop;
+	if (savePoint >= drop) {
+		savePoint -= drop;
+	} else if (savePoint >= 0) {
+		// Saved state is no longer reachable so treat it like a save point on an abandoned redo branch
+		savePoint = -1;
+		detach = 0;
+	} else if (detach) {
+		detach = std::max(*detach - drop, 0);
+	}
+	if (tentativePoint >= 0) {
+		tentativePoint -= drop;
+	}
+	memory = {};
+	if (compoundLast) {
+		compoundLast->act -= drop;
+	}
+	return deletions;
+}
+
+void UndoHistory::Save(HistoryWriter &writer) const {
+	const int count = Actions();
+	writer.Unsigned(count);
+	for (int act = 0; act < count; act++) {
+		writer.Unsigned(Type(act));
+		writer.Unsigned(actions.Position(act));
+		writer.Unsigned(actions.Length(act));
+	}
+	writer.Unsigned(currentAction);
+	writer.Signed(savePoint);
+	writer.Signed(DetachPoint());
+	writer.Signed(tentativePoint);
+	scraps->Save(writer);
+}
+
+void UndoHistory::Load(HistoryReader &reader, intptr_t lengthDocument) {
+	// Parse into a separate history so damaged data does not destroy this one
+	UndoHistory loaded;
+	const int count = static_cast<int>(reader.Unsigned(INT_MAX));
+	size_t lengthScraps = 0;
+	for (int act = 0; act < count; act++) {
+		const int type = static_cast<int>(reader.Unsigned(byteMask | coalesceFlag | compoundFlag));
+		if ((type & byteMask) > static_cast<int>(ActionType::container)) {
+			HistoryReader::Fail();
+		}
+		const Sci::Position position = reader.Unsigned(PTRDIFF_MAX);
+		const Sci::Position length = reader.Unsigned(PTRDIFF_MAX);
+		if ((type & byteMask) == static_cast<int>(ActionType::container) && (length || (type & compoundFlag))) {
+			// Container actions have no text
+			HistoryReader::Fail();
+		}
+		loaded.actions.PushBack();
+		loaded.actions.Create(act, static_cast<ActionType>(type & byteMask), position, length, type & coalesceFlag);
+		loaded.actions.types[act].compound = type & compoundFlag;
+		lengthScraps += length;
+	}
+	const int current = static_cast<int>(reader.Unsigned(count));
+	loaded.savePoint = static_cast<int>(reader.Signed(-1, count));
+	loaded.SetDetachPoint(static_cast<int>(reader.Signed(-1, count)));
+	loaded.tentativePoint = static_cast<int>(reader.Signed(-1, count));
+	loaded.scraps->Load(reader);
+	if (loaded.scraps->Length() < lengthScraps) {
+		HistoryReader::Fail();
+	}
+	loaded.SetCurrent(current, lengthDocument);
+	Swap(loaded);
+}
+
+void UndoHistory::Swap(UndoHistory &other) noexcept {
+	std::swap(actions, other.actions);
+	std::swap(currentAction, other.currentAction);
+	std::swap(savePoint, other.savePoint);
+	std::swap(tentativePoint, other.tentativePoint);
+	std::swap(detach, other.detach);
+	std::swap(memory, other.memory);
+	std::swap(compoundLast, other.compoundLast);
+	// Keep the spill threshold set on this history
+	const size_t spillThreshold = scraps->SpillThreshold();
+	scraps.swap(other.scraps);
+	scraps->SetSpillThreshold(spillThreshold);
+}
+
 void UndoHistory::SetTentative(int action) noexcept {
 	tentativePoint = action;
 }
@@ -651,17 +1348,18 @@ int UndoHistory::StartUndo() const noexcept {
 	return currentAction - act;
 }
 
-Action UndoHistory::GetUndoStep() const noexcept {
+Action UndoHistory::GetUndoStep() const {
 	const int previousAction = PreviousAction();
 	Action acta {
 		actions.types[previousAction].at,
 		actions.types[previousAction].mayCoalesce,
 		actions.Position(previousAction),
 		nullptr,
-		actions.Length(previousAction)
+		actions.Length(previousAction),
+		actions.types[previousAction].compound
 	};
 	if (acta.lenData) {
-		acta.data = scraps->CurrentText() - acta.lenData;
+		acta.data = scraps->TextAt(scraps->Current() - acta.lenData, acta.lenData);
 	}
 	return acta;
 }
@@ -669,6 +1367,7 @@ Action UndoHistory::GetUndoStep() const noexcept {
 void UndoHistory::CompletedUndoStep() noexcept {
 	scraps->MoveBack(actions.Length(PreviousAction()));
 	currentAction--;
+	compoundLast = {};
 }
 
 bool UndoHistory::CanRedo() const noexcept {
@@ -695,16 +1394,17 @@ int UndoHistory::StartRedo() const noexcept {
 	return act - currentAction + 1;
 }
 
-Action UndoHistory::GetRedoStep() const noexcept {
+Action UndoHistory::GetRedoStep() const {
 	Action acta{
 		actions.types[currentAction].at,
 		actions.types[currentAction].mayCoalesce,
 		actions.Position(currentAction),
 		nullptr,
-		actions.Length(currentAction)
+		actions.Length(currentAction),
+		actions.types[currentAction].compound
 	};
 	if (acta.lenData) {
-		acta.data = scraps->CurrentText();
+		acta.data = scraps->TextAt(scraps->Current(), acta.lenData);
 	}
 	return acta;
 }
@@ -712,6 +1412,7 @@ Action UndoHistory::GetRedoStep() const noexcept {
 void UndoHistory::CompletedRedoStep() noexcept {
 	scraps->MoveForward(actions.Length(currentAction));
 	currentAction++;
+	compoundLast = {};
 }
 
 }
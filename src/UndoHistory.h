@@ -31,6 +31,7 @@ public:
 	void ClearValueAt(size_t index) noexcept;
 	void Clear() noexcept;
 	void Truncate(size_t length) noexcept;
+	void DropFront(size_t length) noexcept;
 	void ReSize(size_t length);
 	void PushBack();
 
@@ -42,6 +43,7 @@ class UndoActionType {
 public:
 	ActionType at = ActionType::insert;
 	bool mayCoalesce = false;
+	bool compound = false;
 };
 
 struct UndoActions {
@@ -51,9 +53,11 @@ struct UndoActions {
 
 	UndoActions() noexcept;
 	void Truncate(size_t length) noexcept;
+	void DropFront(size_t length) noexcept;
 	void PushBack();
 	void Clear() noexcept;
 	[[nodiscard]] intptr_t SSize() const noexcept;
+	[[nodiscard]] size_t SizeInBytes() const noexcept;
 	void Create(size_t index, ActionType at_, Sci::Position position_, Sci::Position lenData_, bool mayCoalesce_);
 	[[nodiscard]] bool AtStart(size_t index) const noexcept;
 	[[nodiscard]] size_t LengthTo(size_t index) const noexcept;
@@ -61,20 +65,108 @@ struct UndoActions {
 	[[nodiscard]] Sci::Position Length(int action) const noexcept;
 };
 
+// Older scrap text is kept in LZ compressed blocks of scrapBlockSize bytes and only the most
+// recent one or two blocks stay uncompressed in stack. Once the compressed blocks held in memory
+// exceed spillThreshold bytes, the oldest are written to a temporary file.
+// Text from compressed blocks is expanded into window when it is read.
+// Text of trimmed actions is discarded from the front: positions taken by public methods start
+// after the discarded text and blocks entirely within it are released.
+
+constexpr size_t scrapBlockSize = 64*1024;
+
+struct ScrapBlock {
+	std::string compressed;	// empty when spilled
+	size_t length = 0;		// of compressed data
+	int64_t offset = -1;	// in spill file
+};
+
 class ScrapStack {
+	std::vector<ScrapBlock> blocks;
 	std::string stack;
+	size_t base = 0;		// position of stack[0], whole blocks before it are compressed
+	size_t discarded = 0;	// length of text at start of blocks or stack no longer used
 	size_t current = 0;
+	std::string window;
+	size_t windowStart = 0;
+	size_t windowEnd = 0;
+	size_t compressedInMemory = 0;
+	size_t spillThreshold = 0;
+	size_t spilledBlocks = 0;
+	FILE *spill = nullptr;
+	bool spillFailed = false;
+
+	void Truncate(size_t position);
+	void Compact();
+	void Spill() noexcept;
+	void CompactSpill() noexcept;
+	[[nodiscard]] size_t SpilledLength() const noexcept;
+	void ExpandBlock(size_t block, std::string &text);
 public:
+	ScrapStack() noexcept = default;
+	// Deleted so ScrapStack objects can not be copied.
+	ScrapStack(const ScrapStack &) = delete;
+	ScrapStack(ScrapStack &&) = delete;
+	ScrapStack &operator=(const ScrapStack &) = delete;
+	ScrapStack &operator=(ScrapStack &&) = delete;
+	~ScrapStack() noexcept;
+
 	void Clear() noexcept;
 	const char *Push(const char *text, size_t length);
 	void SetCurrent(size_t position) noexcept;
 	void MoveForward(size_t length) noexcept;
 	void MoveBack(size_t length) noexcept;
-	[[nodiscard]] const char *CurrentText() const noexcept;
-	[[nodiscard]] const char *TextAt(size_t position) const noexcept;
+	[[nodiscard]] size_t Current() const noexcept {
+		return current;
+	}
+	[[nodiscard]] size_t Length() const noexcept {
+		return base + stack.length() - discarded;
+	}
+	// The returned text remains valid until a different range is read or text is pushed.
+	[[nodiscard]] const char *TextAt(size_t position, size_t length);
+	void Discard(size_t length);
+	// Bytes used for text including blocks spilled to the temporary file
+	[[nodiscard]] size_t Usage() const noexcept;
+	// Length of text to discard to reduce usage by bytes
+	[[nodiscard]] size_t LengthToRelease(size_t bytes) const noexcept;
+	void SetSpillThreshold(size_t bytes) noexcept;
+	[[nodiscard]] size_t SpillThreshold() const noexcept {
+		return spillThreshold;
+	}
+	void Save(HistoryWriter &writer) const;
+	void Load(HistoryReader &reader);
+	// For testing
+	[[nodiscard]] size_t CompressedInMemory() const noexcept {
+		return compressedInMemory;
+	}
 };
 
 constexpr int coalesceFlag = 0x100;
+constexpr int compoundFlag = 0x200;
+
+// A compound action holds the insertions or deletions made at each of multiple selections
+// inside one undo group as a single action. Its text is a sequence of ranges, each being
+// the zigzag varint distance from the previous range position (the first range is at the
+// action position), the varint length of the range text, then the range text.
+
+struct CompoundRange {
+	Sci::Position position;
+	std::string_view text;
+};
+
+class CompoundReader {
+	std::string_view data;
+	Sci::Position position;
+public:
+	CompoundReader(Sci::Position position_, std::string_view data_) noexcept :
+		data{data_}, position{position_} {}
+	[[nodiscard]] bool AtEnd() const noexcept {
+		return data.empty();
+	}
+	// Fails at the end or when the text is malformed.
+	bool Next(CompoundRange &range) noexcept;
+};
+
+void DecodeCompound(const Action &action, std::vector<Action> &ranges);
 
 /**
  *
@@ -83,14 +175,19 @@ class UndoHistory final {
 	UndoActions actions;
 	int currentAction = 0;
 	int undoSequenceDepth = 0;
+	int mergeDepth = 0;	// depth of the group typing at several selections, merged into compound actions
 	int savePoint = 0;
 	int tentativePoint = -1;
 	std::optional<int> detach;	// Never set if savePoint set (>= 0)
-	const std::unique_ptr<ScrapStack> scraps;
+	std::unique_ptr<ScrapStack> scraps;
 	struct actPos { int act; size_t position; };
 	std::optional<actPos> memory;
+	std::optional<actPos> compoundLast;	// position of last range of compound action
+	size_t memoryLimit = 0;
+	int actionLimit = 0;
 
 	int PreviousAction() const noexcept;
+	const char *AppendCompound(Sci::Position position, const char *data, Sci::Position lengthData);
 
 public:
 	UndoHistory();
@@ -98,7 +195,7 @@ public:
 
 	const char *AppendAction(ActionType at, Sci::Position position, const char *data, Sci::Position lengthData, bool &startSequence, bool mayCoalesce = true);
 
-	void BeginUndoAction(bool mayCoalesce = false) noexcept;
+	void BeginUndoAction(bool mayCoalesce = false, bool multipleSelection = false) noexcept;
 	void EndUndoAction() noexcept;
 	int UndoSequenceDepth() const noexcept;
 	bool AfterUndoSequenceStart() const noexcept;
@@ -124,16 +221,35 @@ public:
 	bool AfterDetachPoint() const noexcept;
 	bool AfterOrAtDetachPoint() const noexcept;
 
-	[[nodiscard]] intptr_t Delta(int action) const noexcept;
-	[[nodiscard]] bool Validate(intptr_t lengthDocument) const noexcept;
+	// Methods reading undo text throw when compressed or spilled text can not be read back
+	[[nodiscard]] intptr_t Delta(int action) const;
+	[[nodiscard]] bool Validate(intptr_t lengthDocument) const;
 	void SetCurrent(int action, intptr_t lengthDocument);
 	[[nodiscard]] int Current() const noexcept;
 	[[nodiscard]] int Type(int action) const noexcept;
 	[[nodiscard]] Sci::Position Position(int action) const noexcept;
 	[[nodiscard]] Sci::Position Length(int action) const noexcept;
-	[[nodiscard]] std::string_view Text(int action) noexcept;
+	[[nodiscard]] std::string_view Text(int action);
 	void PushUndoActionType(int type, Sci::Position position);
 	void ChangeLastUndoActionText(size_t length, const char *text);
+	void SetSpillThreshold(size_t bytes) noexcept;
+	[[nodiscard]] size_t SpillThreshold() const noexcept;
+
+	// Limits of 0 are unbounded. Once a limit is exceeded, TrimOldest drops the oldest
+	// undo steps and returns the number of deletions in the dropped actions.
+	void SetMemoryLimit(size_t bytes) noexcept;
+	[[nodiscard]] size_t MemoryLimit() const noexcept;
+	void SetActionLimit(int count) noexcept;
+	[[nodiscard]] int ActionLimit() const noexcept;
+	[[nodiscard]] size_t MemoryUsage() const noexcept;
+	size_t TrimOldest();
+
+	// Saving writes all actions with their text and points so Load can restore them directly
+	void Save(HistoryWriter &writer) const;
+	// Load leaves the current history unchanged when it throws
+	void Load(HistoryReader &reader, intptr_t lengthDocument);
+	// Exchanges actions, text and points while limits and group depth stay with each history
+	void Swap(UndoHistory &other) noexcept;
 
 	// Tentative actions are used for input composition so that it can be undone cleanly
 	void SetTentative(int action) noexcept;
@@ -147,11 +263,11 @@ public:
 	/// called that many times. Similarly for redo.
 	bool CanUndo() const noexcept;
 	int StartUndo() const noexcept;
-	Action GetUndoStep() const noexcept;
+	Action GetUndoStep() const;
 	void CompletedUndoStep() noexcept;
 	bool CanRedo() const noexcept;
 	int StartRedo() const noexcept;
-	Action GetRedoStep() const noexcept;
+	Action GetRedoStep() const;
 	void CompletedRedoStep() noexcept;
 };
 
@@ -0,0 +1,207 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <cassert>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <map>
+#include <optional>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <chrono>
+
+#include "../src/ParallelSupport.h"
+#include "../include/ScintillaTypes.h"
+#include "../include/ScintillaMessages.h"
+#include "../include/ScintillaStructures.h"
+#include "../include/ILoader.h"
+#include "../include/ILexer.h"
+#include "../src/Debugging.h"
+#include "../src/Geometry.h"
+#include "../src/Platform.h"
+#include "../src/Position.h"
+#include "../src/UniqueString.h"
+#include "../src/SplitVector.h"
+#include "../src/Partitioning.h"
+#include "../src/RunStyles.h"
+#include "../src/ContractionState.h"
+#include "../src/CellBuffer.h"
+#include "../src/PerLine.h"
+#include "../src/KeyMap.h"
+#include "../src/Indicator.h"
+#include "../src/LineMarker.h"
+#include "../src/Style.h"
+#include "../src/ViewStyle.h"
+#include "../src/CharClassify.h"
+#include "../src/Decoration.h"
+#include "../src/CaseFolder.h"
+#include "../src/Document.h"
+#include "../src/UniConversion.h"
+#include "../src/SurfaceHeadless.h"
+#include "../src/Selection.h"
+#include "../src/PositionCache.h"
+#include "../src/EditModel.h"
+#include "../src/MarginView.h"
+#include "../src/EditView.h"
+
+// Lays out and paints a document through EditView with SurfaceHeadless,
+// checking character positions and pixels against the headless font metrics.
+// Runs on any platform, test/shim supplies the Win32 functions used by src outside Windows.
+// cl /utf-8 /EHsc /std:c++20 /W4 /I../include /I../src /I../lexlib EditViewHeadlessTest.cpp ../src/EditView.cxx ../src/EditModel.cxx ../src/ViewStyle.cxx ../src/PositionCache.cxx ../src/MarginView.cxx ../src/LineMarker.cxx ../src/Style.cxx ../src/Indicator.cxx ../src/XPM.cxx ../src/Selection.cxx ../src/ContractionState.cxx ../src/Geometry.cxx ../src/UniqueString.cxx ../src/SurfaceHeadless.cxx ../src/Document.cxx ../src/CellBuffer.cxx ../src/ChangeHistory.cxx ../src/UndoHistory.cxx ../src/RunStyles.cxx ../src/PerLine.cxx ../src/Decoration.cxx ../src/CharClassify.cxx ../src/CaseFolder.cxx ../src/CaseConvert.cxx ../src/UniConversion.cxx ../src/RESearch.cxx ../src/FrameTrace.cxx
+// g++ -std=gnu++20 -Wall -Wextra -Ishim -I../include -I../src -I../lexlib EditViewHeadlessTest.cpp ../src/EditView.cxx ../src/EditModel.cxx ../src/ViewStyle.cxx ../src/PositionCache.cxx ../src/MarginView.cxx ../src/LineMarker.cxx ../src/Style.cxx ../src/Indicator.cxx ../src/XPM.cxx ../src/Selection.cxx ../src/ContractionState.cxx ../src/Geometry.cxx ../src/UniqueString.cxx ../src/SurfaceHeadless.cxx ../src/Document.cxx ../src/CellBuffer.cxx ../src/ChangeHistory.cxx ../src/UndoHistory.cxx ../src/RunStyles.cxx ../src/PerLine.cxx ../src/Decoration.cxx ../src/CharClassify.cxx ../src/CaseFolder.cxx ../src/CaseConvert.cxx ../src/UniConversion.cxx ../src/RESearch.cxx ../src/FrameTrace.cxx
+
+using namespace Scintilla;
+using namespace Scintilla::Internal;
+
+// platform and ScintillaBase functions used by Document and EditView
+namespace Scintilla::Internal {
+
+int64_t QueryPerformanceFrequency() noexcept {
+	return std::chrono::steady_clock::period::den / std::chrono::steady_clock::period::num;
+}
+
+int64_t QueryPerformanceCounter() noexcept {
+	return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+void Document::HighlightUrl(Sci_PositionU /*startPos*/, Sci_Position /*length*/, const uint32_t (&/*urlIgnoreStyle*/)[8]) {
+}
+
+std::shared_ptr<Font> Font::Allocate(const FontParameters &fp) {
+	return FontHeadless_Allocate(fp);
+}
+
+std::unique_ptr<Surface> Surface::Allocate([[maybe_unused]] Technology technology) {
+	return SurfaceHeadless_Allocate();
+}
+
+ColourRGBA Platform::Chrome() noexcept {
+	return ColourRGBA(0xf0, 0xf0, 0xf0);
+}
+
+ColourRGBA Platform::ChromeHighlight() noexcept {
+	return ColourRGBA(0xff, 0xff, 0xff);
+}
+
+const char *Platform::DefaultFont() noexcept {
+	return "Consolas";
+}
+
+int Platform::DefaultFontSize() noexcept {
+	return 10;
+}
+
+}
+
+namespace {
+
+int failures = 0;
+
+void Check(bool condition, const char *what) {
+	if (!condition) {
+		printf("failed: %s\n", what);
+		failures++;
+	}
+}
+
+class HeadlessModel final : public EditModel {
+public:
+	Sci::Line TopLineOfMain() const noexcept override {
+		return 0;
+	}
+	Point GetVisibleOriginInMain() const noexcept override {
+		return Point();
+	}
+	Sci::Line LinesOnScreen() const noexcept override {
+		return 10;
+	}
+	void OnLineWrapped([[maybe_unused]] Sci::Line lineDoc, [[maybe_unused]] int linesWrapped, [[maybe_unused]] int option) override {
+	}
+	bool PaintIntersects([[maybe_unused]] PRectangle rc) const noexcept override {
+		return true;
+	}
+};
+
+// FontHeadless for the default 10 points: 13 pixels high with cells 7 pixels wide.
+constexpr int cellWidth = 7;
+constexpr int lineHeight = 13;
+constexpr int ascent = 10;
+constexpr int clientWidth = 200;
+constexpr int clientHeight = 4*lineHeight;
+constexpr int tabInChars = 4;
+
+// a, tab, U+4E2D wide character, b
+constexpr std::string_view text = "ab c\n\t\xE4\xB8\xAD" "b\n";
+
+void TestLayoutAndPaint() {
+	HeadlessModel model;
+	model.pdoc->SetDBCSCodePage(CpUtf8);
+	model.pdoc->InsertString(0, text.data(), text.length());
+	model.pcs->InsertLines(0, model.pdoc->LinesTotal() - 1);
+	model.reprs->SetDefaultRepresentations(model.pdoc->dbcsCodePage);
+
+	const std::unique_ptr<Surface> surface = SurfaceHeadless_Allocate(clientWidth, clientHeight, model.CurrentSurfaceMode());
+	ViewStyle vs;
+	vs.Refresh(*surface, tabInChars);
+	Check(vs.lineHeight == lineHeight && vs.aveCharWidth == cellWidth, "ViewStyle metrics");
+	// no margins so text starts at left
+	for (MarginStyle &margin : vs.ms) {
+		margin.width = 0;
+	}
+	vs.leftMarginWidth = 0;
+	vs.Refresh(*surface, tabInChars);
+
+	EditView view;
+	LineLayout *ll = view.RetrieveLineLayout(0, model);
+	view.LayoutLine(model, surface.get(), vs, ll, clientWidth, LayoutLineOption::ManualUpdate);
+	Check(ll->numCharsInLine == 4, "line 0 length");
+	for (int i = 0; i <= ll->numCharsInLine; i++) {
+		Check(ll->positions[i] == i*cellWidth, "line 0 positions");
+	}
+
+	ll = view.RetrieveLineLayout(1, model);
+	view.LayoutLine(model, surface.get(), vs, ll, clientWidth, LayoutLineOption::ManualUpdate);
+	Check(ll->numCharsInLine == 5, "line 1 length");
+	// tab stop, then each byte of the wide character ends after two cells
+	constexpr XYPOSITION expected[] = { 0, 4*cellWidth, 6*cellWidth, 6*cellWidth, 6*cellWidth, 7*cellWidth };
+	for (int i = 0; i <= ll->numCharsInLine; i++) {
+		Check(ll->positions[i] == expected[i], "line 1 positions");
+	}
+
+	// buffered drawing paints each line into a pixmap then copies it, as Editor::Paint does
+	view.RefreshPixMaps(surface.get(), vs);
+	view.pixmapLine = surface->AllocatePixMap(clientWidth, vs.lineHeight);
+	const PRectangle rcClient(0, 0, clientWidth, clientHeight);
+	view.PaintText(surface.get(), model, vs, rcClient, rcClient);
+	const SurfaceHeadless *headless = down_cast<const SurfaceHeadless *>(surface.get());
+	const ColourRGBA fore = vs.styles[StyleDefault].fore;
+	const ColourRGBA back = vs.styles[StyleDefault].back;
+	// glyphs are solid blocks from the ascent to the baseline with a gap on their right
+	Check(headless->PixelAt(0, 0) == fore && headless->PixelAt(cellWidth - 1, 0) == back, "paint a");
+	Check(headless->PixelAt(cellWidth, ascent - 1) == fore, "paint b");
+	Check(headless->PixelAt(2*cellWidth + 2, 5) == back, "paint space");
+	Check(headless->PixelAt(0, ascent + 1) == back, "paint below baseline");
+	Check(headless->PixelAt(2*cellWidth, lineHeight + 5) == back, "paint tab");
+	Check(headless->PixelAt(4*cellWidth, lineHeight + 5) == fore && headless->PixelAt(6*cellWidth - 2, lineHeight + 5) == fore, "paint wide");
+	Check(headless->PixelAt(6*cellWidth - 1, lineHeight + 5) == back, "paint wide gap");
+	Check(headless->PixelAt(6*cellWidth, lineHeight + 5) == fore, "paint after wide");
+	Check(headless->PixelAt(clientWidth - 1, 3*lineHeight + 1) == back, "paint after last line");
+}
+
+}
+
+int main() {
+	TestLayoutAndPaint();
+	printf("%s\n", failures ? "FAILED" : "OK");
+	return failures != 0;
+}
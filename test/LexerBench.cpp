@@ -0,0 +1,295 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+#define _CRT_SECURE_NO_WARNINGS
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+#include <cstdio>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <memory>
+#include <chrono>
+
+#include "../include/ScintillaTypes.h"
+#include "../include/ILoader.h"
+#include "../include/ILexer.h"
+#include "../include/Scintilla.h"
+#include "../include/SciLexer.h"
+#include "../src/Debugging.h"
+#include "../src/Position.h"
+#include "../src/SplitVector.h"
+#include "../src/Partitioning.h"
+#include "../src/RunStyles.h"
+#include "../src/CellBuffer.h"
+#include "../src/PerLine.h"
+#include "../src/CharClassify.h"
+#include "../src/Decoration.h"
+#include "../src/CaseFolder.h"
+#include "../src/Document.h"
+#include "../src/ElapsedPeriod.h"
+#include "../lexlib/PropSetSimple.h"
+#include "../lexlib/WordList.h"
+#include "../lexlib/LexAccessor.h"
+#include "../lexlib/Accessor.h"
+#include "../lexlib/LexerModule.h"
+#include "TestUtils.h"
+
+// Lexes and folds a generated corpus and pathological inputs with every lexer in the catalogue
+// through a headless Document, prints MB/s and a hash of styles, line states and fold levels.
+// LexerBench               compare hashes with LexerBenchGolden.txt
+// LexerBench update        rewrite LexerBenchGolden.txt
+// LexerBench old.txt       also flag lexers at least 20% slower than output saved in old.txt
+// cl /utf-8 /EHsc /std:c++20 /DNDEBUG /O2 /GS- /GR- /W4 /arch:AVX2 /I../include /I../src /I../lexlib LexerBench.cpp ../src/Document.cxx ../src/CellBuffer.cxx ../src/ChangeHistory.cxx ../src/UndoHistory.cxx ../src/RunStyles.cxx ../src/PerLine.cxx ../src/Decoration.cxx ../src/CharClassify.cxx ../src/CaseFolder.cxx ../src/CaseConvert.cxx ../src/UniConversion.cxx ../src/RESearch.cxx ../src/FrameTrace.cxx ../lexlib/*.cxx ../lexers/*.cxx
+// g++ -std=gnu++20 -DNDEBUG -O2 -Wall -Wextra -Ishim -I../include -I../src -I../lexlib LexerBench.cpp ../src/Document.cxx ../src/CellBuffer.cxx ../src/ChangeHistory.cxx ../src/UndoHistory.cxx ../src/RunStyles.cxx ../src/PerLine.cxx ../src/Decoration.cxx ../src/CharClassify.cxx ../src/CaseFolder.cxx ../src/CaseConvert.cxx ../src/UniConversion.cxx ../src/RESearch.cxx ../src/FrameTrace.cxx ../lexlib/*.cxx ../lexers/*.cxx
+// or build and run with other tests from CMakeLists.txt in this directory
+
+using namespace Scintilla;
+using namespace Scintilla::Internal;
+using namespace Lexilla;
+
+// platform and ScintillaBase functions used by Document
+namespace Scintilla::Internal {
+
+int64_t QueryPerformanceFrequency() noexcept {
+	return std::chrono::steady_clock::period::den / std::chrono::steady_clock::period::num;
+}
+
+int64_t QueryPerformanceCounter() noexcept {
+	return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+void Document::HighlightUrl(Sci_PositionU /*startPos*/, Sci_Position /*length*/, const uint32_t (&/*urlIgnoreStyle*/)[8]) {
+}
+
+}
+
+namespace {
+
+constexpr const char *goldenPath = "LexerBenchGolden.txt";
+constexpr double slowdownThreshold = 0.8;
+// speed for times below timer resolution, e.g. folding with lexers without folder.
+constexpr double unmeasuredSpeed = 10000;
+
+class BenchLexer final : public LexInterface {
+public:
+	BenchLexer(Document *pdoc_, const LexerModule *module) : LexInterface(pdoc_) {
+		instance.reset(module->Create());
+		instance->PropertySet("fold", "1");
+		instance->PropertySet("fold.comment", "1");
+		lexerLanguage = module->GetLanguage();
+	}
+};
+
+struct TestInput {
+	const char *name;
+	std::string text;
+};
+
+// token soup shared by all languages, covering comments, strings, numbers,
+// brackets, markup and here documents in the syntax of most lexers.
+std::string GenerateCorpus(size_t length) {
+	constexpr const char *pieces[] = {
+		"if", "else", "for", "while", "return", "function", "def", "class", "end", "begin",
+		"let", "var", "int", "true", "null", "abc_12", "x", "Name", "$var", "@attr",
+		" ", " ", " ", "  ", "\t", "\n", "\n", "\n", "\r\n", "    ",
+		"0x1F", "42", "3.14e-2", "1_000", "0b101",
+		"\"str\"", "'c'", "`tpl ${x}`", "\"\"\"doc\"\"\"", "\"unterminated", "\\", "\\n",
+		"//", "/*", "*/", "#", "--", ";", "%", "(*", "*)", "<!--", "-->",
+		"(", ")", "{", "}", "[", "]", "<", ">", "=", "==", "+", "-", "*", "/", "&&", "|", ":", ",", ".",
+		"<tag a=\"v\">", "</tag>", "<<EOF\n", "\nEOF\n", "```\n", "* ", "# ", "=begin\n", "\n=end\n",
+		"\xE4\xB8\xAD", "\xC3\xA9",
+	};
+	PCG32Random random(UINT64_C(0x853c49e6748fea9b), UINT64_C(0xda3e39cb94b95bdb));
+	std::string text;
+	text.reserve(length + 16);
+	while (text.length() < length) {
+		text += pieces[random.Next() % std::size(pieces)];
+	}
+	return text;
+}
+
+std::vector<TestInput> GenerateInputs() {
+	std::vector<TestInput> inputs;
+	inputs.push_back({"corpus", GenerateCorpus(1024*1024)});
+
+	std::string text = GenerateCorpus(10*1024*1024);
+	std::replace(text.begin(), text.end(), '\n', ' ');
+	std::replace(text.begin(), text.end(), '\r', ' ');
+	inputs.push_back({"long line", std::move(text)});
+
+	constexpr size_t depth = 100*1000;
+	text.clear();
+	for (size_t i = 0; i < depth; i++) {
+		text += "f({[\n";
+	}
+	for (size_t i = 0; i < depth; i++) {
+		text += "]})\n";
+	}
+	inputs.push_back({"nesting", std::move(text)});
+
+	inputs.push_back({"angles", std::string(1024*1024, '<')});
+
+	text = GenerateCorpus(1024*1024);
+	inputs.push_back({"open string", '"' + text});
+	inputs.push_back({"open comment", "/*" + text});
+	return inputs;
+}
+
+uint64_t HashValue(uint64_t hash, uint64_t value) noexcept {
+	// FNV-1a
+	for (int i = 0; i < 8; i++) {
+		hash = (hash ^ (value & 0xff)) * UINT64_C(0x100000001b3);
+		value >>= 8;
+	}
+	return hash;
+}
+
+struct BenchResult {
+	double corpus = 0;
+	double fold = 0;
+	double worst = 0;
+	const char *worstName = "";
+	uint64_t hash = UINT64_C(0xcbf29ce484222325);
+};
+
+// MB/s for styling then folding text, best of repeat runs.
+BenchResult RunLexer(const LexerModule *module, const std::vector<TestInput> &inputs) {
+	BenchResult result;
+	for (const TestInput &input : inputs) {
+		Document *pdoc = new Document(DocumentOption::Default);
+		pdoc->AddRef();
+		pdoc->SetDBCSCodePage(SC_CP_UTF8);
+		pdoc->InsertString(0, input.text.data(), input.text.length());
+		pdoc->SetLexInterface(std::make_unique<BenchLexer>(pdoc, module));
+		const Sci::Position length = pdoc->LengthNoExcept();
+		const double size = static_cast<double>(length) / (1024*1024);
+		const int repeat = (&input == inputs.data()) ? 3 : 1;
+		double styleTime = 0;
+		double foldTime = 0;
+		for (int i = 0; i < repeat; i++) {
+			pdoc->ModifiedAt(0);
+			ElapsedPeriod period;
+			pdoc->EnsureStyledTo(length);
+			const double duration = period.Reset();
+			pdoc->EnsureFoldedTo(length);
+			const double foldDuration = period.Reset();
+			if (i == 0 || duration < styleTime) {
+				styleTime = duration;
+			}
+			if (i == 0 || foldDuration < foldTime) {
+				foldTime = foldDuration;
+			}
+		}
+
+		const double speed = size / std::max(styleTime + foldTime, 1e-9);
+		if (&input == inputs.data()) {
+			result.corpus = size / std::max(styleTime, 1e-9);
+			result.fold = size / std::max(foldTime, 1e-9);
+		} else if (result.worst == 0 || speed < result.worst) {
+			result.worst = speed;
+			result.worstName = input.name;
+		}
+
+		for (Sci::Position pos = 0; pos < length; pos++) {
+			result.hash = HashValue(result.hash, pdoc->StyleIndexAt(pos));
+		}
+		const Sci::Line lines = pdoc->LinesTotal();
+		for (Sci::Line line = 0; line < lines; line++) {
+			result.hash = HashValue(result.hash, static_cast<uint32_t>(pdoc->GetLineState(line)));
+			result.hash = HashValue(result.hash, static_cast<uint32_t>(pdoc->GetLevel(line)));
+		}
+		pdoc->Release();
+	}
+	return result;
+}
+
+struct SavedResult {
+	int language = 0;
+	double corpus = 0;
+	double fold = 0;
+	double worst = 0;
+	uint64_t hash = 0;
+};
+
+// reads lines printed by main() or written to the golden file, starting with language and lexer name.
+std::vector<SavedResult> ReadResults(const char *path, bool golden) {
+	std::vector<SavedResult> results;
+	FILE *fp = fopen(path, "r");
+	if (fp == nullptr) {
+		return results;
+	}
+	char line[256];
+	while (fgets(line, sizeof(line), fp)) {
+		SavedResult saved;
+		unsigned long long hash = 0;
+		const int count = golden ? sscanf(line, "%d %*s %llx", &saved.language, &hash)
+			: sscanf(line, "%d %*s %lf %lf %lf", &saved.language, &saved.corpus, &saved.fold, &saved.worst);
+		if (count == (golden ? 2 : 4)) {
+			saved.hash = hash;
+			results.push_back(std::move(saved));
+		}
+	}
+	fclose(fp);
+	return results;
+}
+
+constexpr bool IsSlower(double speed, double saved) noexcept {
+	return saved < unmeasuredSpeed && speed < saved*slowdownThreshold;
+}
+
+const SavedResult *FindResult(const std::vector<SavedResult> &results, int language) noexcept {
+	for (const SavedResult &saved : results) {
+		if (saved.language == language) {
+			return &saved;
+		}
+	}
+	return nullptr;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+	const bool update = argc > 1 && strcmp(argv[1], "update") == 0;
+	const std::vector<SavedResult> golden = ReadResults(goldenPath, true);
+	const std::vector<SavedResult> baseline = (argc > 1 && !update) ? ReadResults(argv[1], false) : std::vector<SavedResult>{};
+	const std::vector<TestInput> inputs = GenerateInputs();
+
+	FILE *fpGolden = update ? fopen(goldenPath, "w") : nullptr;
+	int failures = 0;
+	printf("%3s %-14s %8s %8s %8s %-12s %s\n", "id", "lexer", "MB/s", "fold", "worst", "case", "hash");
+	for (int language = SCLEX_NULL; language < SCLEX_AUTOMATIC; language++) {
+		const LexerModule *module = LexerModule::Find(language);
+		if (module->GetLanguage() != language) {
+			continue;
+		}
+		const char *name = module->languageName;
+		const BenchResult result = RunLexer(module, inputs);
+		printf("%3d %-14s %8.2f %8.2f %8.2f %-12s %016llx", language, name, result.corpus, result.fold, result.worst,
+			result.worstName, static_cast<unsigned long long>(result.hash));
+		if (fpGolden) {
+			fprintf(fpGolden, "%d %s %016llx\n", language, name, static_cast<unsigned long long>(result.hash));
+		} else if (const SavedResult *saved = FindResult(golden, language); saved && saved->hash != result.hash) {
+			printf(" styles changed");
+			failures++;
+		}
+		if (const SavedResult *saved = FindResult(baseline, language)) {
+			if (IsSlower(result.corpus, saved->corpus) || IsSlower(result.fold, saved->fold) || IsSlower(result.worst, saved->worst)) {
+				printf(" slower");
+				failures++;
+			}
+		}
+		printf("\n");
+		fflush(stdout);
+	}
+	if (fpGolden) {
+		fclose(fpGolden);
+	}
+	return failures != 0;
+}
@@ -0,0 +1,256 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+#define _CRT_SECURE_NO_WARNINGS
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+#include <cstdio>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <memory>
+#include <chrono>
+
+#include "../include/ScintillaTypes.h"
+#include "../include/ILoader.h"
+#include "../include/ILexer.h"
+#include "../include/Scintilla.h"
+#include "../include/SciLexer.h"
+#include "../src/Debugging.h"
+#include "../src/Position.h"
+#include "../src/SplitVector.h"
+#include "../src/Partitioning.h"
+#include "../src/RunStyles.h"
+#include "../src/CellBuffer.h"
+#include "../src/PerLine.h"
+#include "../src/CharClassify.h"
+#include "../src/Decoration.h"
+#include "../src/CaseFolder.h"
+#include "../src/Document.h"
+#include "../src/ElapsedPeriod.h"
+#include "../lexlib/PropSetSimple.h"
+#include "../lexlib/WordList.h"
+#include "../lexlib/LexAccessor.h"
+#include "../lexlib/Accessor.h"
+#include "../lexlib/LexerModule.h"
+#include "../lexlib/LexerCheckpoints.h"
+#include "TestUtils.h"
+
+// Lexers declaring Scintilla::lvLineResume stop restyling after an edit where line state and style
+// match their old values. For these lexers, styles a document, edits it at random positions and
+// checks that styles and line states after restyling match lexing the edited text afresh.
+// Other lexers restyle to the end, which is checked for a regular expression whose style depends
+// on text before unchanged lines.
+// Lexers saving checkpoints inside long constructs are edited deep inside such constructs, where
+// styling resumes from a checkpoint instead of the start of the construct.
+// LexerResumeTest          test all lexers
+// LexerResumeTest js       test the lexer with the given name
+// cl /utf-8 /EHsc /std:c++20 /W4 /I../include /I../src /I../lexlib LexerResumeTest.cpp ../src/Document.cxx ../src/CellBuffer.cxx ../src/ChangeHistory.cxx ../src/UndoHistory.cxx ../src/RunStyles.cxx ../src/PerLine.cxx ../src/Decoration.cxx ../src/CharClassify.cxx ../src/CaseFolder.cxx ../src/CaseConvert.cxx ../src/UniConversion.cxx ../src/RESearch.cxx ../src/FrameTrace.cxx ../lexlib/*.cxx ../lexers/*.cxx
+// g++ -std=gnu++20 -Wall -Wextra -Ishim -I../include -I../src -I../lexlib LexerResumeTest.cpp ../src/Document.cxx ../src/CellBuffer.cxx ../src/ChangeHistory.cxx ../src/UndoHistory.cxx ../src/RunStyles.cxx ../src/PerLine.cxx ../src/Decoration.cxx ../src/CharClassify.cxx ../src/CaseFolder.cxx ../src/CaseConvert.cxx ../src/UniConversion.cxx ../src/RESearch.cxx ../src/FrameTrace.cxx ../lexlib/*.cxx ../lexers/*.cxx
+// or build and run with other tests from CMakeLists.txt in this directory
+
+using namespace Scintilla;
+using namespace Scintilla::Internal;
+using namespace Lexilla;
+
+// platform and ScintillaBase functions used by Document
+namespace Scintilla::Internal {
+
+int64_t QueryPerformanceFrequency() noexcept {
+	return std::chrono::steady_clock::period::den / std::chrono::steady_clock::period::num;
+}
+
+int64_t QueryPerformanceCounter() noexcept {
+	return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+void Document::HighlightUrl(Sci_PositionU /*startPos*/, Sci_Position /*length*/, const uint32_t (&/*urlIgnoreStyle*/)[8]) {
+}
+
+}
+
+namespace {
+
+constexpr int editCount = 40;
+
+class TestLexer final : public LexInterface {
+public:
+	TestLexer(Document *pdoc_, const LexerModule *module) : LexInterface(pdoc_) {
+		instance.reset(module->Create());
+		lexerLanguage = module->GetLanguage();
+	}
+};
+
+constexpr const char *pieces[] = {
+	"if", "else", "for", "return", "function", "def", "class", "end", "begin",
+	"let", "var", "int", "true", "null", "abc_12", "x", "Name", "$var", "@attr",
+	" ", " ", "  ", "\t", "\n", "\n", "\n", "\r\n",
+	"0x1F", "42", "3.14e-2", "1_000",
+	"\"str\"", "'c'", "\"", "'", "`", "`tpl ${x}`", "\"\"\"doc\"\"\"", "\\", "\\n",
+	"//", "/*", "*/", "#", "--", ";", "%", "(*", "*)", "<!--", "-->", "/y/g",
+	"(", ")", "{", "}", "[", "]", "<", ">", "=", "+", "-", "*", "/", "&&", "|", ":", ",", ".",
+	"<tag a=\"v\">", "</tag>", "<<EOF\n", "\nEOF\n", "```\n", "* ", "# ", "=begin\n", "\n=end\n",
+	"\xE4\xB8\xAD", "\xC3\xA9",
+};
+
+// long constructs that can not be resumed from line state alone.
+struct Construct {
+	int language;
+	const char *head;
+	const char *line; // repeated inside the construct
+	const char *tail;
+};
+
+constexpr Construct constructs[] = {
+	{SCLEX_JAVASCRIPT, "let s = `${a + `\n", "text ${b} {\n", "`}`;\nlet t = /y/g;\n"},
+	{SCLEX_BASH, "cat <<EOF\n", "text $x ${y} `date`\n", "EOF\necho done\n"},
+	{SCLEX_BASH, "echo \"$(\n", "ls -l \"$x\" | wc\n", ")\"\necho done\n"},
+	{SCLEX_RUBY, "x = <<EOS\n", "text #{y} \"q\"\n", "EOS\nputs x\n"},
+	{SCLEX_RUBY, "x = %Q{\n", "text #{y + \"z\"} {b}\n", "}\nputs x\n"},
+	{SCLEX_PERL, "print <<EOF;\n", "text $x @y\n", "EOF\nprint 1;\n"},
+	{SCLEX_PERL, "my $s = qq{\n", "text $x {y}\n", "};\nprint $s;\n"},
+	{SCLEX_HTML, "<div\n", "a=\"v\" b='w'\n", ">text</div>\n"},
+	{SCLEX_XML, "<node\n", "a=\"v\"\n", "/>\n"},
+	{SCLEX_MARKDOWN, "<div\n", "a=\"v\"\n", ">\n\ntext\n"},
+	{SCLEX_MARKDOWN, "some *text* <span\n", "a=\"v\" b='w'\n", ">text</span>\n\n# header\n"},
+};
+
+std::string GenerateText(PCG32Random &random, size_t length) {
+	std::string text;
+	while (text.length() < length) {
+		text += pieces[random.Next() % std::size(pieces)];
+	}
+	return text;
+}
+
+Document *NewDocument(const LexerModule *module, const std::string &text) {
+	Document *pdoc = new Document(DocumentOption::Default);
+	pdoc->AddRef();
+	pdoc->SetDBCSCodePage(SC_CP_UTF8);
+	pdoc->InsertString(0, text.data(), text.length());
+	pdoc->SetLexInterface(std::make_unique<TestLexer>(pdoc, module));
+	pdoc->EnsureStyledTo(pdoc->LengthNoExcept());
+	return pdoc;
+}
+
+std::string Text(const Document *pdoc) {
+	std::string text(pdoc->LengthNoExcept(), '\0');
+	pdoc->GetCharRange(text.data(), 0, text.length());
+	return text;
+}
+
+// first position or line (after ':') where styles or line states differ from a fresh lex, or empty.
+std::string Compare(Document *pdoc, const LexerModule *module) {
+	Document *fresh = NewDocument(module, Text(pdoc));
+	std::string where;
+	const Sci::Position length = pdoc->LengthNoExcept();
+	for (Sci::Position pos = 0; pos < length; pos++) {
+		if (pdoc->StyleIndexAt(pos) != fresh->StyleIndexAt(pos)) {
+			where = "style at " + std::to_string(pos) + ": " + std::to_string(pdoc->StyleIndexAt(pos))
+				+ " instead of " + std::to_string(fresh->StyleIndexAt(pos));
+			break;
+		}
+	}
+	const Sci::Line lines = pdoc->LinesTotal();
+	for (Sci::Line line = 0; line < lines && where.empty(); line++) {
+		if (pdoc->GetLineState(line) != fresh->GetLineState(line)) {
+			where = "line state at line " + std::to_string(line);
+		}
+	}
+	fresh->Release();
+	return where;
+}
+
+// Inserts or deletes a piece at a random position and restyles the whole document.
+std::string EditAndCompare(const LexerModule *module, const std::string &text, PCG32Random &random) {
+	Document *pdoc = NewDocument(module, text);
+	std::string where;
+	for (int i = 0; i < editCount && where.empty(); i++) {
+		const Sci::Position length = pdoc->LengthNoExcept();
+		const Sci::Position position = pdoc->MovePositionOutsideChar(random.Next() % (length + 1), 1);
+		if (random.Next() % 3 == 0 && position < length) {
+			const Sci::Position end = pdoc->MovePositionOutsideChar(position + 1 + random.Next() % 8, 1);
+			pdoc->DeleteChars(position, std::min(end, length) - position);
+		} else {
+			const char *piece = pieces[random.Next() % std::size(pieces)];
+			pdoc->InsertString(position, piece, strlen(piece));
+		}
+		pdoc->EnsureStyledTo(pdoc->LengthNoExcept());
+		where = Compare(pdoc, module);
+	}
+	pdoc->Release();
+	return where;
+}
+
+// Inserts text at position after styling and restyles.
+std::string InsertAndCompare(const LexerModule *module, const std::string &text, Sci::Position position, const char *insertion) {
+	Document *pdoc = NewDocument(module, text);
+	pdoc->InsertString(position, insertion, strlen(insertion));
+	pdoc->EnsureStyledTo(pdoc->LengthNoExcept());
+	std::string where = Compare(pdoc, module);
+	pdoc->Release();
+	return where;
+}
+
+// Edits lines far from the start of a styled construct, then restyles.
+std::string EditInsideAndCompare(const LexerModule *module, const Construct &construct) {
+	std::string text = construct.head;
+	for (int line = 0; line < 4*LexerCheckpoints::Interval; line++) {
+		text += construct.line;
+	}
+	text += construct.tail;
+	Document *pdoc = NewDocument(module, text);
+	std::string where;
+	constexpr const char *insertions[] = {"x", "{", "}", "\n", "\"", "x"};
+	Sci::Line line = 3*LexerCheckpoints::Interval + 5;
+	for (const char *insertion : insertions) {
+		pdoc->InsertString(pdoc->LineStart(line) + 2, insertion, strlen(insertion));
+		pdoc->EnsureStyledTo(pdoc->LengthNoExcept());
+		where = Compare(pdoc, module);
+		if (!where.empty()) {
+			break;
+		}
+		line -= LexerCheckpoints::Interval/2;
+	}
+	pdoc->Release();
+	return where;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+	const char *only = (argc > 1) ? argv[1] : nullptr;
+	int failures = 0;
+	for (int language = SCLEX_NULL; language < SCLEX_AUTOMATIC; language++) {
+		const LexerModule *module = LexerModule::Find(language);
+		if (module->GetLanguage() != language || (only && strcmp(only, module->languageName) != 0)) {
+			continue;
+		}
+		// regular expression after lines whose style and line state are the same as before the edit,
+		// while whether it starts a regular expression depends on text before those lines.
+		std::string where = InsertAndCompare(module, "foo\n// c\n// c\n// c\n/y/g\n1\n", 3, "(");
+		if (module->lineResume) {
+			PCG32Random random(UINT64_C(0x853c49e6748fea9b) + language, UINT64_C(0xda3e39cb94b95bdb));
+			for (int round = 0; round < 8 && where.empty(); round++) {
+				where = EditAndCompare(module, GenerateText(random, 4*1024), random);
+			}
+		}
+		for (const Construct &construct : constructs) {
+			if (construct.language == language && where.empty()) {
+				where = EditInsideAndCompare(module, construct);
+			}
+		}
+		if (!where.empty()) {
+			printf("%3d %-14s %s\n", language, module->languageName, where.c_str());
+			failures++;
+		}
+	}
+	printf("%d lexers differ from a fresh lex after edits\n", failures);
+	return failures != 0;
+}
@@ -0,0 +1,100 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <memory>
+
+#include "../include/ScintillaTypes.h"
+#include "../src/Debugging.h"
+#include "../src/Geometry.h"
+#include "../src/Platform.h"
+#include "../src/SurfaceHeadless.h"
+
+// g++ -std=gnu++20 -O2 -Wall -Wextra -I../include -I../src SurfaceHeadlessTest.cpp ../src/SurfaceHeadless.cxx ../src/Geometry.cxx ../src/UniConversion.cxx ../src/CharClassify.cxx
+// clang++ -std=gnu++20 -O2 -Wall -Wextra -I../include -I../src SurfaceHeadlessTest.cpp ../src/SurfaceHeadless.cxx ../src/Geometry.cxx ../src/UniConversion.cxx ../src/CharClassify.cxx
+
+using namespace Scintilla;
+using namespace Scintilla::Internal;
+
+namespace {
+
+int failures = 0;
+
+void Check(bool condition, const char *what) {
+	if (!condition) {
+		printf("failed: %s\n", what);
+		failures++;
+	}
+}
+
+void TestMetrics() {
+	const FontParameters fp("Consolas", 12);
+	const std::shared_ptr<Font> font = FontHeadless_Allocate(fp);
+	const std::unique_ptr<Surface> surface = SurfaceHeadless_Allocate();
+	const FontMetrics metrics = surface->Metrics(font.get());
+	Check(metrics.height == 12 && metrics.ascent == 10 && metrics.descent == 2, "metrics");
+	Check(surface->DeviceHeightFont(9) == 12, "DeviceHeightFont");
+	Check(surface->WidthText(font.get(), "abc") == 18, "WidthText");
+	Check(surface->SupportsFeature(Supports::ThreadSafeMeasureWidths), "ThreadSafeMeasureWidths");
+}
+
+void TestMeasureWidths() {
+	const FontParameters fp("Consolas", 12);
+	const std::shared_ptr<Font> font = FontHeadless_Allocate(fp);
+	const std::unique_ptr<Surface> surface = SurfaceHeadless_Allocate(0, 0, SurfaceMode{CpUtf8});
+	// a, U+00E9, U+4E2D, truncated lead byte
+	constexpr std::string_view text = "a\xC3\xA9\xE4\xB8\xAD\xE4";
+	XYPOSITION positions[text.length()]{};
+	surface->MeasureWidths(font.get(), text, positions);
+	constexpr XYPOSITION expected[] = { 6, 12, 12, 24, 24, 24, 30 };
+	for (size_t i = 0; i < text.length(); i++) {
+		Check(positions[i] == expected[i], "MeasureWidths UTF-8");
+	}
+
+	surface->SetMode(SurfaceMode{932});
+	constexpr std::string_view dbcs = "a\x82\xA0z";
+	surface->MeasureWidths(font.get(), dbcs, positions);
+	Check(positions[0] == 6 && positions[1] == 18 && positions[2] == 18 && positions[3] == 24, "MeasureWidths DBCS");
+}
+
+void TestDrawing() {
+	const FontParameters fp("Consolas", 12);
+	const std::shared_ptr<Font> font = FontHeadless_Allocate(fp);
+	SurfaceHeadless surface(40, 20, SurfaceMode{});
+	constexpr ColourRGBA red(0xff, 0, 0);
+	constexpr ColourRGBA blue(0, 0, 0xff);
+	surface.FillRectangle(PRectangle(0, 0, 40, 20), Fill(blue));
+	Check(surface.PixelAt(39, 19) == blue, "FillRectangle");
+
+	surface.SetClip(PRectangle(0, 0, 10, 10));
+	surface.FillRectangle(PRectangle(0, 0, 40, 20), Fill(red));
+	surface.PopClip();
+	Check(surface.PixelAt(9, 9) == red && surface.PixelAt(10, 9) == blue, "SetClip");
+
+	surface.DrawTextNoClip(PRectangle(0, 0, 40, 12), font.get(), 10, "a b", black, white);
+	Check(surface.PixelAt(0, 0) == black && surface.PixelAt(5, 0) == white, "DrawTextNoClip glyph");
+	Check(surface.PixelAt(7, 5) == white && surface.PixelAt(12, 5) == black, "DrawTextNoClip space");
+	Check(surface.PixelAt(0, 10) == white && surface.PixelAt(0, 12) == blue, "DrawTextNoClip background");
+
+	surface.FillRectangle(PRectangle(0, 0, 40, 20), Fill(ColourRGBA(0xff, 0xff, 0xff, 0x80)));
+	Check(surface.PixelAt(0, 12) == ColourRGBA(0x7f, 0x7f, 0xfe), "alpha blend");
+
+	SurfaceHeadless other(40, 20, SurfaceMode{});
+	other.Copy(PRectangle(0, 0, 40, 20), Point(), surface);
+	Check(other.PixelAt(0, 0) == surface.PixelAt(0, 0) && other.PixelAt(39, 19) == surface.PixelAt(39, 19), "Copy");
+}
+
+}
+
+int main() {
+	TestMetrics();
+	TestMeasureWidths();
+	TestDrawing();
+	printf("%s\n", failures ? "FAILED" : "OK");
+	return failures != 0;
+}
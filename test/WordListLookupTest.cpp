@@ -0,0 +1,115 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+#define _CRT_SECURE_NO_WARNINGS
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include "../lexlib/WordList.h"
+#include "TestUtils.h"
+
+// Compares WordList lookups against a naive scan over the same words.
+// Small alphabets with markers inside words produce many words sharing a prefix, so prefixed
+// lookups with '(' go through the hash table and other markers through the sorted fallback search.
+// cl /utf-8 /EHsc /std:c++20 /W4 /I../include /I../lexlib WordListLookupTest.cpp ../lexlib/WordList.cxx
+// clang-cl /utf-8 /EHsc /std:c++20 /W4 /I../include /I../lexlib WordListLookupTest.cpp ../lexlib/WordList.cxx
+// g++ -std=gnu++20 -Wall -Wextra -I../include -I../lexlib WordListLookupTest.cpp ../lexlib/WordList.cxx
+
+using namespace Lexilla;
+
+namespace {
+
+constexpr char alphabet[] = "aab(!#";
+constexpr char markers[] = {'\0', '(', '!', '#', 'b'};
+
+std::string RandomWord(PCG32Random &rng, bool prefix) {
+	std::string word;
+	if (prefix) {
+		word.push_back('^');
+	}
+	// first character is never a marker, as keyword lists and queries start with a word character.
+	word.push_back("ab"[rng.Next() % 2]);
+	const uint32_t length = rng.Next() % 6;
+	for (uint32_t i = 0; i < length; i++) {
+		word.push_back(alphabet[rng.Next() % (std::size(alphabet) - 1)]);
+	}
+	return word;
+}
+
+bool NaiveInList(const std::vector<std::string> &words, const std::string &s) {
+	for (const std::string &word : words) {
+		if (word == s) {
+			return true;
+		}
+		if (word[0] == '^' && s.compare(0, word.length() - 1, word, 1) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool NaiveInListPrefixed(const std::vector<std::string> &words, const std::string &s, char marker) {
+	for (const std::string &word : words) {
+		if (word == s) {
+			return true;
+		}
+		if (marker && word.length() > s.length() && word[s.length()] == marker && word.compare(0, s.length(), s) == 0) {
+			return true;
+		}
+		if (word[0] == '^' && s.compare(0, word.length() - 1, word, 1) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+}
+
+int main() {
+	PCG32Random rng{0x853c49e6748fea9bULL, 0xda3e39cb94b95bdbULL};
+	unsigned failures = 0;
+	unsigned checks = 0;
+	for (int round = 0; round < 2000; round++) {
+		std::vector<std::string> words;
+		const uint32_t count = 1 + rng.Next() % 64;
+		for (uint32_t i = 0; i < count; i++) {
+			words.push_back(RandomWord(rng, rng.Next() % 16 == 0));
+		}
+		std::string list;
+		for (const std::string &word : words) {
+			list += word;
+			list += ' ';
+		}
+		WordList wordList;
+		if (!wordList.Set(list.c_str())) {
+			printf("Set failed: %s\n", list.c_str());
+			return 1;
+		}
+		for (int i = 0; i < 200; i++) {
+			const std::string s = (i & 1) ? words[rng.Next() % count] : RandomWord(rng, false);
+			std::string query = s;
+			if (query[0] == '^') {
+				query.erase(0, 1);
+			}
+			// cut at a random position to look up prefixes of listed words.
+			query.resize(1 + rng.Next() % query.length());
+			++checks;
+			if (wordList.InList(query.c_str()) != NaiveInList(words, query)) {
+				++failures;
+				printf("InList(\"%s\") in [%s]\n", query.c_str(), list.c_str());
+			}
+			for (const char marker : markers) {
+				++checks;
+				if (wordList.InListPrefixed(query.c_str(), marker) != NaiveInListPrefixed(words, query, marker)) {
+					++failures;
+					printf("InListPrefixed(\"%s\", '%c') in [%s]\n", query.c_str(), marker ? marker : '0', list.c_str());
+				}
+			}
+		}
+	}
+	printf("%u checks, %u failures\n", checks, failures);
+	return failures != 0;
+}
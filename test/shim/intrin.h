@@ -0,0 +1,65 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+// MSVC intrinsics used by VectorISA.h, for building tests with GCC and Clang on other platforms.
+#pragma once
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// long is 32 bits on Windows, so bit strings are indexed as 32 bit words.
+
+inline unsigned char _BitScanForward(unsigned long *index, unsigned long mask) noexcept {
+	if (mask == 0) {
+		*index = 0;
+		return 0;
+	}
+	*index = __builtin_ctzl(mask);
+	return 1;
+}
+
+inline unsigned char _BitScanForward64(unsigned long *index, unsigned long long mask) noexcept {
+	if (mask == 0) {
+		*index = 0;
+		return 0;
+	}
+	*index = __builtin_ctzll(mask);
+	return 1;
+}
+
+inline unsigned char _BitScanReverse(unsigned long *index, unsigned long mask) noexcept {
+	if (mask == 0) {
+		*index = 0;
+		return 0;
+	}
+	*index = (sizeof(long)*8 - 1) ^ __builtin_clzl(mask);
+	return 1;
+}
+
+inline unsigned char _BitScanReverse64(unsigned long *index, unsigned long long mask) noexcept {
+	if (mask == 0) {
+		*index = 0;
+		return 0;
+	}
+	*index = 63 ^ __builtin_clzll(mask);
+	return 1;
+}
+
+inline unsigned char _bittest(const long *base, long offset) noexcept {
+	const unsigned int *word = reinterpret_cast<const unsigned int *>(base) + (offset >> 5);
+	return (*word >> (offset & 31)) & 1;
+}
+
+inline unsigned char _bittestandset(long *base, long offset) noexcept {
+	unsigned int *word = reinterpret_cast<unsigned int *>(base) + (offset >> 5);
+	const unsigned char bit = (*word >> (offset & 31)) & 1;
+	*word |= 1U << (offset & 31);
+	return bit;
+}
+
+inline unsigned char _bittestandreset(long *base, long offset) noexcept {
+	unsigned int *word = reinterpret_cast<unsigned int *>(base) + (offset >> 5);
+	const unsigned char bit = (*word >> (offset & 31)) & 1;
+	*word &= ~(1U << (offset & 31));
+	return bit;
+}
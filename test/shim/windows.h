@@ -0,0 +1,141 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+// Win32 functions used by the sources tests link, for building them on other platforms.
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+#include <thread>
+#include <shared_mutex>
+#include <vector>
+#include <algorithm>
+
+#define VOID void
+#define CALLBACK
+#define TRUE	1
+#define FALSE	0
+#define WAIT_OBJECT_0	0
+#define WAIT_TIMEOUT	258
+
+using BOOL = int;
+using UINT = unsigned int;
+using DWORD = uint32_t;
+using PVOID = void *;
+using HANDLE = void *;
+
+union LARGE_INTEGER {
+	int64_t QuadPart;
+};
+
+struct SYSTEM_INFO {
+	DWORD dwNumberOfProcessors;
+};
+
+inline void GetNativeSystemInfo(SYSTEM_INFO *info) noexcept {
+	info->dwNumberOfProcessors = std::max(std::thread::hardware_concurrency(), 1U);
+}
+
+// slim reader/writer lock
+struct SRWLOCK {
+	std::shared_mutex mutex;
+};
+#define SRWLOCK_INIT	{}
+
+inline void AcquireSRWLockExclusive(SRWLOCK *lock) noexcept {
+	lock->mutex.lock();
+}
+inline void ReleaseSRWLockExclusive(SRWLOCK *lock) noexcept {
+	lock->mutex.unlock();
+}
+inline void AcquireSRWLockShared(SRWLOCK *lock) noexcept {
+	lock->mutex.lock_shared();
+}
+inline void ReleaseSRWLockShared(SRWLOCK *lock) noexcept {
+	lock->mutex.unlock_shared();
+}
+
+// waitable timer, the only kind of handle used
+struct WaitableTimer {
+	std::chrono::steady_clock::time_point due;
+};
+
+inline HANDLE CreateWaitableTimer(void * /*attributes*/, BOOL /*manualReset*/, const void * /*name*/) {
+	return new WaitableTimer{std::chrono::steady_clock::now()};
+}
+
+// negative due time is relative in 100 nanosecond units
+inline BOOL SetWaitableTimer(HANDLE timer, const LARGE_INTEGER *dueTime, long /*period*/, void * /*completion*/, void * /*arg*/, BOOL /*resume*/) noexcept {
+	const auto delay = std::chrono::duration<int64_t, std::ratio<1, 10'000'000>>(-dueTime->QuadPart);
+	static_cast<WaitableTimer *>(timer)->due = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay);
+	return TRUE;
+}
+
+inline DWORD WaitForSingleObject(HANDLE timer, DWORD /*milliseconds*/) noexcept {
+	return (std::chrono::steady_clock::now() >= static_cast<WaitableTimer *>(timer)->due) ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
+}
+
+inline BOOL CloseHandle(HANDLE timer) noexcept {
+	delete static_cast<WaitableTimer *>(timer);
+	return TRUE;
+}
+
+// thread pool work, each submission runs on its own thread
+struct TP_WORK;
+using PTP_WORK = TP_WORK *;
+using PTP_CALLBACK_INSTANCE = void *;
+using PTP_WORK_CALLBACK = void (*)(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work);
+
+struct TP_WORK {
+	PTP_WORK_CALLBACK callback;
+	PVOID context;
+	std::vector<std::thread> threads;
+};
+
+inline PTP_WORK CreateThreadpoolWork(PTP_WORK_CALLBACK callback, PVOID context, void * /*environment*/) {
+	return new TP_WORK{callback, context, {}};
+}
+
+inline void SubmitThreadpoolWork(PTP_WORK work) {
+	work->threads.emplace_back(work->callback, nullptr, work->context, work);
+}
+
+inline void WaitForThreadpoolWorkCallbacks(PTP_WORK work, BOOL /*cancelPending*/) {
+	for (std::thread &thread : work->threads) {
+		thread.join();
+	}
+	work->threads.clear();
+}
+
+inline void CloseThreadpoolWork(PTP_WORK work) noexcept {
+	delete work;
+}
+
+// only code page 65001 is converted, other code pages report invalid characters.
+inline int MultiByteToWideChar(UINT codePage, DWORD /*flags*/, const char *mbs, int mbLen, wchar_t *wcs, int wcLen) noexcept {
+	if (codePage != 65001) {
+		return 0;
+	}
+	int count = 0;
+	const unsigned char *s = reinterpret_cast<const unsigned char *>(mbs);
+	const unsigned char * const end = s + mbLen;
+	while (s < end) {
+		const unsigned char lead = *s;
+		const int width = (lead < 0x80) ? 1 : (lead < 0xE0) ? 2 : (lead < 0xF0) ? 3 : 4;
+		if (width > end - s) {
+			return 0;
+		}
+		uint32_t ch = (width == 1) ? lead : (lead & (0x7F >> width));
+		for (int i = 1; i < width; i++) {
+			ch = (ch << 6) | (s[i] & 0x3F);
+		}
+		s += width;
+		if (wcs) {
+			if (count >= wcLen) {
+				return 0;
+			}
+			wcs[count] = static_cast<wchar_t>(ch);
+		}
+		count++;
+	}
+	return count;
+}
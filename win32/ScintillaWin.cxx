@@ -754,6 +754,7 @@ class ScintillaWin final :
 	void HideCursorIfPreferred() noexcept;
 	void UpdateBaseElements() noexcept override;
 	bool SCICALL PaintContains(PRectangle rc) const noexcept override;
+	bool SCICALL PaintIntersects(PRectangle rc) const noexcept override;
 	void ScrollText(Sci::Line linesToMove) override;
 	void NotifyCaretMove() const noexcept override;
 	void UpdateSystemCaret() override;
@@ -2888,6 +2889,14 @@ bool ScintillaWin::PaintContains(PRectangle rc) const noexcept {
 	return true;
 }
 
+bool ScintillaWin::PaintIntersects(PRectangle rc) const noexcept {
+	if (paintState == PaintState::painting && hRgnUpdate && !paintingAllText) {
+		const RECT rcw = RectFromPRectangleEx(rc);
+		return ::RectInRegion(hRgnUpdate, &rcw);
+	}
+	return true;
+}
+
 void ScintillaWin::ScrollText(Sci::Line /* linesToMove */) {
 	//Platform::DebugPrintf("ScintillaWin::ScrollText %d\n", linesToMove);
 	//::ScrollWindow(MainHWND(), 0,